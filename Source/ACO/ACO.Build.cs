@@ -7,5 +7,6 @@ public class ACO : ModuleRules
 	public ACO(TargetInfo Target)
 	{
 		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "HeadMountedDisplay" });
+		PrivateDependencyModuleNames.AddRange(new string[] { "ImageWrapper" });
 	}
 }
@@ -0,0 +1,44 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ACO.h"
+#include "ACOBatchCommandlet.h"
+#include "ACOBatchRunner.h"
+
+UACOBatchCommandlet::UACOBatchCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UACOBatchCommandlet::Main(const FString& Params)
+{
+	//the specification file uses the same syntax as the command line with a dash before every switch, lines starting with ; are comments
+	FString specification = Params;
+	FString specificationFile;
+	if (FParse::Value(*Params, TEXT("-Spec="), specificationFile))
+	{
+		TArray<FString> lines;
+		if (!FFileHelper::LoadANSITextFileToStrings(*specificationFile, nullptr, lines))
+		{
+			UE_LOG(LogACO, Error, TEXT("Couldn't read sweep specification %s!"), *specificationFile);
+			return 1;
+		}
+		for (const auto& line : lines)
+		{
+			if (!line.StartsWith(TEXT(";")))
+				specification += TEXT(" ") + line;
+		}
+	}
+
+	ACOBatchRunner runner;
+	if (!runner.ParseSpecification(specification))
+		return 1;
+
+	runner.Run();
+
+	FString output = FPaths::GameSavedDir() / TEXT("ACO/BatchResults.csv");
+	FParse::Value(*Params, TEXT("-Output="), output);
+	return runner.WriteResults(output) ? 0 : 1;
+}
@@ -0,0 +1,21 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+#include "ACOBatchCommandlet.generated.h"
+
+/**
+ * Headless parameter sweep, see ACOBatchRunner for the specification syntax.
+ * UE4Editor-Cmd.exe ACO.uproject -run=ACOBatch -Spec=Sweep.txt -Output=Results.csv
+ */
+UCLASS()
+class UACOBatchCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UACOBatchCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
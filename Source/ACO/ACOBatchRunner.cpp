@@ -0,0 +1,473 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ACO.h"
+#include "ACOBatchRunner.h"
+#include "ACOMapImporter.h"
+#include "Async/ParallelFor.h"
+
+ACOBatchRunner::ACOBatchRunner() : m_iterations(1000), m_stepKernel(ACOParameters().StepKernel), m_usefulRouteFactor(1.5f)
+{
+}
+
+bool ACOBatchRunner::ParseSpecification(const FString& specification)
+{
+	const ACOParameters defaults;
+	bool valid = parseDimension(specification, TEXT("-Alpha="), FString::SanitizeFloat(defaults.TraversePhaseConstantA), m_alpha);
+	valid &= parseDimension(specification, TEXT("-Beta="), FString::SanitizeFloat(defaults.TraversePhaseConstantB), m_beta);
+	valid &= parseDimension(specification, TEXT("-Rho="), FString::SanitizeFloat(defaults.EvaporationCoefficentP), m_rho);
+	valid &= parseDimension(specification, TEXT("-Ants="), FString::FromInt(defaults.AntAmount), m_ants);
+	valid &= parseDimension(specification, TEXT("-EraseLoops="), FString::FromInt(defaults.EraseLoops ? 1 : 0), m_eraseLoops);
+	valid &= parseDimension(specification, TEXT("-EventDriven="), FString::FromInt(defaults.EventDriven ? 1 : 0), m_eventDriven);
+
+	FString seeds = TEXT("1");
+	FParse::Value(*specification, TEXT("-Seeds="), seeds, false);
+	TArray<FString> seedValues;
+	seeds.ParseIntoArray(seedValues, TEXT(","), true);
+	m_seeds.Reset();
+	for (const auto& seed : seedValues)
+		m_seeds.Add(FCString::Atoi(*seed));
+
+	FString variants = ACOParameters::GetVariantName(defaults.Variant);
+	FParse::Value(*specification, TEXT("-Variants="), variants, false);
+	TArray<FString> variantNames;
+	variants.ParseIntoArray(variantNames, TEXT(","), true);
+	m_variants.Reset();
+	for (const auto& name : variantNames)
+	{
+		EACOVariant variant;
+		if (!ACOParameters::ParseVariant(name, variant))
+		{
+			UE_LOG(LogACO, Error, TEXT("Unknown ACO variant %s"), *name);
+			valid = false;
+		}
+		m_variants.Add(variant);
+	}
+
+	FString maps = TEXT("64x64");
+	FParse::Value(*specification, TEXT("-Maps="), maps, false);
+	FString legendFilename;
+	ACOMapLegend legend;
+	if (FParse::Value(*specification, TEXT("-Legend="), legendFilename))
+		valid &= legend.Load(legendFilename);
+	FString cellOrderName = TEXT("Hilbert");
+	EACOSpaceFillingCurve cellOrder = EACOSpaceFillingCurve::Hilbert;
+	FParse::Value(*specification, TEXT("-CellOrder="), cellOrderName);
+	if (!ACOSpatialPartition::ParseCurve(cellOrderName, cellOrder))
+	{
+		UE_LOG(LogACO, Error, TEXT("Unknown cell order %s"), *cellOrderName);
+		valid = false;
+	}
+	valid = valid && parseMaps(maps, legend, cellOrder);
+	FString stepKernel;
+	m_stepKernel = defaults.StepKernel;
+	if (FParse::Value(*specification, TEXT("-StepKernel="), stepKernel) && !ACOParameters::ParseStepKernel(stepKernel, m_stepKernel))
+	{
+		UE_LOG(LogACO, Error, TEXT("Unknown step kernel %s"), *stepKernel);
+		valid = false;
+	}
+	FString pheromoneStorages = ACOParameters::GetPheromoneStorageName(defaults.PheromoneStorage);
+	FParse::Value(*specification, TEXT("-PheromoneStorages="), pheromoneStorages, false);
+	TArray<FString> pheromoneStorageNames;
+	pheromoneStorages.ParseIntoArray(pheromoneStorageNames, TEXT(","), true);
+	m_pheromoneStorages.Reset();
+	for (const auto& name : pheromoneStorageNames)
+	{
+		EACOPheromoneStorage pheromoneStorage;
+		if (!ACOParameters::ParsePheromoneStorage(name, pheromoneStorage))
+		{
+			UE_LOG(LogACO, Error, TEXT("Unknown pheromone storage %s"), *name);
+			valid = false;
+		}
+		m_pheromoneStorages.Add(pheromoneStorage);
+	}
+
+	valid &= parseDimension(specification, TEXT("-MultiLevel="), TEXT("0"), m_multiLevel);
+	valid &= m_multiLevelSettings.Parse(*specification);
+	FParse::Value(*specification, TEXT("-UsefulRouteFactor="), m_usefulRouteFactor);
+
+	FParse::Value(*specification, TEXT("-Iterations="), m_iterations);
+	valid &= m_convergenceCriteria.Parse(*specification);
+	ACOTrace::EnableFromCommandLine(*specification);
+
+	FString mode = TEXT("Grid");
+	int32 steps = 3;
+	int32 samples = 16;
+	FParse::Value(*specification, TEXT("-Mode="), mode);
+	FParse::Value(*specification, TEXT("-Steps="), steps);
+	FParse::Value(*specification, TEXT("-Samples="), samples);
+
+	if (!valid || m_seeds.Num() == 0 || m_variants.Num() == 0 || m_pheromoneStorages.Num() == 0 || m_iterations <= 0 || m_usefulRouteFactor < 1.f)
+	{
+		UE_LOG(LogACO, Error, TEXT("Invalid sweep specification: %s"), *specification);
+		return false;
+	}
+
+	createJobs(FMath::Max(steps, 1), FMath::Max(samples, 1), mode == TEXT("Random"));
+	UE_LOG(LogACO, Log, TEXT("Sweep with %d colonies on %d maps created!"), m_jobs.Num(), m_maps.Num());
+	return m_jobs.Num() > 0;
+}
+
+void ACOBatchRunner::Run()
+{
+	m_results.SetNum(m_jobs.Num());
+	FThreadSafeCounter finishedJobs;
+	const double startTime = FPlatformTime::Seconds();
+
+	//every job is an independent colony, the maps are only read
+	ParallelFor(m_jobs.Num(), [this, &finishedJobs](int32 index)
+	{
+		m_results[index] = runJob(m_jobs[index], index);
+		UE_LOG(LogACO, Log, TEXT("Colony %d/%d finished after %.2fs"), finishedJobs.Increment(), m_jobs.Num(), m_results[index].Seconds);
+	});
+
+	UE_LOG(LogACO, Log, TEXT("Sweep with %d colonies finished after %.2fs"), m_jobs.Num(), FPlatformTime::Seconds() - startTime);
+	logStorageAccuracy();
+	logMultiLevelSpeedup();
+	if (ACOTrace::IsEnabled())
+		ACOTrace::Flush();
+}
+
+bool ACOBatchRunner::WriteResults(const FString& filename) const
+{
+	FString table = TEXT("Map,Seed,Variant,Alpha,Beta,Rho,Ants,EraseLoops,EventDriven,PheromoneStorage,MultiLevel,Iterations,ConvergenceIteration,IterationsToConverge,BestPathCost,BestPathLength,OptimalPathCost,MeanTripCost,RouteEntropy,FirstRouteIteration,FirstRouteSeconds,Seconds,AntStepsPerSecond\n");
+	for (const auto& result : m_results)
+	{
+		const ACOParameters& parameters = result.Job.Parameters;
+		table += FString::Printf(TEXT("%s,%d,%s,%g,%g,%g,%d,%d,%d,%s,%d,%d,%d,%d,%g,%d,%g,%g,%.3f,%d,%.3f,%.3f,%.0f\n"), *m_mapNames[result.Job.MapIndex], parameters.Seed,
+			ACOParameters::GetVariantName(parameters.Variant), parameters.TraversePhaseConstantA, parameters.TraversePhaseConstantB, parameters.EvaporationCoefficentP, parameters.AntAmount, parameters.EraseLoops ? 1 : 0, parameters.EventDriven ? 1 : 0,
+			ACOParameters::GetPheromoneStorageName(parameters.PheromoneStorage), result.Job.IsMultiLevel ? 1 : 0, result.Iterations, result.ConvergenceIteration, result.IterationsToConverge, result.BestPathLength > 0 ? result.BestPathCost : -1.f, result.BestPathLength,
+			result.OptimalPathCost < MAX_FLT ? result.OptimalPathCost : -1.f, result.MeanTripCost, result.RouteEntropy, result.FirstRouteIteration, result.FirstRouteIteration > 0 ? result.FirstRouteSeconds : -1.0,
+			result.Seconds, result.Seconds > 0 ? result.AntSteps / result.Seconds : 0.0);
+	}
+
+	if (!FFileHelper::SaveStringToFile(table, *filename))
+	{
+		UE_LOG(LogACO, Error, TEXT("Couldn't write sweep results to %s!"), *filename);
+		return false;
+	}
+	UE_LOG(LogACO, Log, TEXT("Sweep results written to %s"), *filename);
+	return true;
+}
+
+bool ACOBatchRunner::parseDimension(const FString& specification, const TCHAR* key, const FString& defaultValue, SweepDimension& dimension)
+{
+	FString value = defaultValue;
+	FParse::Value(*specification, key, value, false);
+
+	FString left, right;
+	dimension.Values.Reset();
+	dimension.isRange = value.Split(TEXT(":"), &left, &right);
+	if (dimension.isRange)
+	{
+		dimension.Values.Add(FCString::Atof(*left));
+		dimension.Values.Add(FCString::Atof(*right));
+	}
+	else
+	{
+		TArray<FString> values;
+		value.ParseIntoArray(values, TEXT(","), true);
+		for (const auto& a : values)
+			dimension.Values.Add(FCString::Atof(*a));
+	}
+
+	if (dimension.Values.Num() == 0)
+	{
+		UE_LOG(LogACO, Error, TEXT("No values for %s"), key);
+		return false;
+	}
+	return true;
+}
+
+bool ACOBatchRunner::parseMaps(const FString& maps, const ACOMapLegend& legend, EACOSpaceFillingCurve cellOrder)
+{
+	TArray<FString> mapValues;
+	maps.ParseIntoArray(mapValues, TEXT(","), true);
+	for (const auto& map : mapValues)
+	{
+		ACOGrid grid;
+		const FString extension = FPaths::GetExtension(map);
+		if (extension == TEXT("csv") || extension == TEXT("png"))
+		{
+			if (!ACOMapImporter::Import(map, legend, grid))
+				return false;
+		}
+		else
+		{
+			//<columns>x<rows>[@seed]
+			FString size = map, seed = TEXT("1"), columns, rows;
+			map.Split(TEXT("@"), &size, &seed);
+			if (!size.Split(TEXT("x"), &columns, &rows) || FCString::Atoi(*columns) <= 0 || FCString::Atoi(*rows) <= 0)
+			{
+				UE_LOG(LogACO, Error, TEXT("Invalid map %s, expected <columns>x<rows>[@seed], <file>.csv or <file>.png"), *map);
+				return false;
+			}
+			grid = ACOGrid::CreateGenerated(FIntPoint(FCString::Atoi(*columns), FCString::Atoi(*rows)), FCString::Atoi(*seed));
+		}
+		if (grid.Anthills.Num() == 0 || grid.FoodSources.Num() == 0)
+		{
+			UE_LOG(LogACO, Error, TEXT("Map %s has no anthill or food source!"), *map);
+			return false;
+		}
+		//a job is one colony, the other anthills would be ignored silently
+		if (grid.Anthills.Num() > 1)
+		{
+			UE_LOG(LogACO, Error, TEXT("Map %s has %d anthills, a sweep runs one colony per map and needs exactly one!"), *map, grid.Anthills.Num());
+			return false;
+		}
+		if (cellOrder != EACOSpaceFillingCurve::None)
+			grid.RenumberCells(ACOSpatialPartition::GetCurveOrder(grid, cellOrder));
+		m_maps.Add(MoveTemp(grid));
+		m_mapNames.Add(map);
+	}
+	return m_maps.Num() > 0;
+}
+
+void ACOBatchRunner::createJobs(int32 steps, int32 samples, bool randomSearch)
+{
+	m_jobs.Reset();
+	TArray<ACOParameters> parameterSets;
+
+	if (randomSearch)
+	{
+		FRandomStream randomStream(m_seeds[0]);
+		auto draw = [&randomStream](const SweepDimension& dimension)
+		{
+			if (dimension.isRange)
+				return randomStream.FRandRange(dimension.Values[0], dimension.Values[1]);
+			return dimension.Values[randomStream.RandHelper(dimension.Values.Num())];
+		};
+
+		for (int i = 0; i < samples; ++i)
+		{
+			ACOParameters parameters;
+			parameters.TraversePhaseConstantA = draw(m_alpha);
+			parameters.TraversePhaseConstantB = draw(m_beta);
+			parameters.EvaporationCoefficentP = draw(m_rho);
+			parameters.AntAmount = FMath::RoundToInt(draw(m_ants));
+			parameters.EraseLoops = draw(m_eraseLoops) >= 0.5f;
+			parameters.EventDriven = draw(m_eventDriven) >= 0.5f;
+			parameters.Variant = m_variants[randomStream.RandHelper(m_variants.Num())];
+			parameterSets.Add(parameters);
+		}
+	}
+	else
+	{
+		auto expand = [steps](const SweepDimension& dimension)
+		{
+			if (!dimension.isRange || steps == 1)
+				return dimension.isRange ? TArray<float>{ dimension.Values[0] } : dimension.Values;
+
+			TArray<float> values;
+			for (int i = 0; i < steps; ++i)
+				values.Add(FMath::Lerp(dimension.Values[0], dimension.Values[1], i / static_cast<float>(steps - 1)));
+			return values;
+		};
+
+		for (EACOVariant variant : m_variants)
+			for (float alpha : expand(m_alpha))
+				for (float beta : expand(m_beta))
+					for (float rho : expand(m_rho))
+						for (float ants : expand(m_ants))
+							for (float eraseLoops : expand(m_eraseLoops))
+								for (float eventDriven : expand(m_eventDriven))
+								{
+									ACOParameters parameters;
+									parameters.Variant = variant;
+									parameters.TraversePhaseConstantA = alpha;
+									parameters.TraversePhaseConstantB = beta;
+									parameters.EvaporationCoefficentP = rho;
+									parameters.AntAmount = FMath::RoundToInt(ants);
+									parameters.EraseLoops = eraseLoops >= 0.5f;
+									parameters.EventDriven = eventDriven >= 0.5f;
+									parameterSets.Add(parameters);
+								}
+	}
+
+	for (int32 mapIndex = 0; mapIndex < m_maps.Num(); ++mapIndex)
+	{
+		for (int32 parameterSet = 0; parameterSet < parameterSets.Num(); ++parameterSet)
+		{
+			for (int32 seed : m_seeds)
+			{
+				for (EACOPheromoneStorage pheromoneStorage : m_pheromoneStorages)
+				{
+					for (float multiLevel : m_multiLevel.Values)
+					{
+						ACOSweepJob job;
+						job.MapIndex = mapIndex;
+						job.ParameterSet = parameterSet;
+						job.Parameters = parameterSets[parameterSet];
+						job.Parameters.Seed = seed;
+						job.Parameters.StepKernel = m_stepKernel;
+						job.Parameters.PheromoneStorage = pheromoneStorage;
+						job.IsMultiLevel = multiLevel >= 0.5f;
+						m_jobs.Add(job);
+					}
+				}
+			}
+		}
+	}
+}
+
+ACOSweepResult ACOBatchRunner::runJob(const ACOSweepJob& job, int32 jobIndex) const
+{
+	const ACOGrid& grid = m_maps[job.MapIndex];
+	ACOPheromoneField pheromoneField(grid.Num(), 1, job.Parameters.PheromoneStorage, job.Parameters.Deterministic);
+	ACOColony colony(grid, pheromoneField, 0, grid.Anthills[0], job.Parameters);
+
+	ACOSweepResult result;
+	result.Job = job;
+	result.Iterations = m_iterations;
+	result.ConvergenceIteration = 0;
+	result.IterationsToConverge = 0;
+	result.BestPathCost = MAX_FLT;
+	result.BestPathLength = 0;
+	result.OptimalPathCost = MAX_FLT;
+	if (const ACODistanceField* distances = grid.GetAnthillDistances(grid.Anthills[0]))
+	{
+		for (int32 foodSource : grid.FoodSources)
+			result.OptimalPathCost = FMath::Min(result.OptimalPathCost, distances->Costs[foodSource]);
+	}
+	result.MeanTripCost = 0.f;
+	result.RouteEntropy = 1.f;
+	result.AntSteps = 0;
+	result.FirstRouteIteration = 0;
+	result.FirstRouteSeconds = 0.0;
+	const float usefulRouteCost = result.OptimalPathCost < MAX_FLT ? result.OptimalPathCost * m_usefulRouteFactor : MAX_FLT;
+
+	ACOConvergenceTracker convergenceTracker(m_convergenceCriteria);
+	const double startTime = FPlatformTime::Seconds();
+	TUniquePtr<ACOMultiLevel> multiLevel;
+	if (job.IsMultiLevel)
+	{
+		multiLevel.Reset(new ACOMultiLevel(grid, TArray<int32>{ grid.Anthills[0] }, job.Parameters, m_multiLevelSettings));
+		multiLevel->Seed(pheromoneField);
+	}
+	for (int32 iteration = 1; iteration <= m_iterations; ++iteration)
+	{
+		ACOIterationTrace trace;
+		ACOTripStatistics statistics = colony.Iterate(ACOTrace::IsEnabled() ? &trace : nullptr);
+		if (ACOTrace::IsEnabled())
+		{
+			trace.Iteration = iteration;
+			trace.Worker = jobIndex;
+			ACOTrace::Add(trace);
+		}
+		result.AntSteps += statistics.AntSteps;
+		if (statistics.BestTripCost < result.BestPathCost)
+		{
+			result.BestPathCost = statistics.BestTripCost;
+			result.BestPathLength = statistics.BestTripLength;
+			result.ConvergenceIteration = iteration;
+		}
+		if (result.FirstRouteIteration == 0 && result.BestPathLength > 0 && result.BestPathCost <= usefulRouteCost)
+		{
+			result.FirstRouteIteration = iteration;
+			result.FirstRouteSeconds = FPlatformTime::Seconds() - startTime;
+		}
+		if (multiLevel)
+			multiLevel->OnIterationFinished(pheromoneField, iteration);
+
+		const ACOConvergenceSample& sample = convergenceTracker.Update(colony);
+		result.MeanTripCost = sample.IterationMeanTripCost;
+		result.RouteEntropy = sample.RouteEntropy;
+		if (convergenceTracker.HasConverged() && m_convergenceCriteria.Action == EACOConvergenceAction::Stop)
+		{
+			result.Iterations = iteration;
+			break;
+		}
+	}
+	result.IterationsToConverge = convergenceTracker.GetConvergenceIteration();
+	result.Seconds = FPlatformTime::Seconds() - startTime;
+	return result;
+}
+
+void ACOBatchRunner::logStorageAccuracy() const
+{
+	if (!m_pheromoneStorages.Contains(EACOPheromoneStorage::Float))
+		return;
+
+	for (EACOPheromoneStorage pheromoneStorage : m_pheromoneStorages)
+	{
+		if (pheromoneStorage == EACOPheromoneStorage::Float)
+			continue;
+
+		//the storages of a colony are next to each other, see createJobs
+		double costDeviation = 0.0;
+		int32 comparisons = 0;
+		//a colony which never converged has no convergence iteration to compare, it is counted instead
+		double convergenceDifference = 0.0;
+		int32 convergenceComparisons = 0;
+		int32 onlyStorageConverged = 0;
+		int32 onlyFloatConverged = 0;
+		for (const auto& result : m_results)
+		{
+			const ACOSweepJob& job = result.Job;
+			if (job.Parameters.PheromoneStorage != pheromoneStorage || result.BestPathLength == 0)
+				continue;
+			const ACOSweepResult* reference = findReference(job, EACOPheromoneStorage::Float, job.IsMultiLevel);
+			if (!reference || reference->BestPathLength == 0)
+				continue;
+			costDeviation += FMath::Abs(result.BestPathCost - reference->BestPathCost) / FMath::Max(reference->BestPathCost, KINDA_SMALL_NUMBER);
+			++comparisons;
+			if (result.IterationsToConverge > 0 && reference->IterationsToConverge > 0)
+			{
+				convergenceDifference += result.IterationsToConverge - reference->IterationsToConverge;
+				++convergenceComparisons;
+			}
+			else
+			{
+				onlyStorageConverged += result.IterationsToConverge > 0 ? 1 : 0;
+				onlyFloatConverged += reference->IterationsToConverge > 0 ? 1 : 0;
+			}
+		}
+		if (comparisons > 0)
+		{
+			const TCHAR* name = ACOParameters::GetPheromoneStorageName(pheromoneStorage);
+			UE_LOG(LogACO, Log, TEXT("%s pheromones: best path cost deviates %.2f%% from Float (%d colonies), converges %+.1f iterations later (%d colonies), only converged with %s %d, only with Float %d"),
+				name, 100.0 * costDeviation / comparisons, comparisons, convergenceComparisons > 0 ? convergenceDifference / convergenceComparisons : 0.0, convergenceComparisons,
+				name, onlyStorageConverged, onlyFloatConverged);
+		}
+	}
+}
+
+void ACOBatchRunner::logMultiLevelSpeedup() const
+{
+	double iterationRatio = 0.0;
+	double secondsRatio = 0.0;
+	int32 comparisons = 0;
+	int32 onlyMultiLevel = 0;
+	int32 onlyPlain = 0;
+	for (const auto& result : m_results)
+	{
+		if (!result.Job.IsMultiLevel)
+			continue;
+		const ACOSweepResult* reference = findReference(result.Job, result.Job.Parameters.PheromoneStorage, false);
+		if (!reference)
+			continue;
+		//a colony which found no useful route at all can't be compared
+		if (result.FirstRouteIteration == 0 || reference->FirstRouteIteration == 0)
+		{
+			onlyMultiLevel += result.FirstRouteIteration > 0 ? 1 : 0;
+			onlyPlain += reference->FirstRouteIteration > 0 ? 1 : 0;
+			continue;
+		}
+		iterationRatio += static_cast<double>(reference->FirstRouteIteration) / result.FirstRouteIteration;
+		secondsRatio += reference->FirstRouteSeconds / FMath::Max(result.FirstRouteSeconds, 1e-6);
+		++comparisons;
+	}
+	if (comparisons > 0 || onlyMultiLevel > 0 || onlyPlain > 0)
+	{
+		UE_LOG(LogACO, Log, TEXT("Multi-level: first useful route %.2fx fewer iterations, %.2fx faster (%d colonies), only found with multi-level %d, only without %d"),
+			comparisons > 0 ? iterationRatio / comparisons : 0.0, comparisons > 0 ? secondsRatio / comparisons : 0.0, comparisons, onlyMultiLevel, onlyPlain);
+	}
+}
+
+const ACOSweepResult* ACOBatchRunner::findReference(const ACOSweepJob& job, EACOPheromoneStorage pheromoneStorage, bool isMultiLevel) const
+{
+	return m_results.FindByPredicate([&job, pheromoneStorage, isMultiLevel](const ACOSweepResult& other)
+	{
+		return other.Job.MapIndex == job.MapIndex && other.Job.ParameterSet == job.ParameterSet && other.Job.Parameters.Seed == job.Parameters.Seed
+			&& other.Job.Parameters.PheromoneStorage == pheromoneStorage && other.Job.IsMultiLevel == isMultiLevel;
+	});
+}
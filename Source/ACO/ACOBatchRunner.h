@@ -0,0 +1,115 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "ACOConvergence.h"
+#include "ACOSpatialPartition.h"
+#include "ACOMultiLevel.h"
+
+/** one colony of a parameter sweep */
+struct ACOSweepJob
+{
+	int32 MapIndex;
+	/** jobs with the same map, parameter set and seed only differ in the pheromone storage */
+	int32 ParameterSet;
+	ACOParameters Parameters;
+	/** the pheromones are seeded by ACOMultiLevel before the first iteration */
+	bool IsMultiLevel;
+};
+
+struct ACOSweepResult
+{
+	ACOSweepJob Job;
+	/** executed iterations, less than requested if the colony stopped on convergence */
+	int32 Iterations;
+	/** last iteration which improved the best path */
+	int32 ConvergenceIteration;
+	/** iteration the convergence criteria were met, 0 if never */
+	int32 IterationsToConverge;
+	float BestPathCost;
+	int32 BestPathLength;
+	/** cheapest anthill to food source trip of the map, see ACODistanceField */
+	float OptimalPathCost;
+	/** of the last iteration */
+	float MeanTripCost;
+	float RouteEntropy;
+	int64 AntSteps;
+	/** first iteration whose best trip costs at most UsefulRouteFactor * OptimalPathCost, 0 if never */
+	int32 FirstRouteIteration;
+	/** seconds until the first useful route, including the coarse run of a multi-level job */
+	double FirstRouteSeconds;
+	double Seconds;
+};
+
+/**
+ * Runs many independent colonies of a parameter sweep concurrently, all colonies of a map share one ACOGrid.
+ *
+ * The specification uses the command line syntax including the dashes, -Ants= would find -ACOCoarseAnts= otherwise.
+ * Every dimension is a list "1,2,5" or a range "1:5":
+ * -Alpha=1:5 -Beta=9 -Rho=0.01,0.05 -Ants=1000,5000 -Seeds=1,2,3 -Maps=64x64,256x256@7 -Iterations=1000
+ * -Variants=AntSystem,AntColonySystem,MaxMin,RankBased -EraseLoops=0,1 -EventDriven=0,1
+ * Maps are generated (<columns>x<rows>[@seed]) or imported by ACOMapImporter (<file>.csv / <file>.png, optional -Legend=<file>).
+ * Every job runs one colony, so maps with more than one anthill are rejected.
+ * -Mode=Grid expands ranges into -Steps values (default 3), -Mode=Random draws -Samples parameter sets.
+ * The convergence is detected with ACOConvergenceCriteria, -OnConvergence=Stop ends a colony before -Iterations.
+ * -CellOrder=Hilbert|Morton|None renumbers the cells of every map along a space-filling curve (default Hilbert).
+ * -StepKernel=PerAnt|ScalarLanes|VectorLanes moves the ants of every colony with the kernel, the results don't depend on it.
+ * -PheromoneStorages=Float,Half,Log16 runs every colony with each storage, the compact ones are compared to Float after the sweep.
+ * -MultiLevel=0,1 runs every colony with and without ACOMultiLevel (-ACOCoarseFactor=8 ...), the time to the first route within
+ * -UsefulRouteFactor=1.5 times the optimal one is compared after the sweep.
+ * -ACOTrace=<file>.csv exports the phase timings of every job and iteration, the job index is the worker column.
+ */
+class ACO_API ACOBatchRunner
+{
+public:
+	ACOBatchRunner();
+
+	bool ParseSpecification(const FString& specification);
+	void Run();
+	bool WriteResults(const FString& filename) const;
+
+	const TArray<ACOSweepResult>& GetResults() const { return m_results; }
+	int32 GetJobAmount() const { return m_jobs.Num(); }
+
+protected:
+	struct SweepDimension
+	{
+		TArray<float> Values;
+		bool isRange = false;
+	};
+
+	static bool parseDimension(const FString& specification, const TCHAR* key, const FString& defaultValue, SweepDimension& dimension);
+	bool parseMaps(const FString& maps, const struct ACOMapLegend& legend, EACOSpaceFillingCurve cellOrder);
+	void createJobs(int32 steps, int32 samples, bool randomSearch);
+	ACOSweepResult runJob(const ACOSweepJob& job, int32 jobIndex) const;
+	/** deviation of the compact pheromone storages from the Float jobs */
+	void logStorageAccuracy() const;
+	/** time to the first useful route of the multi-level jobs compared to the plain ones */
+	void logMultiLevelSpeedup() const;
+	/** the job of the same colony with the other storage or multi-level setting */
+	const ACOSweepResult* findReference(const ACOSweepJob& job, EACOPheromoneStorage pheromoneStorage, bool isMultiLevel) const;
+
+	SweepDimension m_alpha;
+	SweepDimension m_beta;
+	SweepDimension m_rho;
+	SweepDimension m_ants;
+	/** 0 or 1, see ACOParameters::EraseLoops */
+	SweepDimension m_eraseLoops;
+	/** 0 or 1, see ACOParameters::EventDriven */
+	SweepDimension m_eventDriven;
+	TArray<int32> m_seeds;
+	TArray<EACOVariant> m_variants;
+	int32 m_iterations;
+	EACOStepKernel m_stepKernel;
+	TArray<EACOPheromoneStorage> m_pheromoneStorages;
+	/** 0 or 1, see ACOSweepJob::IsMultiLevel */
+	SweepDimension m_multiLevel;
+	ACOMultiLevelSettings m_multiLevelSettings;
+	float m_usefulRouteFactor;
+	ACOConvergenceCriteria m_convergenceCriteria;
+
+	TArray<ACOGrid> m_maps;
+	TArray<FString> m_mapNames;
+	TArray<ACOSweepJob> m_jobs;
+	TArray<ACOSweepResult> m_results;
+};
@@ -0,0 +1,446 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ACO.h"
+#include "ACOBenchmark.h"
+#include "ACOWorker.h"
+#include "Pathfinding.h"
+#include "Async/ParallelFor.h"
+
+namespace
+{
+	/** [X, Y) of the range of the thread, the ranges are contiguous like the ones of ACOWorker */
+	FIntPoint getRange(int32 amount, int32 threads, int32 thread)
+	{
+		return FIntPoint(amount * thread / threads, amount * (thread + 1) / threads);
+	}
+
+	double getMedian(TArray<double>& values)
+	{
+		if (values.Num() == 0)
+			return 0.0;
+		values.Sort();
+		return values.Num() % 2 == 1 ? values[values.Num() / 2] : 0.5 * (values[values.Num() / 2 - 1] + values[values.Num() / 2]);
+	}
+
+	/** items per second, a phase can be faster than the timer resolution on a small map */
+	double getThroughput(double items, double seconds)
+	{
+		return items / FMath::Max(seconds, 1e-9);
+	}
+}
+
+ACOBenchmark::ACOBenchmark() : m_ants(10000), m_isStrongScaling(true), m_isWeakScaling(true), m_weakCells(250000), m_weakAnts(2500), m_repetitions(5), m_warmup(10), m_poolIterations(10)
+{
+	for (float& tolerance : m_tolerances)
+		tolerance = 0.1f;
+	for (bool& isSelected : m_isSelected)
+		isSelected = true;
+}
+
+const TCHAR* ACOBenchmark::GetBenchmarkName(EACOBenchmark benchmark)
+{
+	switch (benchmark)
+	{
+	case EACOBenchmark::Transition: return TEXT("Transition");
+	case EACOBenchmark::Deposit: return TEXT("Deposit");
+	case EACOBenchmark::Evaporation: return TEXT("Evaporation");
+	case EACOBenchmark::AStar: return TEXT("AStar");
+	case EACOBenchmark::Iteration: return TEXT("Iteration");
+	case EACOBenchmark::WorkerPool: return TEXT("WorkerPool");
+	default:
+		return TEXT("Unknown");
+	}
+}
+
+bool ACOBenchmark::ParseBenchmark(const FString& name, EACOBenchmark& benchmark)
+{
+	for (int32 i = 0; i < static_cast<int32>(EACOBenchmark::Num); ++i)
+	{
+		if (name == GetBenchmarkName(static_cast<EACOBenchmark>(i)))
+		{
+			benchmark = static_cast<EACOBenchmark>(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+bool ACOBenchmark::Parse(const TCHAR* stream)
+{
+	bool valid = true;
+
+	//<columns>x<rows>, generated like the maps of ACOBatchRunner, from 10k to 4M cells by default
+	FString maps = TEXT("100x100,500x500,2000x2000");
+	FParse::Value(stream, TEXT("-Maps="), maps, false);
+	TArray<FString> mapValues;
+	maps.ParseIntoArray(mapValues, TEXT(","), true);
+	m_mapSizes.Reset();
+	for (const auto& map : mapValues)
+	{
+		FString columns, rows;
+		if (!map.Split(TEXT("x"), &columns, &rows) || FCString::Atoi(*columns) <= 0 || FCString::Atoi(*rows) <= 0)
+		{
+			UE_LOG(LogACO, Error, TEXT("Invalid map %s, expected <columns>x<rows>"), *map);
+			valid = false;
+			continue;
+		}
+		m_mapSizes.Add(FIntPoint(FCString::Atoi(*columns), FCString::Atoi(*rows)));
+	}
+
+	//powers of two up to the cores and the cores themselves
+	const int32 cores = FMath::Max(FPlatformMisc::NumberOfCoresIncludingHyperthreads(), 1);
+	FString threadList;
+	for (int32 threads = 1; threads < cores; threads *= 2)
+		threadList += FString::Printf(TEXT("%d,"), threads);
+	threadList += FString::FromInt(cores);
+	FParse::Value(stream, TEXT("-Threads="), threadList, false);
+	TArray<FString> threadValues;
+	threadList.ParseIntoArray(threadValues, TEXT(","), true);
+	m_threads.Reset();
+	for (const auto& value : threadValues)
+		m_threads.AddUnique(FMath::Max(FCString::Atoi(*value), 1));
+
+	FString scaling = TEXT("Strong,Weak");
+	FParse::Value(stream, TEXT("-Scaling="), scaling, false);
+	m_isStrongScaling = scaling.Contains(TEXT("Strong"));
+	m_isWeakScaling = scaling.Contains(TEXT("Weak"));
+
+	FParse::Value(stream, TEXT("-Ants="), m_ants);
+	FParse::Value(stream, TEXT("-WeakCells="), m_weakCells);
+	FParse::Value(stream, TEXT("-WeakAnts="), m_weakAnts);
+	FParse::Value(stream, TEXT("-Repetitions="), m_repetitions);
+	FParse::Value(stream, TEXT("-Warmup="), m_warmup);
+	FParse::Value(stream, TEXT("-Seed="), m_parameters.Seed);
+	FParse::Value(stream, TEXT("-PoolIterations="), m_poolIterations);
+
+	//all benchmarks by default
+	FString benchmarks;
+	if (FParse::Value(stream, TEXT("-Benchmarks="), benchmarks, false))
+	{
+		TArray<FString> benchmarkNames;
+		benchmarks.ParseIntoArray(benchmarkNames, TEXT(","), true);
+		for (bool& isSelected : m_isSelected)
+			isSelected = false;
+		for (const auto& name : benchmarkNames)
+		{
+			EACOBenchmark benchmark;
+			if (!ParseBenchmark(name, benchmark))
+			{
+				UE_LOG(LogACO, Error, TEXT("Unknown benchmark %s"), *name);
+				valid = false;
+				continue;
+			}
+			m_isSelected[static_cast<int32>(benchmark)] = true;
+		}
+	}
+
+	FString variant;
+	if (FParse::Value(stream, TEXT("-Variant="), variant) && !ACOParameters::ParseVariant(variant, m_parameters.Variant))
+	{
+		UE_LOG(LogACO, Error, TEXT("Unknown ACO variant %s"), *variant);
+		valid = false;
+	}
+	FString stepKernel;
+	if (FParse::Value(stream, TEXT("-StepKernel="), stepKernel) && !ACOParameters::ParseStepKernel(stepKernel, m_parameters.StepKernel))
+	{
+		UE_LOG(LogACO, Error, TEXT("Unknown step kernel %s"), *stepKernel);
+		valid = false;
+	}
+	FString pheromoneStorage;
+	if (FParse::Value(stream, TEXT("-PheromoneStorage="), pheromoneStorage) && !ACOParameters::ParsePheromoneStorage(pheromoneStorage, m_parameters.PheromoneStorage))
+	{
+		UE_LOG(LogACO, Error, TEXT("Unknown pheromone storage %s"), *pheromoneStorage);
+		valid = false;
+	}
+
+	//one tolerance for all benchmarks, -Tolerances=<benchmark>:<tolerance>,... overrides single ones
+	float tolerance = 0.1f;
+	FParse::Value(stream, TEXT("-Tolerance="), tolerance);
+	for (float& benchmarkTolerance : m_tolerances)
+		benchmarkTolerance = tolerance;
+	FString tolerances;
+	FParse::Value(stream, TEXT("-Tolerances="), tolerances, false);
+	TArray<FString> toleranceValues;
+	tolerances.ParseIntoArray(toleranceValues, TEXT(","), true);
+	for (const auto& value : toleranceValues)
+	{
+		FString name, amount;
+		EACOBenchmark benchmark;
+		if (!value.Split(TEXT(":"), &name, &amount) || !ParseBenchmark(name, benchmark))
+		{
+			UE_LOG(LogACO, Error, TEXT("Invalid tolerance %s, expected <benchmark>:<tolerance>"), *value);
+			valid = false;
+			continue;
+		}
+		m_tolerances[static_cast<int32>(benchmark)] = FCString::Atof(*amount);
+	}
+
+	if (!valid || m_threads.Num() == 0 || (m_isStrongScaling && m_mapSizes.Num() == 0) || !(m_isStrongScaling || m_isWeakScaling)
+		|| m_ants <= 0 || m_weakCells <= 0 || m_weakAnts <= 0 || m_repetitions <= 0 || m_warmup < 0 || m_poolIterations <= 0)
+	{
+		UE_LOG(LogACO, Error, TEXT("Invalid benchmark specification: %s"), stream);
+		return false;
+	}
+	return true;
+}
+
+void ACOBenchmark::Run()
+{
+	m_results.Reset();
+	const double startTime = FPlatformTime::Seconds();
+
+	if (m_isStrongScaling)
+	{
+		for (const FIntPoint& size : m_mapSizes)
+		{
+			ACOGrid grid = ACOGrid::CreateGenerated(size, m_parameters.Seed);
+			for (int32 threads : m_threads)
+				measure(grid, m_ants, threads, false);
+		}
+	}
+
+	//the map and the ants grow with the threads, a square map of WeakCells per thread
+	if (m_isWeakScaling)
+	{
+		for (int32 threads : m_threads)
+		{
+			const int32 side = FMath::Max(FMath::RoundToInt(FMath::Sqrt(static_cast<float>(m_weakCells) * threads)), 2);
+			ACOGrid grid = ACOGrid::CreateGenerated(FIntPoint(side, side), m_parameters.Seed);
+			measure(grid, m_weakAnts * threads, threads, true);
+		}
+	}
+
+	computeEfficiencies();
+	UE_LOG(LogACO, Log, TEXT("%d benchmarks finished after %.2fs"), m_results.Num(), FPlatformTime::Seconds() - startTime);
+}
+
+void ACOBenchmark::measure(ACOGrid& grid, int32 ants, int32 threads, bool isWeakScaling)
+{
+	if (grid.Anthills.Num() == 0 || grid.FoodSources.Num() == 0)
+	{
+		UE_LOG(LogACO, Warning, TEXT("Map with %d cells has no anthill or food source, skipped"), grid.Num());
+		return;
+	}
+
+	ACOParameters parameters = m_parameters;
+	parameters.AntAmount = ants;
+	ACOColony colony(grid, grid.Anthills[0], parameters);
+	TArray<FRandomStream> randomStreams;
+	for (int32 thread = 0; thread < threads; ++thread)
+		randomStreams.Add(FRandomStream(parameters.Seed * 7919 + thread));
+	TArray<ACOTripStatistics> statistics;
+	const bool isSingleThreaded = threads == 1;
+
+	//the warm up lets the ants leave the anthill and lays the first trails, so the A* searches run on a marked field
+	TArray<double> throughputs[static_cast<int32>(EACOBenchmark::Num)];
+	const bool isMeasuringPhases = isSelected(EACOBenchmark::Transition) || isSelected(EACOBenchmark::Deposit) || isSelected(EACOBenchmark::Evaporation)
+		|| isSelected(EACOBenchmark::AStar) || isSelected(EACOBenchmark::Iteration);
+	for (int32 repetition = 0; isMeasuringPhases && repetition < m_warmup + m_repetitions; ++repetition)
+	{
+		statistics.Reset();
+		statistics.SetNum(threads);
+		const double traverseTime = FPlatformTime::Seconds();
+		ParallelFor(threads, [&](int32 thread)
+		{
+			const FIntPoint range = getRange(colony.GetAntAmount(), threads, thread);
+			colony.TraverseAnts(range.X, range.Y, randomStreams[thread], statistics[thread]);
+		}, isSingleThreaded);
+		const double markTime = FPlatformTime::Seconds();
+		ParallelFor(threads, [&](int32 thread)
+		{
+			const FIntPoint range = getRange(colony.GetAntAmount(), threads, thread);
+			colony.MarkAnts(range.X, range.Y);
+		}, isSingleThreaded);
+		const double evaporateTime = FPlatformTime::Seconds();
+		ParallelFor(threads, [&](int32 thread)
+		{
+			const FIntPoint range = getRange(grid.Num(), threads, thread);
+			colony.EvaporateCells(range.X, range.Y);
+		}, isSingleThreaded);
+		const double finishTime = FPlatformTime::Seconds();
+		colony.FinishIteration();
+		const double endTime = FPlatformTime::Seconds();
+		if (repetition < m_warmup)
+			continue;
+
+		int64 antSteps = 0;
+		for (const auto& threadStatistics : statistics)
+			antSteps += threadStatistics.AntSteps;
+		throughputs[static_cast<int32>(EACOBenchmark::Transition)].Add(getThroughput(antSteps, markTime - traverseTime));
+		throughputs[static_cast<int32>(EACOBenchmark::Deposit)].Add(getThroughput(colony.GetAntAmount(), evaporateTime - markTime));
+		throughputs[static_cast<int32>(EACOBenchmark::Evaporation)].Add(getThroughput(grid.Num(), finishTime - evaporateTime));
+		throughputs[static_cast<int32>(EACOBenchmark::Iteration)].Add(getThroughput(antSteps, endTime - traverseTime));
+	}
+
+	//one independent search per thread, the field is only read
+	for (int32 repetition = 0; isSelected(EACOBenchmark::AStar) && repetition < m_repetitions; ++repetition)
+	{
+		const double searchTime = FPlatformTime::Seconds();
+		ParallelFor(threads, [&](int32 thread)
+		{
+			std::unordered_map<int32, int32> came_from;
+			Pathfinding::AStarSearch(grid, colony.GetPheromoneField(), colony.GetChannel(), colony.GetAnthill(), grid.FoodSources[thread % grid.FoodSources.Num()], came_from);
+		}, isSingleThreaded);
+		throughputs[static_cast<int32>(EACOBenchmark::AStar)].Add(getThroughput(threads, FPlatformTime::Seconds() - searchTime));
+	}
+
+	if (isSelected(EACOBenchmark::WorkerPool))
+		measureWorkerPool(grid, ants, threads, throughputs[static_cast<int32>(EACOBenchmark::WorkerPool)]);
+
+	for (int32 i = 0; i < static_cast<int32>(EACOBenchmark::Num); ++i)
+	{
+		if (!m_isSelected[i])
+			continue;
+		ACOBenchmarkResult result;
+		result.Benchmark = static_cast<EACOBenchmark>(i);
+		result.IsWeakScaling = isWeakScaling;
+		result.Cells = grid.Num();
+		result.Ants = ants;
+		result.Threads = threads;
+		result.Throughput = getMedian(throughputs[i]);
+		result.Efficiency = 0.0;
+		m_results.Add(result);
+		UE_LOG(LogACO, Log, TEXT("%s %s scaling, %d cells, %d ants, %d threads: %.0f/s"), GetBenchmarkName(result.Benchmark), isWeakScaling ? TEXT("weak") : TEXT("strong"),
+			result.Cells, ants, threads, result.Throughput);
+	}
+}
+
+void ACOBenchmark::measureWorkerPool(ACOGrid& grid, int32 ants, int32 threads, TArray<double>& throughputs) const
+{
+	ACOParameters parameters = m_parameters;
+	parameters.AntAmount = ants;
+	ACOPheromoneField pheromoneField(grid.Num(), 1, parameters.PheromoneStorage, parameters.Deterministic);
+	ACOColony colony(grid, pheromoneField, 0, grid.Anthills[0], parameters);
+	TArray<ACOColony*> colonies;
+	colonies.Add(&colony);
+
+	//the best paths are kept up to date like in the game, the grid has no hexagons to highlight
+	const bool isShowingBestPath = ACOWorker::IsShowingBestPath();
+	ACOWorker::SetShowBestPath(true);
+	ACOWorker::SetIterationCounter(0);
+	TArray<TUniquePtr<ACOWorker>> workers;
+	for (int32 thread = 0; thread < threads; ++thread)
+	{
+		TArray<FIntPoint> cellRanges;
+		TArray<FIntPoint> antRanges;
+		cellRanges.Add(getRange(grid.Num(), threads, thread));
+		antRanges.Add(getRange(ants, threads, thread));
+		workers.Emplace(new ACOWorker(grid, pheromoneField, colonies, cellRanges, antRanges));
+	}
+
+	//the iterations are counted by the worker which finishes them, a pool which doesn't get anywhere is given up
+	auto waitForIteration = [](int32 iteration)
+	{
+		const double timeout = FPlatformTime::Seconds() + 60.0;
+		while (ACOWorker::GetIterationCounter() < iteration)
+		{
+			if (FPlatformTime::Seconds() > timeout)
+				return false;
+			FPlatformProcess::Sleep(0.001f);
+		}
+		return true;
+	};
+	bool isRunning = waitForIteration(m_warmup);
+	for (int32 repetition = 0; isRunning && repetition < m_repetitions; ++repetition)
+	{
+		const int32 firstIteration = ACOWorker::GetIterationCounter();
+		const double startTime = FPlatformTime::Seconds();
+		isRunning = waitForIteration(firstIteration + m_poolIterations);
+		if (isRunning)
+			throughputs.Add(getThroughput(ACOWorker::GetIterationCounter() - firstIteration, FPlatformTime::Seconds() - startTime));
+	}
+	if (!isRunning)
+		UE_LOG(LogACO, Error, TEXT("The worker pool with %d threads stopped at iteration %d!"), threads, ACOWorker::GetIterationCounter());
+
+	ACOWorker::RequestStop();
+	workers.Reset();
+	ACOWorker::ReleaseBestPaths();
+	ACOWorker::SetShowBestPath(isShowingBestPath);
+}
+
+void ACOBenchmark::computeEfficiencies()
+{
+	for (ACOBenchmarkResult& result : m_results)
+	{
+		//strong scaling compares the same map, weak scaling the single thread map
+		const ACOBenchmarkResult* singleThread = m_results.FindByPredicate([&result](const ACOBenchmarkResult& other)
+		{
+			return other.Benchmark == result.Benchmark && other.IsWeakScaling == result.IsWeakScaling && other.Threads == 1 && (result.IsWeakScaling || other.Cells == result.Cells);
+		});
+		if (singleThread && singleThread->Throughput > 0.0)
+			result.Efficiency = result.Throughput / (result.Threads * singleThread->Throughput);
+	}
+}
+
+bool ACOBenchmark::WriteResults(const FString& filename) const
+{
+	FString table = TEXT("Benchmark,Scaling,Cells,Ants,Threads,Throughput,Efficiency\n");
+	for (const auto& result : m_results)
+	{
+		table += FString::Printf(TEXT("%s,%s,%d,%d,%d,%.0f,%.3f\n"), GetBenchmarkName(result.Benchmark), result.IsWeakScaling ? TEXT("Weak") : TEXT("Strong"),
+			result.Cells, result.Ants, result.Threads, result.Throughput, result.Efficiency);
+	}
+
+	if (!FFileHelper::SaveStringToFile(table, *filename))
+	{
+		UE_LOG(LogACO, Error, TEXT("Couldn't write benchmark results to %s!"), *filename);
+		return false;
+	}
+	UE_LOG(LogACO, Log, TEXT("Benchmark results written to %s"), *filename);
+	return true;
+}
+
+bool ACOBenchmark::CompareWithBaseline(const FString& filename) const
+{
+	TArray<FString> lines;
+	if (!FFileHelper::LoadANSITextFileToStrings(*filename, nullptr, lines))
+	{
+		UE_LOG(LogACO, Error, TEXT("Couldn't read benchmark baseline %s!"), *filename);
+		return false;
+	}
+
+	//the columns of WriteResults, the header is skipped
+	TMap<FString, double> baseline;
+	for (int32 i = 1; i < lines.Num(); ++i)
+	{
+		TArray<FString> columns;
+		lines[i].ParseIntoArray(columns, TEXT(","), false);
+		EACOBenchmark benchmark;
+		if (columns.Num() < 6 || !ParseBenchmark(columns[0], benchmark))
+			continue;
+		baseline.Add(getKey(benchmark, columns[1] == TEXT("Weak"), FCString::Atoi(*columns[2]), FCString::Atoi(*columns[4])), FCString::Atod(*columns[5]));
+	}
+
+	int32 regressions = 0;
+	int32 comparisons = 0;
+	for (const auto& result : m_results)
+	{
+		const double* reference = baseline.Find(getKey(result.Benchmark, result.IsWeakScaling, result.Cells, result.Threads));
+		if (!reference || *reference <= 0.0)
+			continue;
+		++comparisons;
+		const double change = result.Throughput / *reference - 1.0;
+		const float tolerance = getTolerance(result.Benchmark);
+		if (change < -tolerance)
+		{
+			++regressions;
+			UE_LOG(LogACO, Error, TEXT("%s %s scaling, %d cells, %d threads regressed by %.1f%% (%.0f/s, baseline %.0f/s, tolerance %.0f%%)"), GetBenchmarkName(result.Benchmark),
+				result.IsWeakScaling ? TEXT("weak") : TEXT("strong"), result.Cells, result.Threads, -100.0 * change, result.Throughput, *reference, 100.f * tolerance);
+		}
+		else if (change > tolerance)
+		{
+			UE_LOG(LogACO, Log, TEXT("%s %s scaling, %d cells, %d threads improved by %.1f%%"), GetBenchmarkName(result.Benchmark), result.IsWeakScaling ? TEXT("weak") : TEXT("strong"),
+				result.Cells, result.Threads, 100.0 * change);
+		}
+	}
+
+	if (comparisons < m_results.Num())
+		UE_LOG(LogACO, Warning, TEXT("%d of %d benchmarks have no baseline in %s"), m_results.Num() - comparisons, m_results.Num(), *filename);
+	UE_LOG(LogACO, Log, TEXT("%d of %d benchmarks regressed compared to %s"), regressions, comparisons, *filename);
+	return regressions == 0;
+}
+
+FString ACOBenchmark::getKey(EACOBenchmark benchmark, bool isWeakScaling, int32 cells, int32 threads)
+{
+	return FString::Printf(TEXT("%s/%s/%d/%d"), GetBenchmarkName(benchmark), isWeakScaling ? TEXT("Weak") : TEXT("Strong"), cells, threads);
+}
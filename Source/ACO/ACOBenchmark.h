@@ -0,0 +1,94 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "ACOColony.h"
+
+/** what a benchmark measures, the throughput is counted in the items of the benchmark */
+enum class EACOBenchmark : uint8
+{
+	/** ACOColony::TraverseAnts, ant steps */
+	Transition,
+	/** ACOColony::MarkAnts, ants */
+	Deposit,
+	/** ACOColony::EvaporateCells, cells */
+	Evaporation,
+	/** Pathfinding::AStarSearch from the anthill to a food source, searches */
+	AStar,
+	/** all phases of an iteration, ant steps */
+	Iteration,
+	/** iterations of the ACOWorker pool, including its barriers, control points, the update by one worker and the best paths */
+	WorkerPool,
+	Num
+};
+
+struct ACOBenchmarkResult
+{
+	EACOBenchmark Benchmark;
+	/** strong scaling keeps the map and the ants, weak scaling grows them with the threads */
+	bool IsWeakScaling;
+	int32 Cells;
+	int32 Ants;
+	int32 Threads;
+	/** median items per second of the repetitions */
+	double Throughput;
+	/** throughput / (threads * throughput of one thread), 0 without a single thread run */
+	double Efficiency;
+};
+
+/**
+ * Throughput benchmarks of the phases of ACOWorker and of Pathfinding with strong and weak scaling curves.
+ * Every thread count splits the ants and cells into ranges like ACOWorker, the maps are generated like the ones of ACOBatchRunner.
+ * The results can be compared to a baseline file written by an earlier run, a benchmark regressed if its throughput is more than
+ * its tolerance below the baseline. Changes to ACOWorker, ACOColony or Pathfinding should be checked against the baseline of the machine.
+ * The automation tests ACO.Benchmark.<benchmark> run every benchmark on small maps and gate it with the same comparison.
+ *
+ * -Maps=100x100,500x500,2000x2000 -Threads=1,2,4,8 -Ants=10000 -Scaling=Strong,Weak -WeakCells=250000 -WeakAnts=2500
+ * -Repetitions=5 -Warmup=10 -Variant=AntSystem -StepKernel=VectorLanes -Tolerance=0.1 -Tolerances=AStar:0.25,Deposit:0.2
+ * -Benchmarks=Transition,WorkerPool -PoolIterations=10
+ * The switches need their dash, -Ants= would find -WeakAnts= otherwise.
+ */
+class ACO_API ACOBenchmark
+{
+public:
+	ACOBenchmark();
+
+	bool Parse(const TCHAR* stream);
+	void Run();
+
+	bool WriteResults(const FString& filename) const;
+	/** logs every benchmark which differs from the baseline by more than its tolerance, returns false if one regressed */
+	bool CompareWithBaseline(const FString& filename) const;
+
+	const TArray<ACOBenchmarkResult>& GetResults() const { return m_results; }
+
+	static const TCHAR* GetBenchmarkName(EACOBenchmark benchmark);
+	static bool ParseBenchmark(const FString& name, EACOBenchmark& benchmark);
+
+private:
+	/** runs all benchmarks on the grid with the amount of threads */
+	void measure(ACOGrid& grid, int32 ants, int32 threads, bool isWeakScaling);
+	/** one ACOWorker per thread runs PoolIterations iterations per repetition, adds iterations per second */
+	void measureWorkerPool(ACOGrid& grid, int32 ants, int32 threads, TArray<double>& throughputs) const;
+	bool isSelected(EACOBenchmark benchmark) const { return m_isSelected[static_cast<int32>(benchmark)]; }
+	void computeEfficiencies();
+	float getTolerance(EACOBenchmark benchmark) const { return m_tolerances[static_cast<int32>(benchmark)]; }
+	/** identifies a result in the baseline */
+	static FString getKey(EACOBenchmark benchmark, bool isWeakScaling, int32 cells, int32 threads);
+
+	TArray<FIntPoint> m_mapSizes;
+	TArray<int32> m_threads;
+	int32 m_ants;
+	bool m_isStrongScaling;
+	bool m_isWeakScaling;
+	int32 m_weakCells;
+	int32 m_weakAnts;
+	int32 m_repetitions;
+	int32 m_warmup;
+	int32 m_poolIterations;
+	bool m_isSelected[static_cast<int32>(EACOBenchmark::Num)];
+	ACOParameters m_parameters;
+	float m_tolerances[static_cast<int32>(EACOBenchmark::Num)];
+
+	TArray<ACOBenchmarkResult> m_results;
+};
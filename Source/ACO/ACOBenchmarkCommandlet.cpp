@@ -0,0 +1,34 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ACO.h"
+#include "ACOBenchmarkCommandlet.h"
+#include "ACOBenchmark.h"
+
+UACOBenchmarkCommandlet::UACOBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UACOBenchmarkCommandlet::Main(const FString& Params)
+{
+	ACOBenchmark benchmark;
+	if (!benchmark.Parse(*Params))
+		return 1;
+
+	benchmark.Run();
+
+	FString output = FPaths::GameSavedDir() / TEXT("ACO/Benchmark.csv");
+	FParse::Value(*Params, TEXT("-Output="), output);
+	if (!benchmark.WriteResults(output))
+		return 1;
+
+	FString baseline;
+	if (!FParse::Value(*Params, TEXT("-Baseline="), baseline))
+		return 0;
+	if (FParse::Param(*Params, TEXT("UpdateBaseline")))
+		return benchmark.WriteResults(baseline) ? 0 : 1;
+	return benchmark.CompareWithBaseline(baseline) ? 0 : 1;
+}
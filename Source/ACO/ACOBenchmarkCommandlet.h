@@ -0,0 +1,23 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+#include "ACOBenchmarkCommandlet.generated.h"
+
+/**
+ * Runs ACOBenchmark headless and writes the results to Saved/ACO/Benchmark.csv or -Output=<file>.
+ * With -Baseline=<file> the results are compared to an earlier run and the commandlet returns 1 if a benchmark regressed,
+ * -UpdateBaseline writes the results to the baseline instead.
+ * UE4Editor-Cmd.exe ACO.uproject -run=ACOBenchmark -nullrhi -Maps=100x100,2000x2000 -Threads=1,4,8 -Baseline=Benchmark.csv -Tolerance=0.1
+ */
+UCLASS()
+class UACOBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UACOBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
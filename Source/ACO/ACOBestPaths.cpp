@@ -0,0 +1,207 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ACO.h"
+#include "ACOBestPaths.h"
+#include "Pathfinding.h"
+
+ACOBestPaths::ACOBestPaths(const ACOGrid& grid) : m_grid(grid), m_tolerance(0.05f), m_bandRadius(2), m_refreshInterval(100), m_isRendering(false),
+	m_searches(0), m_keptRoutes(0)
+{
+}
+
+void ACOBestPaths::ParseCommandLine(const TCHAR* stream)
+{
+	FParse::Value(stream, TEXT("ACOBestPathTolerance="), m_tolerance);
+	FParse::Value(stream, TEXT("ACOBestPathBand="), m_bandRadius);
+	FParse::Value(stream, TEXT("ACOBestPathRefresh="), m_refreshInterval);
+	m_tolerance = FMath::Max(m_tolerance, 0.f);
+	m_bandRadius = FMath::Max(m_bandRadius, 0);
+}
+
+bool ACOBestPaths::Update(const ACOPheromoneField& pheromoneField, const TArray<ACOColony*>& colonies, bool isRendering, bool (*passControlPoint)())
+{
+	SCOPE_CYCLE_COUNTER(STAT_ACOBestPaths);
+	m_searches = 0;
+	m_keptRoutes = 0;
+	if (!isRendering)
+	{
+		if (m_isRendering)
+			Clear();
+		m_isRendering = false;
+		return true;
+	}
+	m_isRendering = true;
+
+	updateRoutes(colonies);
+	for (Route& route : m_routes)
+	{
+		if (!isDirty(route, pheromoneField))
+		{
+			++route.Age;
+			++m_keptRoutes;
+			continue;
+		}
+		if (passControlPoint && !passControlPoint())
+			break;
+
+		//the new cells are added first, so the hexagons both routes go through are never touched
+		const TArray<int32> previousCells = MoveTemp(route.Cells);
+		search(route, pheromoneField);
+		highlight(route.Cells, true);
+		highlight(previousCells, false);
+		++m_searches;
+	}
+	INC_DWORD_STAT_BY(STAT_ACOBestPathSearches, m_searches);
+	return m_searches + m_keptRoutes == m_routes.Num();
+}
+
+void ACOBestPaths::Clear()
+{
+	for (const Route& route : m_routes)
+		highlight(route.Cells, false);
+	m_routes.Reset();
+}
+
+const TArray<int32>* ACOBestPaths::FindRoute(int32 channel, int32 foodSource) const
+{
+	const Route* route = m_routes.FindByPredicate([channel, foodSource](const Route& other) { return other.Channel == channel && other.FoodSource == foodSource; });
+	return route && route->IsSearched ? &route->Cells : nullptr;
+}
+
+bool ACOBestPaths::isDirty(const Route& route, const ACOPheromoneField& pheromoneField) const
+{
+	if (!route.IsSearched || (m_refreshInterval > 0 && route.Age >= m_refreshInterval))
+		return true;
+
+	//the A* costs are max level - level, so the tolerance is relative to the max level
+	const float maxLevel = pheromoneField.GetMaxPheromoneLevel(route.Channel);
+	const float threshold = m_tolerance * FMath::Max(maxLevel, route.MaxLevel);
+	if (FMath::Abs(maxLevel - route.MaxLevel) > threshold)
+		return true;
+
+	for (int32 i = 0; i < route.BandCells.Num(); ++i)
+	{
+		const float level = pheromoneField.GetPheromoneLevel(route.BandCells[i], route.Channel);
+		if (route.IsOnRoute[i] ? level < route.BandLevels[i] - threshold : level > route.BandLevels[i] + threshold)
+			return true;
+	}
+	return false;
+}
+
+void ACOBestPaths::search(Route& route, const ACOPheromoneField& pheromoneField)
+{
+	std::unordered_map<int32, int32> came_from;
+	Pathfinding::AStarSearch(m_grid, pheromoneField, route.Channel, route.Anthill, route.FoodSource, came_from);
+
+	route.Cells.Reset();
+	const bool isFound = came_from.count(route.FoodSource) > 0;
+	if (isFound)
+	{
+		for (int32 cell : Pathfinding::ReconstructPath(route.Anthill, route.FoodSource, came_from))
+		{
+			if (cell != route.Anthill && cell != route.FoodSource)
+				route.Cells.Add(cell);
+		}
+	}
+	route.MaxLevel = pheromoneField.GetMaxPheromoneLevel(route.Channel);
+	route.Age = 0;
+	route.IsSearched = true;
+
+	route.BandCells.Reset();
+	route.BandLevels.Reset();
+	route.IsOnRoute.Reset();
+	//without a route only the max level and the age can trigger the next search
+	if (isFound)
+		buildBand(route, pheromoneField);
+}
+
+void ACOBestPaths::buildBand(Route& route, const ACOPheromoneField& pheromoneField)
+{
+	if (m_bandDistances.Num() != m_grid.Num())
+		m_bandDistances.Init(INDEX_NONE, m_grid.Num());
+
+	auto addCell = [this, &route](int32 cell, int32 distance)
+	{
+		m_bandDistances[cell] = distance;
+		route.BandCells.Add(cell);
+		route.IsOnRoute.Add(distance == 0 ? 1 : 0);
+	};
+	addCell(route.Anthill, 0);
+	for (int32 cell : route.Cells)
+		addCell(cell, 0);
+	addCell(route.FoodSource, 0);
+
+	//breadth first from the route, the band cells are the queue
+	for (int32 i = 0; i < route.BandCells.Num(); ++i)
+	{
+		const int32 cell = route.BandCells[i];
+		const int32 distance = m_bandDistances[cell];
+		if (distance >= m_bandRadius)
+			continue;
+		for (const int32* neighbour = m_grid.GetNeighboursBegin(cell); neighbour != m_grid.GetNeighboursEnd(cell); ++neighbour)
+		{
+			if (m_bandDistances[*neighbour] == INDEX_NONE)
+				addCell(*neighbour, distance + 1);
+		}
+	}
+
+	route.BandLevels.SetNumUninitialized(route.BandCells.Num());
+	for (int32 i = 0; i < route.BandCells.Num(); ++i)
+	{
+		m_bandDistances[route.BandCells[i]] = INDEX_NONE;
+		route.BandLevels[i] = pheromoneField.GetPheromoneLevel(route.BandCells[i], route.Channel);
+	}
+}
+
+void ACOBestPaths::highlight(const TArray<int32>& cells, bool isHighlighted)
+{
+	if (m_highlightCounts.Num() != m_grid.Num())
+		m_highlightCounts.SetNumZeroed(m_grid.Num());
+
+	for (int32 cell : cells)
+	{
+		int32& count = m_highlightCounts[cell];
+		count += isHighlighted ? 1 : -1;
+		AHexagon* hex = m_grid.Hexagons.Num() > 0 ? m_grid.Hexagons[cell] : nullptr;
+		if (hex && count == (isHighlighted ? 1 : 0))
+			hex->SetIsAPath(isHighlighted);
+	}
+}
+
+void ACOBestPaths::updateRoutes(const TArray<ACOColony*>& colonies)
+{
+	//food sources can be added and removed while the workers run
+	TArray<Route> routes;
+	for (const ACOColony* colony : colonies)
+	{
+		for (int32 foodSource : m_grid.FoodSources)
+		{
+			Route* existing = m_routes.FindByPredicate([colony, foodSource](const Route& route)
+			{
+				return route.Channel == colony->GetChannel() && route.Anthill == colony->GetAnthill() && route.FoodSource == foodSource;
+			});
+			if (existing)
+			{
+				routes.Add(MoveTemp(*existing));
+				existing->Channel = INDEX_NONE;
+				continue;
+			}
+
+			Route route;
+			route.Channel = colony->GetChannel();
+			route.Anthill = colony->GetAnthill();
+			route.FoodSource = foodSource;
+			route.MaxLevel = 0.f;
+			route.Age = 0;
+			route.IsSearched = false;
+			routes.Add(MoveTemp(route));
+		}
+	}
+
+	for (const Route& route : m_routes)
+	{
+		if (route.Channel != INDEX_NONE)
+			highlight(route.Cells, false);
+	}
+	m_routes = MoveTemp(routes);
+}
@@ -0,0 +1,81 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "ACOColony.h"
+
+/**
+ * Best routes of every colony from its anthill to every food source, searched with Pathfinding::AStarSearch and kept between iterations.
+ * A route is only searched again if a change of the pheromones could make another route cheaper. The change has to exceed
+ * Tolerance * max level of the channel, which is the unit of the A* costs:
+ * - a cell of the route lost pheromones,
+ * - a cell within BandRadius steps of the route gained pheromones,
+ * - the max level of the channel moved,
+ * - the route is older than RefreshInterval iterations, a shortcut far away from the band can't be seen otherwise.
+ * The hexagons of the routes are highlighted as a diff, a hexagon shared by several routes stays highlighted until the last one leaves it.
+ *
+ * -ACOBestPathTolerance=0.05 -ACOBestPathBand=2 -ACOBestPathRefresh=100
+ */
+class ACO_API ACOBestPaths
+{
+public:
+	/** the grid has to outlive the object */
+	explicit ACOBestPaths(const ACOGrid& grid);
+
+	void ParseCommandLine(const TCHAR* stream);
+
+	/**
+	 * has to be called by one thread at an iteration boundary, highlights the routes or removes the highlights if not isRendering.
+	 * passControlPoint is called before every search, if it returns false the remaining routes keep their cells and false is returned.
+	 */
+	bool Update(const ACOPheromoneField& pheromoneField, const TArray<ACOColony*>& colonies, bool isRendering, bool (*passControlPoint)() = nullptr);
+	/** removes all routes and highlights */
+	void Clear();
+
+	/** cells of the route without the anthill and the food source, empty if there is none */
+	const TArray<int32>* FindRoute(int32 channel, int32 foodSource) const;
+	/** routes searched and kept by the last update */
+	int32 GetSearches() const { return m_searches; }
+	int32 GetKeptRoutes() const { return m_keptRoutes; }
+
+private:
+	struct Route
+	{
+		int32 Channel;
+		int32 Anthill;
+		int32 FoodSource;
+		/** without the anthill and the food source */
+		TArray<int32> Cells;
+		/** the cells within the band radius of the route and their levels at the search */
+		TArray<int32> BandCells;
+		TArray<float> BandLevels;
+		/** per band cell, 1 if the route goes through it */
+		TArray<uint8> IsOnRoute;
+		float MaxLevel;
+		int32 Age;
+		/** false until the first search, the route can't be kept before */
+		bool IsSearched;
+	};
+
+	bool isDirty(const Route& route, const ACOPheromoneField& pheromoneField) const;
+	void search(Route& route, const ACOPheromoneField& pheromoneField);
+	void buildBand(Route& route, const ACOPheromoneField& pheromoneField);
+	/** adds or removes the cells of a route from the highlights, only the first and the last route of a cell change the hexagon */
+	void highlight(const TArray<int32>& cells, bool isHighlighted);
+	/** routes of every colony to the current food sources, kept routes stay */
+	void updateRoutes(const TArray<ACOColony*>& colonies);
+
+	const ACOGrid& m_grid;
+	float m_tolerance;
+	int32 m_bandRadius;
+	int32 m_refreshInterval;
+
+	TArray<Route> m_routes;
+	/** amount of highlighted routes through every cell */
+	TArray<int32> m_highlightCounts;
+	bool m_isRendering;
+	int32 m_searches;
+	int32 m_keptRoutes;
+	/** distance of the cells to the route while a band is built */
+	TArray<int32> m_bandDistances;
+};
@@ -0,0 +1,402 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ACO.h"
+#include "ACOColony.h"
+#include <algorithm>
+
+namespace
+{
+	/** murmur3 finalizer, neighbouring ants get unrelated seeds although FRandomStream is a linear congruential generator */
+	uint32 mixSeed(uint32 hash)
+	{
+		hash ^= hash >> 16;
+		hash *= 0x85ebca6b;
+		hash ^= hash >> 13;
+		hash *= 0xc2b2ae35;
+		hash ^= hash >> 16;
+		return hash;
+	}
+}
+
+ACOTripStatistics::ACOTripStatistics() : FoodFound(0), ReturnedHome(0), BestTripCost(MAX_FLT), BestTripLength(0), AntSteps(0)
+{
+}
+
+void ACOTripStatistics::Merge(const ACOTripStatistics& other)
+{
+	FoodFound += other.FoodFound;
+	ReturnedHome += other.ReturnedHome;
+	AntSteps += other.AntSteps;
+	//the shorter one of equal trips, so the merge order doesn't matter
+	if (other.BestTripCost < BestTripCost || (other.BestTripCost == BestTripCost && other.BestTripLength < BestTripLength))
+	{
+		BestTripCost = other.BestTripCost;
+		BestTripLength = other.BestTripLength;
+	}
+}
+
+ACOColony::ACOColony(const ACOGrid& grid, int32 anthill, const ACOParameters& parameters)
+	: m_grid(grid), m_anthillDistances(grid.GetAnthillDistances(anthill)), m_parameters(parameters), m_anthill(anthill), m_iterationCounter(0), m_iterationBestTripCost(MAX_FLT), m_iterationMeanTripCost(0.f), m_ownPheromoneField(new ACOPheromoneField(grid.Num(), 1, parameters.PheromoneStorage, parameters.Deterministic)), m_pheromoneField(m_ownPheromoneField.Get()), m_channel(0)
+{
+	initTerrainWeights();
+	createAnts();
+}
+
+ACOColony::ACOColony(const ACOGrid& grid, ACOPheromoneField& pheromoneField, int32 channel, int32 anthill, const ACOParameters& parameters)
+	: m_grid(grid), m_anthillDistances(grid.GetAnthillDistances(anthill)), m_parameters(parameters), m_anthill(anthill), m_iterationCounter(0), m_iterationBestTripCost(MAX_FLT), m_iterationMeanTripCost(0.f), m_pheromoneField(&pheromoneField), m_channel(channel)
+{
+	initTerrainWeights();
+	createAnts();
+}
+
+template<typename TTransitionRule, typename TDepositRule, typename TLanes>
+void ACOColony::traverseAnts(int32 first, int32 last, FRandomStream& randomStream, ACOTripStatistics& statistics, bool isMovingInLanes)
+{
+	//the lanes choose the cells of a chunk of ants first, then the chunk moves in ant order like the per ant path
+	static const int32 ChunkSize = 64;
+	int32 nextCells[ChunkSize];
+	TArray<float, TInlineAllocator<16>> tripCosts;
+	ACOTripStatistics rangeStatistics;
+	FRandomStream antRandomStream;
+
+	const FIntPoint dueRange = getDueRange(first, last);
+	for (int32 chunk = dueRange.X; chunk < dueRange.Y; chunk += ChunkSize)
+	{
+		const int32 chunkEnd = FMath::Min(chunk + ChunkSize, dueRange.Y);
+		if (isMovingInLanes)
+			chooseNextCellsInLanes<TLanes>(chunk, chunkEnd, randomStream, nextCells);
+		for (int32 i = chunk; i < chunkEnd; ++i)
+		{
+			ACOAnt& ant = getDueAnt(i);
+			int32 newPosition = INDEX_NONE;
+			if (!ant.isCarryingFood && ant.isSearchingFood)
+			{
+				newPosition = isMovingInLanes ? nextCells[i - chunk] : chooseNextCell<TTransitionRule>(ant, getRandomStream(i, randomStream, antRandomStream));
+				if (newPosition != INDEX_NONE)
+				{
+					TTransitionRule::OnMove(*m_pheromoneField, newPosition, m_channel, m_parameters);
+				}
+				else
+				{
+					//no visitable node, return to anthill
+					ant.isSearchingFood = false;
+				}
+			}
+			if (!ant.isSearchingFood || ant.isCarryingFood)
+			{
+				//go back to anthill
+				newPosition = ant.visitedPath.Pop();
+				if (newPosition == ant.Position)
+					newPosition = ant.visitedPath.Pop();
+			}
+			else if (m_parameters.EraseLoops)
+				eraseLoop(ant, newPosition);
+			ant.Position = newPosition;
+			ant.NextMoveTime = m_iterationCounter + getTravelTime(newPosition);
+			++rangeStatistics.AntSteps;
+
+			//is new pos foodsource?
+			if (m_grid.IsFoodSource(newPosition) && ant.isSearchingFood)
+			{
+				float tripCost = getTripCost(ant);
+				ant.isCarryingFood = true;
+				ant.isSearchingFood = false;
+				//shortest walkable distance to the anthill compared to the walked one
+				const float distance = m_anthillDistances && ant.visitedPath[0] == m_anthill ? m_anthillDistances->Steps[newPosition] * m_grid.GetStepHeuristic() : m_grid.GetDistanceHeuristic(ant.visitedPath[0], newPosition);
+				ant.pheromonesPerNode = (distance / ant.visitedPath.Num() + 1) * TDepositRule::GetDepositFactor(tripCost, m_tripRanking, m_parameters);
+
+				++rangeStatistics.FoodFound;
+				tripCosts.Add(tripCost);
+				if (tripCost < rangeStatistics.BestTripCost)
+				{
+					rangeStatistics.BestTripCost = tripCost;
+					rangeStatistics.BestTripLength = ant.visitedPath.Num();
+				}
+			}
+			else if (!ant.isSearchingFood && newPosition == m_anthill)
+			{
+				//is back in anthill
+				if (ant.isCarryingFood)
+					++rangeStatistics.ReturnedHome;
+				ant.isCarryingFood = false;
+				ant.isSearchingFood = true;
+				ant.visitedCells.Reset();
+			}
+		}
+	}
+
+	statistics.Merge(rangeStatistics);
+	FScopeLock lock(&m_criticalTripSection);
+	m_currentIterationTripCosts.Append(tripCosts.GetData(), tripCosts.Num());
+	m_currentIterationStatistics.Merge(rangeStatistics);
+}
+
+template<typename TTransitionRule>
+int32 ACOColony::chooseNextCell(ACOAnt& ant, FRandomStream& randomStream)
+{
+	//a hexagon has at most 6 neighbours
+	int32 candidates[6];
+	float weights[6];
+
+	//add current position for finding the path back to anthill
+	ant.visitedPath.Push(ant.Position);
+	ant.visitedCells.Sync(ant.visitedPath);
+
+	/* weight of a turn from Hex I (current position) to Hex J (neighbor), the transition rule chooses with them
+	* Tij^a * nij^b, pij for ant k = (Tij^a * nij^b) / (sum of: Tih^a * nih^b, where h is element of H which are all unvisited neighbours)
+	* Tij ... Pheromones from I to J
+	* nij = 1 / lij
+	* lij ... length from I to J
+	*/
+	float sumOfUnvisitedNodes = 0.f;
+	int32 visitableNeighbours = 0;
+	for (const int32* neighbour = m_grid.GetNeighboursBegin(ant.Position); neighbour != m_grid.GetNeighboursEnd(ant.Position); ++neighbour)
+	{
+		if (ant.visitedCells.Contains(*neighbour))
+			continue;
+
+		float multiplication = getPheromoneWeight(*neighbour) * getTerrainWeight(*neighbour);
+		sumOfUnvisitedNodes += multiplication;
+		candidates[visitableNeighbours] = *neighbour;
+		weights[visitableNeighbours] = multiplication;
+		++visitableNeighbours;
+	}
+
+	return visitableNeighbours > 0 ? candidates[TTransitionRule::ChooseNeighbour(weights, visitableNeighbours, sumOfUnvisitedNodes, m_parameters, randomStream)] : INDEX_NONE;
+}
+
+template<typename TLanes>
+void ACOColony::chooseNextCellsInLanes(int32 first, int32 last, FRandomStream& randomStream, int32* nextCells)
+{
+	const int32 Width = ACOLanes::Width;
+	float pheromoneWeights[ACOLanes::Slots * Width] = {};
+	float terrainWeights[ACOLanes::Slots * Width] = {};
+	int32 candidates[ACOLanes::Slots * Width];
+	float uniforms[Width] = {};
+	int32 slots[Width];
+	int32 laneAnts[Width];
+	int32 lanes = 0;
+	FRandomStream antRandomStream;
+
+	auto selectInLanes = [&]()
+	{
+		//unused lanes keep the weights of an earlier ant or 0, their slots are ignored
+		TLanes::SelectProportional(pheromoneWeights, terrainWeights, uniforms, slots);
+		for (int32 lane = 0; lane < lanes; ++lane)
+			nextCells[laneAnts[lane] - first] = candidates[slots[lane] * Width + lane];
+		lanes = 0;
+	};
+
+	for (int32 i = first; i < last; ++i)
+	{
+		nextCells[i - first] = INDEX_NONE;
+		ACOAnt& ant = getDueAnt(i);
+		if (ant.isCarryingFood || !ant.isSearchingFood)
+			continue;
+
+		//same as chooseNextCell, the visited neighbours get a weight of 0 instead of being left out
+		ant.visitedPath.Push(ant.Position);
+		ant.visitedCells.Sync(ant.visitedPath);
+		const int32* neighbours = m_grid.GetNeighboursBegin(ant.Position);
+		const int32 neighbourAmount = m_grid.GetNeighboursEnd(ant.Position) - neighbours;
+		bool hasVisitableNeighbour = false;
+		for (int32 slot = 0; slot < ACOLanes::Slots; ++slot)
+		{
+			const int32 index = slot * Width + lanes;
+			const bool isVisitable = slot < neighbourAmount && !ant.visitedCells.Contains(neighbours[slot]);
+			candidates[index] = slot < neighbourAmount ? neighbours[slot] : INDEX_NONE;
+			pheromoneWeights[index] = isVisitable ? getPheromoneWeight(neighbours[slot]) : 0.f;
+			terrainWeights[index] = isVisitable ? getTerrainWeight(neighbours[slot]) : 0.f;
+			hasVisitableNeighbour |= isVisitable;
+		}
+		if (!hasVisitableNeighbour)
+			continue;
+
+		//the draws happen in ant order, like in the per ant path
+		uniforms[lanes] = getRandomStream(i, randomStream, antRandomStream).FRand();
+		laneAnts[lanes] = i;
+		if (++lanes == Width)
+			selectInLanes();
+	}
+	if (lanes > 0)
+		selectInLanes();
+}
+
+ACOTripStatistics ACOColony::Iterate(ACOIterationTrace* trace)
+{
+	ACOTripStatistics statistics;
+	{
+		ACOScopedPhaseTimer timer(GET_STATID(STAT_ACOTraversePhase), trace, EACOPhase::Traverse);
+		TraverseAnts(0, m_ants.Num(), m_randomStream, statistics);
+	}
+	{
+		ACOScopedPhaseTimer timer(GET_STATID(STAT_ACOMarkPhase), trace, EACOPhase::Mark);
+		MarkAnts(0, m_ants.Num());
+	}
+	{
+		ACOScopedPhaseTimer timer(GET_STATID(STAT_ACOEvaporatePhase), trace, EACOPhase::Evaporate);
+		EvaporateCells(0, m_grid.Num());
+	}
+	{
+		ACOScopedPhaseTimer timer(GET_STATID(STAT_ACOUpdateByOneWorker), trace, EACOPhase::UpdateByOneWorker);
+		FinishIteration();
+	}
+	return statistics;
+}
+
+void ACOColony::TraverseAnts(int32 first, int32 last, FRandomStream& randomStream, ACOTripStatistics& statistics)
+{
+	DispatchACOVariant(m_parameters.Variant, [&](auto policies)
+	{
+		typedef decltype(policies) Policies;
+		typedef typename Policies::Transition Transition;
+		typedef typename Policies::Deposit Deposit;
+		//the kernel is chosen once per phase, the per ant path uses none of them
+		const bool isMovingInLanes = Transition::CanMoveInLanes && m_parameters.StepKernel != EACOStepKernel::PerAnt;
+		if (m_parameters.StepKernel == EACOStepKernel::VectorLanes)
+			traverseAnts<Transition, Deposit, ACOVectorLanes>(first, last, randomStream, statistics, isMovingInLanes);
+		else
+			traverseAnts<Transition, Deposit, ACOScalarLanes>(first, last, randomStream, statistics, isMovingInLanes);
+	});
+}
+
+void ACOColony::MarkAnts(int32 first, int32 last)
+{
+	//ants mark the cell they entered, ants in transit don't
+	const FIntPoint dueRange = getDueRange(first, last);
+	for (int32 i = dueRange.X; i < dueRange.Y; ++i)
+	{
+		const ACOAnt& ant = m_ants[m_parameters.EventDriven ? m_dueAnts[i] : i];
+		if (ant.isCarryingFood && ant.pheromonesPerNode > 0.f)
+			m_pheromoneField->AddPheromones(ant.Position, m_channel, ant.pheromonesPerNode);
+	}
+}
+
+void ACOColony::EvaporateCells(int32 first, int32 last)
+{
+	DispatchACOVariant(m_parameters.Variant, [&](auto policies)
+	{
+		m_pheromoneField->Evaporate<typename decltype(policies)::Evaporation>(first, last, m_channel, m_parameters);
+	});
+}
+
+void ACOColony::FinishIteration()
+{
+	//keep the cheapest trips of this iteration for the ranking of the next one
+	m_currentIterationTripCosts.Sort();
+	m_iterationBestTripCost = MAX_FLT;
+	m_iterationMeanTripCost = 0.f;
+	if (m_currentIterationTripCosts.Num() > 0)
+	{
+		m_iterationBestTripCost = m_currentIterationTripCosts[0];
+		m_tripRanking.BestTripCost = FMath::Min(m_tripRanking.BestTripCost, m_iterationBestTripCost);
+		for (float tripCost : m_currentIterationTripCosts)
+			m_iterationMeanTripCost += tripCost;
+		m_iterationMeanTripCost /= m_currentIterationTripCosts.Num();
+	}
+	m_tripRanking.PreviousIterationTripCosts.Reset();
+	for (int32 i = 0; i < m_currentIterationTripCosts.Num() && i < FMath::Max(m_parameters.RankedTrips, 1); ++i)
+		m_tripRanking.PreviousIterationTripCosts.Add(m_currentIterationTripCosts[i]);
+	m_currentIterationTripCosts.Reset();
+	m_iterationStatistics = m_currentIterationStatistics;
+	m_currentIterationStatistics = ACOTripStatistics();
+
+	++m_iterationCounter;
+
+	if (m_parameters.EventDriven)
+	{
+		for (int32 antIndex : m_dueAnts)
+			m_schedule.Schedule(antIndex, m_ants[antIndex].NextMoveTime);
+		m_dueAnts.Reset();
+		m_schedule.Advance(m_dueAnts);
+		m_dueAnts.Sort();
+	}
+}
+
+void ACOColony::SortAnts(const TArray<int32>& cellRanks)
+{
+	m_ants.Sort([&cellRanks](const ACOAnt& a, const ACOAnt& b) { return cellRanks[a.Position] < cellRanks[b.Position]; });
+	//the schedule refers to ant indices
+	if (m_parameters.EventDriven)
+		rebuildSchedule();
+}
+
+void ACOColony::createAnts()
+{
+	m_randomStream.Initialize(m_parameters.Seed);
+	m_ants.Reserve(m_parameters.AntAmount);
+	for (int i = 0; i < m_parameters.AntAmount; ++i)
+		m_ants.Add(ACOAnt(m_anthill));
+	if (m_parameters.EventDriven)
+		rebuildSchedule();
+}
+
+FRandomStream& ACOColony::getRandomStream(int32 dueAnt, FRandomStream& workerRandomStream, FRandomStream& antRandomStream) const
+{
+	if (!m_parameters.Deterministic)
+		return workerRandomStream;
+	const int32 antIndex = m_parameters.EventDriven ? m_dueAnts[dueAnt] : dueAnt;
+	//the colonies of a shared field have the same seed, the anthill tells them apart
+	const uint32 iterationSeed = mixSeed(mixSeed(mixSeed(m_parameters.Seed) ^ m_anthill) ^ m_iterationCounter);
+	antRandomStream.Initialize(static_cast<int32>(mixSeed(iterationSeed + antIndex)));
+	return antRandomStream;
+}
+
+void ACOColony::initTerrainWeights()
+{
+	for (int32 type = 0; type < 256; ++type)
+		m_terrainWeights[type] = type > 0 ? FMath::Pow(1 / static_cast<float>(type), m_parameters.TraversePhaseConstantB) : 0.f;
+}
+
+void ACOColony::rebuildSchedule()
+{
+	m_schedule.Reset(m_iterationCounter);
+	m_dueAnts.Reset();
+	for (int32 antIndex = 0; antIndex < m_ants.Num(); ++antIndex)
+	{
+		if (m_ants[antIndex].NextMoveTime <= m_iterationCounter)
+			m_dueAnts.Add(antIndex);
+		else
+			m_schedule.Schedule(antIndex, m_ants[antIndex].NextMoveTime);
+	}
+}
+
+FIntPoint ACOColony::getDueRange(int32 firstAnt, int32 lastAnt) const
+{
+	if (!m_parameters.EventDriven)
+		return FIntPoint(firstAnt, lastAnt);
+
+	const int32* dueAnts = m_dueAnts.GetData();
+	return FIntPoint(std::lower_bound(dueAnts, dueAnts + m_dueAnts.Num(), firstAnt) - dueAnts, std::lower_bound(dueAnts, dueAnts + m_dueAnts.Num(), lastAnt) - dueAnts);
+}
+
+int32 ACOColony::getTravelTime(int32 cell) const
+{
+	return FMath::Max(1, FMath::RoundToInt(m_grid.GetTerrainCost(cell) * m_parameters.TravelTimePerCost));
+}
+
+void ACOColony::eraseLoop(ACOAnt& ant, int32 newPosition) const
+{
+	//the last cell of the path is the previous position, the path stays a chain of neighbours
+	int32 earliestNeighbour = ant.visitedPath.Num() - 1;
+	for (const int32* neighbour = m_grid.GetNeighboursBegin(newPosition); neighbour != m_grid.GetNeighboursEnd(newPosition); ++neighbour)
+	{
+		const int32 index = ant.visitedPath.Find(*neighbour);
+		if (index != INDEX_NONE && index < earliestNeighbour)
+			earliestNeighbour = index;
+	}
+	if (earliestNeighbour < ant.visitedPath.Num() - 1)
+	{
+		ant.visitedPath.SetNum(earliestNeighbour + 1, false);
+		ant.visitedCells.Reset();
+	}
+}
+
+float ACOColony::getTripCost(const ACOAnt& ant) const
+{
+	//the anthill itself is not part of the trip, the current position (food source) is
+	float cost = m_grid.GetTerrainCost(ant.Position);
+	for (int i = 1; i < ant.visitedPath.Num(); ++i)
+		cost += m_grid.GetTerrainCost(ant.visitedPath[i]);
+	return cost;
+}
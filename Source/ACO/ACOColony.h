@@ -0,0 +1,211 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "ACOGrid.h"
+#include "ACOPolicies.h"
+#include "ACOLanes.h"
+#include "ACOStats.h"
+#include "ACOTimingWheel.h"
+
+/**
+ * The cells of the visited path of an ant, the transition rules look up the neighbours in it instead of searching the path.
+ * Open addressing with linear probing, an entry only counts with the current stamp, so Reset doesn't touch the entries.
+ */
+class ACOVisitedCells
+{
+public:
+	ACOVisitedCells() : m_stamp(1), m_syncedLength(0) {}
+
+	/** the path lost cells, the next Sync adds the remaining ones again */
+	void Reset()
+	{
+		m_syncedLength = 0;
+		if (++m_stamp == 0)
+		{
+			//the entries of the first stamps would count again
+			FMemory::Memzero(m_entries.GetData(), m_entries.Num() * sizeof(Entry));
+			m_stamp = 1;
+		}
+	}
+
+	/** adds the cells which were pushed to the path since the last Sync */
+	void Sync(const TArray<int32>& path)
+	{
+		if (path.Num() < m_syncedLength)
+			Reset();
+		//less than half of the entries are used, so the probe sequences stay short and there is always a free one
+		if (path.Num() * 2 >= m_entries.Num())
+		{
+			m_entries.Reset();
+			m_entries.SetNumZeroed(FMath::RoundUpToPowerOfTwo(FMath::Max(path.Num() * 2 + 1, 16)));
+			m_stamp = 1;
+			m_syncedLength = 0;
+		}
+		for (; m_syncedLength < path.Num(); ++m_syncedLength)
+		{
+			Entry& entry = m_entries[find(path[m_syncedLength])];
+			entry.Cell = path[m_syncedLength];
+			entry.Stamp = m_stamp;
+		}
+	}
+
+	/** only after Sync */
+	bool Contains(int32 cell) const { return m_entries[find(cell)].Stamp == m_stamp; }
+
+private:
+	struct Entry
+	{
+		int32 Cell;
+		uint32 Stamp;
+	};
+
+	/** entry of the cell, the free one where it would be added if it isn't there */
+	int32 find(int32 cell) const
+	{
+		const uint32 mask = m_entries.Num() - 1;
+		uint32 hash = static_cast<uint32>(cell) * 0x9e3779b1;
+		uint32 index = (hash ^ (hash >> 16)) & mask;
+		while (m_entries[index].Stamp == m_stamp && m_entries[index].Cell != cell)
+			index = (index + 1) & mask;
+		return index;
+	}
+
+	TArray<Entry> m_entries;
+	uint32 m_stamp;
+	/** cells of the path which are in the entries */
+	int32 m_syncedLength;
+};
+
+struct ACOAnt
+{
+	explicit ACOAnt(int32 pos) : Position(pos), isCarryingFood(false), isSearchingFood(true), pheromonesPerNode(0.0f), NextMoveTime(0) {}
+
+	int32 Position;
+	TArray<int32> visitedPath;
+	/** visitedPath as of the last move of the searching ant */
+	ACOVisitedCells visitedCells;
+	bool isCarryingFood;
+	bool isSearchingFood;
+	float pheromonesPerNode;
+	/** event driven colonies: iteration of the next move */
+	int32 NextMoveTime;
+};
+
+/** what happened to the ants during a traverse phase */
+struct ACO_API ACOTripStatistics
+{
+	ACOTripStatistics();
+	void Merge(const ACOTripStatistics& other);
+
+	int32 FoodFound;
+	int32 ReturnedHome;
+	/** terrain cost of the cheapest anthill to food trip */
+	float BestTripCost;
+	int32 BestTripLength;
+	int64 AntSteps;
+};
+
+/**
+ * One ant colony on a shared ACOGrid.
+ * The phases work on ranges of ants and cells, so a colony can be iterated by one thread or split over several workers.
+ * Event driven colonies (ACOParameters::EventDriven) only move and mark the ants of the range which are due in the current iteration.
+ */
+class ACO_API ACOColony
+{
+	friend class ACOSnapshot;
+
+public:
+	/** the colony uses its own pheromone field */
+	ACOColony(const ACOGrid& grid, int32 anthill, const ACOParameters& parameters);
+	/** the colony uses one channel of a pheromone field shared with other colonies */
+	ACOColony(const ACOGrid& grid, ACOPheromoneField& pheromoneField, int32 channel, int32 anthill, const ACOParameters& parameters);
+
+	/** executes all phases of one iteration on the calling thread, adds the phase timings to the trace row if there is one */
+	ACOTripStatistics Iterate(ACOIterationTrace* trace = nullptr);
+
+	void TraverseAnts(int32 first, int32 last, FRandomStream& randomStream, ACOTripStatistics& statistics);
+	void MarkAnts(int32 first, int32 last);
+	void EvaporateCells(int32 first, int32 last);
+	/** has to be called once after all phases of an iteration are done */
+	void FinishIteration();
+	/** orders the ants by the rank of their position, so neighbouring ants are moved by the same worker, not thread safe */
+	void SortAnts(const TArray<int32>& cellRanks);
+
+	float GetPheromoneLevel(int32 cell) const { return m_pheromoneField->GetPheromoneLevel(cell, m_channel); }
+	int32 GetChannel() const { return m_channel; }
+	int32 GetAntAmount() const { return m_ants.Num(); }
+	int32 GetAnthill() const { return m_anthill; }
+	int32 GetIterationCounter() const { return m_iterationCounter; }
+	const ACOGrid& GetGrid() const { return m_grid; }
+	const ACOPheromoneField& GetPheromoneField() const { return *m_pheromoneField; }
+	const ACOParameters& GetParameters() const { return m_parameters; }
+	/** terrain cost of the cheapest trip so far, MAX_FLT until food was found */
+	float GetBestTripCost() const { return m_tripRanking.BestTripCost; }
+	/** trips of the last finished iteration, MAX_FLT / 0 if no ant found food */
+	float GetIterationBestTripCost() const { return m_iterationBestTripCost; }
+	float GetIterationMeanTripCost() const { return m_iterationMeanTripCost; }
+	/** all ants of the last finished iteration, no matter which thread moved them */
+	const ACOTripStatistics& GetIterationStatistics() const { return m_iterationStatistics; }
+
+protected:
+	/** TLanes chooses the cells of the searching ants if isMovingInLanes */
+	template<typename TTransitionRule, typename TDepositRule, typename TLanes>
+	void traverseAnts(int32 first, int32 last, FRandomStream& randomStream, ACOTripStatistics& statistics, bool isMovingInLanes);
+	/** adds the position to the path of the searching ant and returns the next cell, INDEX_NONE if no neighbour can be visited */
+	template<typename TTransitionRule>
+	int32 chooseNextCell(ACOAnt& ant, FRandomStream& randomStream);
+	/** chooseNextCell of the searching ants of the due ants [first, last) in groups of ACOLanes::Width, nextCells gets one cell per due ant */
+	template<typename TLanes>
+	void chooseNextCellsInLanes(int32 first, int32 last, FRandomStream& randomStream, int32* nextCells);
+
+	ACOAnt& getDueAnt(int32 i) { return m_ants[m_parameters.EventDriven ? m_dueAnts[i] : i]; }
+	/** the stream of the worker, a deterministic colony (re)seeds antRandomStream from the seed, the iteration and the ant instead */
+	FRandomStream& getRandomStream(int32 dueAnt, FRandomStream& workerRandomStream, FRandomStream& antRandomStream) const;
+	/** Tij^a, cells without pheromones are weighted like a level of 1 */
+	float getPheromoneWeight(int32 cell) const
+	{
+		const float pheromoneLevel = GetPheromoneLevel(cell);
+		return FMath::Pow(pheromoneLevel <= 0.0f ? 1.f : pheromoneLevel, m_parameters.TraversePhaseConstantA);
+	}
+	/** nij^b */
+	float getTerrainWeight(int32 cell) const { return m_terrainWeights[static_cast<uint8>(m_grid.TerrainTypes[cell])]; }
+	void initTerrainWeights();
+
+	void createAnts();
+	float getTripCost(const ACOAnt& ant) const;
+	int32 getTravelTime(int32 cell) const;
+	/** [first, last) of m_dueAnts which belong to the ant range [firstAnt, lastAnt), the ant range itself if the colony isn't event driven */
+	FIntPoint getDueRange(int32 firstAnt, int32 lastAnt) const;
+	/** schedules every ant at its NextMoveTime, ants which are due already are due now */
+	void rebuildSchedule();
+	/** removes the cells between the earliest neighbour of the new position and the end of the path */
+	void eraseLoop(ACOAnt& ant, int32 newPosition) const;
+
+	const ACOGrid& m_grid;
+	/** of the anthill, nullptr if the grid has none for it */
+	const ACODistanceField* m_anthillDistances;
+	ACOParameters m_parameters;
+	int32 m_anthill;
+	int32 m_iterationCounter;
+	FRandomStream m_randomStream;
+	/** nij^b of every ETerrainType, the terrain cost is the value of the type */
+	float m_terrainWeights[256];
+
+	TArray<ACOAnt> m_ants;
+	/** event driven colonies: ants which aren't due yet and the sorted ants which are due in this iteration */
+	ACOTimingWheel m_schedule;
+	TArray<int32> m_dueAnts;
+	/** trips of the previous iterations for the deposit rules */
+	ACOTripRanking m_tripRanking;
+	TArray<float> m_currentIterationTripCosts;
+	float m_iterationBestTripCost;
+	float m_iterationMeanTripCost;
+	ACOTripStatistics m_currentIterationStatistics;
+	ACOTripStatistics m_iterationStatistics;
+	FCriticalSection m_criticalTripSection;
+
+	TUniquePtr<ACOPheromoneField> m_ownPheromoneField;
+	ACOPheromoneField* m_pheromoneField;
+	int32 m_channel;
+};
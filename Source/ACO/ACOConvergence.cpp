@@ -0,0 +1,141 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ACO.h"
+#include "ACOConvergence.h"
+
+ACOConvergenceCriteria::ACOConvergenceCriteria() : Window(50), Tolerance(0.001f), Action(EACOConvergenceAction::None), ThrottleSleep(0.25f), LogInterval(100)
+{
+}
+
+bool ACOConvergenceCriteria::Parse(const TCHAR* stream)
+{
+	FParse::Value(stream, TEXT("-ConvergenceWindow="), Window);
+	FParse::Value(stream, TEXT("-ConvergenceTolerance="), Tolerance);
+	FParse::Value(stream, TEXT("-ThrottleSleep="), ThrottleSleep);
+	FParse::Value(stream, TEXT("-ACOLogInterval="), LogInterval);
+
+	FString action;
+	if (FParse::Value(stream, TEXT("-OnConvergence="), action))
+	{
+		if (action == TEXT("None"))
+			Action = EACOConvergenceAction::None;
+		else if (action == TEXT("Throttle"))
+			Action = EACOConvergenceAction::Throttle;
+		else if (action == TEXT("Stop"))
+			Action = EACOConvergenceAction::Stop;
+		else
+		{
+			UE_LOG(LogACO, Error, TEXT("Unknown convergence action %s, expected None, Throttle or Stop"), *action);
+			return false;
+		}
+	}
+
+	if (Window <= 0 || Tolerance < 0.f || ThrottleSleep < 0.f || LogInterval < 0)
+	{
+		UE_LOG(LogACO, Error, TEXT("Invalid convergence criteria!"));
+		return false;
+	}
+	return true;
+}
+
+ACOConvergenceSample::ACOConvergenceSample() : Iteration(0), IterationBestTripCost(MAX_FLT), IterationMeanTripCost(0.f), BestTripCost(MAX_FLT), RouteEntropy(1.f), RouteStability(0), RouteLength(0)
+{
+}
+
+ACOConvergenceTracker::ACOConvergenceTracker() : m_convergenceIteration(0), m_visitStamp(0)
+{
+}
+
+ACOConvergenceTracker::ACOConvergenceTracker(const ACOConvergenceCriteria& criteria) : m_criteria(criteria), m_convergenceIteration(0), m_visitStamp(0)
+{
+}
+
+const ACOConvergenceSample& ACOConvergenceTracker::Update(const ACOColony& colony)
+{
+	TArray<int32> route;
+	m_latestSample.RouteEntropy = extractBestRoute(colony, route);
+	m_latestSample.RouteLength = route.Num();
+	m_latestSample.RouteStability = route.Num() > 0 && route == m_bestRoute ? m_latestSample.RouteStability + 1 : 0;
+	m_bestRoute = MoveTemp(route);
+
+	m_latestSample.Iteration = colony.GetIterationCounter();
+	m_latestSample.IterationBestTripCost = colony.GetIterationBestTripCost();
+	m_latestSample.IterationMeanTripCost = colony.GetIterationMeanTripCost();
+	m_latestSample.BestTripCost = colony.GetBestTripCost();
+
+	//the oldest entry is the best-so-far trip of Window iterations ago
+	float windowStartTripCost = MAX_FLT;
+	if (m_bestTripCosts.Num() == m_criteria.Window)
+	{
+		windowStartTripCost = m_bestTripCosts[0];
+		m_bestTripCosts.RemoveAt(0, 1, false);
+	}
+	m_bestTripCosts.Add(m_latestSample.BestTripCost);
+
+	if (!HasConverged() && m_latestSample.RouteStability >= m_criteria.Window && windowStartTripCost < MAX_FLT
+		&& windowStartTripCost - m_latestSample.BestTripCost <= m_criteria.Tolerance * m_latestSample.BestTripCost)
+	{
+		m_convergenceIteration = m_latestSample.Iteration;
+	}
+	return m_latestSample;
+}
+
+float ACOConvergenceTracker::extractBestRoute(const ACOColony& colony, TArray<int32>& route)
+{
+	const ACOGrid& grid = colony.GetGrid();
+	const ACOParameters& parameters = colony.GetParameters();
+	float entropySum = 0.f;
+	int32 position = colony.GetAnthill();
+	route.Reset();
+
+	++m_visitStamp;
+	if (m_visitStamps.Num() != grid.Num() || m_visitStamp == 0)
+	{
+		m_visitStamps.Init(0, grid.Num());
+		m_visitStamp = 1;
+	}
+
+	while (route.Num() < grid.Num())
+	{
+		route.Push(position);
+		m_visitStamps[position] = m_visitStamp;
+		if (grid.IsFoodSource(position))
+			return route.Num() > 1 ? entropySum / (route.Num() - 1) : 0.f;
+
+		//same weights as the transition rules of the ants
+		float weights[6];
+		int32 candidates[6];
+		int32 amount = 0;
+		float weightSum = 0.f;
+		for (const int32* neighbour = grid.GetNeighboursBegin(position); neighbour != grid.GetNeighboursEnd(position); ++neighbour)
+		{
+			if (m_visitStamps[*neighbour] == m_visitStamp)
+				continue;
+
+			float pheromoneLevel = colony.GetPheromoneLevel(*neighbour) <= 0.0f ? 1.f : colony.GetPheromoneLevel(*neighbour);
+			weights[amount] = FMath::Pow(pheromoneLevel, parameters.TraversePhaseConstantA) * FMath::Pow(1 / grid.GetTerrainCost(*neighbour), parameters.TraversePhaseConstantB);
+			candidates[amount] = *neighbour;
+			weightSum += weights[amount];
+			++amount;
+		}
+		if (amount == 0 || weightSum <= 0.f)
+			break;
+
+		int32 best = 0;
+		float entropy = 0.f;
+		for (int32 i = 0; i < amount; ++i)
+		{
+			float probability = weights[i] / weightSum;
+			if (probability > 0.f)
+				entropy -= probability * FMath::Loge(probability);
+			if (weights[i] > weights[best])
+				best = i;
+		}
+		entropySum += amount > 1 ? entropy / FMath::Loge(static_cast<float>(amount)) : 0.f;
+		position = candidates[best];
+	}
+
+	//dead end, the pheromones don't lead to food (yet)
+	route.Reset();
+	return 1.f;
+}
@@ -0,0 +1,89 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "ACOColony.h"
+
+/** what happens with a colony once it has converged */
+enum class EACOConvergenceAction : uint8
+{
+	/** only report the convergence */
+	None,
+	/** keep iterating, but slower */
+	Throttle,
+	Stop
+};
+
+/**
+ * A colony has converged when its extracted best route didn't change for Window iterations
+ * and the best-so-far trip didn't improve by more than Tolerance (relative) within them.
+ *
+ * Command line syntax: -ConvergenceWindow=50 -ConvergenceTolerance=0.001 -OnConvergence=None|Throttle|Stop -ACOLogInterval=100
+ */
+struct ACO_API ACOConvergenceCriteria
+{
+	ACOConvergenceCriteria();
+
+	int32 Window;
+	float Tolerance;
+	EACOConvergenceAction Action;
+	/** seconds a throttled worker sleeps per iteration */
+	float ThrottleSleep;
+	/** iterations between two progress logs, 0 = only log the convergence */
+	int32 LogInterval;
+
+	/** keeps the defaults of missing values, returns false on invalid values */
+	bool Parse(const TCHAR* stream);
+};
+
+/** convergence metrics of one colony after an iteration */
+struct ACOConvergenceSample
+{
+	ACOConvergenceSample();
+
+	int32 Iteration;
+	float IterationBestTripCost;
+	float IterationMeanTripCost;
+	float BestTripCost;
+	/** mean normalised entropy [0, 1] of the transition probabilities along the best route, 0 = every ant takes the route */
+	float RouteEntropy;
+	/** amount of iterations the best route has been unchanged */
+	int32 RouteStability;
+	/** cells of the best route, 0 if the pheromones don't lead to a food source */
+	int32 RouteLength;
+};
+
+/**
+ * Collects the convergence metrics of one colony, has to be updated once after every finished iteration.
+ * The best route is the greedy walk along the highest transition weight from the anthill to a food source,
+ * this costs only a few hundred cell lookups compared to the A* of the visualization.
+ */
+class ACO_API ACOConvergenceTracker
+{
+public:
+	ACOConvergenceTracker();
+	explicit ACOConvergenceTracker(const ACOConvergenceCriteria& criteria);
+
+	const ACOConvergenceSample& Update(const ACOColony& colony);
+
+	bool HasConverged() const { return m_convergenceIteration > 0; }
+	/** iteration the colony converged at, 0 if it hasn't yet */
+	int32 GetConvergenceIteration() const { return m_convergenceIteration; }
+	const ACOConvergenceSample& GetLatestSample() const { return m_latestSample; }
+	const ACOConvergenceCriteria& GetCriteria() const { return m_criteria; }
+	const TArray<int32>& GetBestRoute() const { return m_bestRoute; }
+
+protected:
+	/** returns the mean normalised entropy of the transitions along the route */
+	float extractBestRoute(const ACOColony& colony, TArray<int32>& route);
+
+	ACOConvergenceCriteria m_criteria;
+	ACOConvergenceSample m_latestSample;
+	TArray<int32> m_bestRoute;
+	/** best-so-far trip costs of the last Window iterations, oldest first */
+	TArray<float> m_bestTripCosts;
+	int32 m_convergenceIteration;
+	/** the cells of the current route are stamped with m_visitStamp, so the visited cells never have to be cleared */
+	TArray<uint32> m_visitStamps;
+	uint32 m_visitStamp;
+};
@@ -0,0 +1,163 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ACO.h"
+#include "ACODeterminismCommandlet.h"
+#include "ACOColony.h"
+#include "Async/ParallelFor.h"
+
+namespace
+{
+	/** [X, Y) of the range of the worker, the ranges are contiguous like the ones of ACOWorker */
+	FIntPoint getRange(int32 amount, int32 workers, int32 worker)
+	{
+		return FIntPoint(amount * worker / workers, amount * (worker + 1) / workers);
+	}
+
+	/**
+	 * runs a colony per anthill on one interleaved field like ACOWorker, with one task per worker range,
+	 * returns the hash of the field and the best trips
+	 */
+	uint32 runColonies(const ACOGrid& grid, const ACOParameters& parameters, int32 iterations, int32 workers)
+	{
+		ACOPheromoneField pheromoneField;
+		pheromoneField.Init(grid.Num(), grid.Anthills.Num(), parameters.PheromoneStorage, parameters.Deterministic);
+		TArray<TUniquePtr<ACOColony>> colonies;
+		TArray<ACOParameters> channelParameters;
+		for (int32 channel = 0; channel < grid.Anthills.Num(); ++channel)
+		{
+			colonies.Emplace(new ACOColony(grid, pheromoneField, channel, grid.Anthills[channel], parameters));
+			channelParameters.Add(parameters);
+		}
+		TArray<FRandomStream> randomStreams;
+		TArray<ACOTripStatistics> statistics;
+		statistics.SetNum(workers);
+		//the worker streams get different seeds on purpose, a deterministic colony mustn't use them
+		for (int32 worker = 0; worker < workers; ++worker)
+			randomStreams.Add(FRandomStream(1610585006 * (worker + 1) + FDateTime::Now().GetMillisecond()));
+
+		const bool isSingleThreaded = workers == 1;
+		for (int32 iteration = 0; iteration < iterations; ++iteration)
+		{
+			//every worker moves its range of the ants of all colonies, the colonies deposit into their channels of the shared field
+			ParallelFor(workers, [&](int32 worker)
+			{
+				for (auto& colony : colonies)
+				{
+					const FIntPoint ants = getRange(colony->GetAntAmount(), workers, worker);
+					colony->TraverseAnts(ants.X, ants.Y, randomStreams[worker], statistics[worker]);
+				}
+			}, isSingleThreaded);
+			ParallelFor(workers, [&](int32 worker)
+			{
+				for (auto& colony : colonies)
+				{
+					const FIntPoint ants = getRange(colony->GetAntAmount(), workers, worker);
+					colony->MarkAnts(ants.X, ants.Y);
+				}
+			}, isSingleThreaded);
+			ParallelFor(workers, [&](int32 worker)
+			{
+				const FIntPoint cells = getRange(grid.Num(), workers, worker);
+				DispatchACOVariant(parameters.Variant, [&](auto policies)
+				{
+					pheromoneField.Evaporate<typename decltype(policies)::Evaporation>(cells.X, cells.Y, channelParameters.GetData());
+				});
+			}, isSingleThreaded);
+			for (auto& colony : colonies)
+				colony->FinishIteration();
+		}
+
+		uint32 hash = pheromoneField.GetHash();
+		for (const auto& colony : colonies)
+		{
+			const float bestTripCost = colony->GetBestTripCost();
+			hash = FCrc::MemCrc32(&bestTripCost, sizeof(float), hash);
+		}
+		return hash;
+	}
+}
+
+UACODeterminismCommandlet::UACODeterminismCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UACODeterminismCommandlet::Main(const FString& Params)
+{
+	ACOParameters parameters;
+	parameters.Deterministic = true;
+	parameters.Seed = 1;
+	parameters.AntAmount = 5000;
+	FParse::Value(*Params, TEXT("-Seed="), parameters.Seed);
+	FParse::Value(*Params, TEXT("-Ants="), parameters.AntAmount);
+	parameters.EventDriven = FParse::Param(*Params, TEXT("EventDriven"));
+	FString pheromoneStorage;
+	if (FParse::Value(*Params, TEXT("-PheromoneStorage="), pheromoneStorage) && !ACOParameters::ParsePheromoneStorage(pheromoneStorage, parameters.PheromoneStorage))
+	{
+		UE_LOG(LogACO, Error, TEXT("Unknown pheromone storage %s"), *pheromoneStorage);
+		return 1;
+	}
+	int32 iterations = 200;
+	FParse::Value(*Params, TEXT("-Iterations="), iterations);
+
+	//<columns>x<rows>[@seed] like the maps of ACOBatchRunner
+	FString map = TEXT("128x128@1");
+	FParse::Value(*Params, TEXT("-Map="), map);
+	FString size = map, mapSeed = TEXT("1"), columns, rows;
+	map.Split(TEXT("@"), &size, &mapSeed);
+	if (!size.Split(TEXT("x"), &columns, &rows) || FCString::Atoi(*columns) <= 0 || FCString::Atoi(*rows) <= 0)
+	{
+		UE_LOG(LogACO, Error, TEXT("Invalid map %s, expected <columns>x<rows>[@seed]"), *map);
+		return 1;
+	}
+	//the colonies of several anthills share one interleaved field, so their deposits have to stay independent of the workers too
+	int32 anthills = 3;
+	FParse::Value(*Params, TEXT("-Anthills="), anthills);
+	const ACOGrid grid = ACOGrid::CreateGenerated(FIntPoint(FCString::Atoi(*columns), FCString::Atoi(*rows)), FCString::Atoi(*mapSeed), 3, anthills);
+	if (grid.Anthills.Num() == 0 || grid.FoodSources.Num() == 0)
+	{
+		UE_LOG(LogACO, Error, TEXT("Map %s has no anthill or food source!"), *map);
+		return 1;
+	}
+
+	FString workerList = FString::Printf(TEXT("1,4,%d"), FMath::Max(FPlatformMisc::NumberOfCoresIncludingHyperthreads(), 2));
+	FParse::Value(*Params, TEXT("-Workers="), workerList, false);
+	TArray<FString> workerValues;
+	workerList.ParseIntoArray(workerValues, TEXT(","), true);
+	TArray<int32> workerAmounts;
+	for (const auto& value : workerValues)
+		workerAmounts.Add(FMath::Max(FCString::Atoi(*value), 1));
+
+	FString variants = TEXT("AntSystem,AntColonySystem,MaxMin,RankBased");
+	FParse::Value(*Params, TEXT("-Variants="), variants, false);
+	TArray<FString> variantNames;
+	variants.ParseIntoArray(variantNames, TEXT(","), true);
+
+	bool isDeterministic = true;
+	for (const auto& name : variantNames)
+	{
+		if (!ACOParameters::ParseVariant(name, parameters.Variant))
+		{
+			UE_LOG(LogACO, Error, TEXT("Unknown ACO variant %s"), *name);
+			return 1;
+		}
+
+		TArray<uint32> hashes;
+		FString hashList;
+		for (int32 workers : workerAmounts)
+		{
+			hashes.Add(runColonies(grid, parameters, iterations, workers));
+			hashList += FString::Printf(TEXT(" %d workers: %08x"), workers, hashes.Last());
+		}
+		const bool isEqual = !hashes.ContainsByPredicate([&hashes](uint32 hash) { return hash != hashes[0]; });
+		isDeterministic &= isEqual;
+		if (isEqual)
+			UE_LOG(LogACO, Log, TEXT("%s with %d colonies is deterministic after %d iterations:%s"), *name, grid.Anthills.Num(), iterations, *hashList);
+		else
+			UE_LOG(LogACO, Error, TEXT("%s with %d colonies depends on the amount of workers after %d iterations:%s"), *name, grid.Anthills.Num(), iterations, *hashList);
+	}
+	return isDeterministic ? 0 : 1;
+}
@@ -0,0 +1,25 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+#include "ACODeterminismCommandlet.generated.h"
+
+/**
+ * Checks that deterministic colonies (ACOParameters::Deterministic) don't depend on the amount of workers.
+ * Every variant runs with each amount of workers, the ants and cells are split into that many ranges like ACOWorker does,
+ * and the hashes of the pheromone fields have to be equal. Returns 1 if they differ.
+ * The map has -Anthills anthills, their colonies share one interleaved ACOPheromoneField like the ones of ACOWorker.
+ * UE4Editor-Cmd.exe ACO.uproject -run=ACODeterminism -Map=128x128@1 -Anthills=3 -Ants=5000 -Iterations=200 -Workers=1,4,16
+ * -Variants=AntSystem,AntColonySystem,MaxMin,RankBased -PheromoneStorage=Float -EventDriven -Seed=1
+ */
+UCLASS()
+class UACODeterminismCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UACODeterminismCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,110 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ACO.h"
+#include "ACODistanceField.h"
+#include "ACOGrid.h"
+
+ACODistanceField::ACODistanceField() : Source(INDEX_NONE)
+{
+}
+
+void ACODistanceField::Build(const ACOGrid& grid, int32 source)
+{
+	Source = source;
+	Steps.Init(INDEX_NONE, grid.Num());
+	Costs.Init(MAX_FLT, grid.Num());
+	if (!Steps.IsValidIndex(source))
+		return;
+
+	//the neighbours of the grid are walkable, so no further checks are needed
+	TArray<int32> queue;
+	queue.Reserve(grid.Num());
+	queue.Add(source);
+	Steps[source] = 0;
+	for (int32 i = 0; i < queue.Num(); ++i)
+	{
+		const int32 cell = queue[i];
+		for (const int32* neighbour = grid.GetNeighboursBegin(cell); neighbour != grid.GetNeighboursEnd(cell); ++neighbour)
+		{
+			if (Steps[*neighbour] == INDEX_NONE)
+			{
+				Steps[*neighbour] = Steps[cell] + 1;
+				queue.Add(*neighbour);
+			}
+		}
+	}
+
+	CostQueue open;
+	Costs[source] = 0.f;
+	open.emplace(0.f, source);
+	propagateCosts(grid, open);
+}
+
+void ACODistanceField::UpdateTerrainCost(const ACOGrid& grid, int32 cell, float previousTerrainCost)
+{
+	const float terrainCost = grid.GetTerrainCost(cell);
+	if (cell == Source || !IsReachable(cell) || terrainCost == previousTerrainCost)
+		return;
+
+	//every cell whose shortest path may lead through the cell, for a cheaper cell only the cell itself
+	TArray<int32> affectedCells;
+	TSet<int32> isAffected;
+	affectedCells.Add(cell);
+	isAffected.Add(cell);
+	if (terrainCost > previousTerrainCost)
+	{
+		for (int32 i = 0; i < affectedCells.Num(); ++i)
+		{
+			const int32 current = affectedCells[i];
+			for (const int32* neighbour = grid.GetNeighboursBegin(current); neighbour != grid.GetNeighboursEnd(current); ++neighbour)
+			{
+				//the costs were set by exactly this sum when current was the predecessor
+				if (!isAffected.Contains(*neighbour) && Costs[*neighbour] == Costs[current] + grid.GetTerrainCost(*neighbour))
+				{
+					affectedCells.Add(*neighbour);
+					isAffected.Add(*neighbour);
+				}
+			}
+		}
+	}
+
+	for (int32 affectedCell : affectedCells)
+		Costs[affectedCell] = MAX_FLT;
+
+	//restart the search from the unaffected border
+	CostQueue open;
+	for (int32 affectedCell : affectedCells)
+	{
+		for (const int32* neighbour = grid.GetNeighboursBegin(affectedCell); neighbour != grid.GetNeighboursEnd(affectedCell); ++neighbour)
+		{
+			if (Costs[*neighbour] < MAX_FLT)
+				Costs[affectedCell] = FMath::Min(Costs[affectedCell], Costs[*neighbour] + grid.GetTerrainCost(affectedCell));
+		}
+		if (Costs[affectedCell] < MAX_FLT)
+			open.emplace(Costs[affectedCell], affectedCell);
+	}
+	propagateCosts(grid, open);
+}
+
+void ACODistanceField::propagateCosts(const ACOGrid& grid, CostQueue& open)
+{
+	while (!open.empty())
+	{
+		const float cost = open.top().first;
+		const int32 cell = open.top().second;
+		open.pop();
+		//outdated entry, the cell was lowered again after it was queued
+		if (cost > Costs[cell])
+			continue;
+
+		for (const int32* neighbour = grid.GetNeighboursBegin(cell); neighbour != grid.GetNeighboursEnd(cell); ++neighbour)
+		{
+			const float newCost = cost + grid.GetTerrainCost(*neighbour);
+			if (newCost < Costs[*neighbour])
+			{
+				Costs[*neighbour] = newCost;
+				open.emplace(newCost, *neighbour);
+			}
+		}
+	}
+}
@@ -0,0 +1,32 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+#include <queue>
+
+struct ACOGrid;
+
+/**
+ * Shortest distances from one source cell (an anthill) to every cell of a grid.
+ * Steps are hexagon steps (BFS), costs are terrain costs of the entered cells (Dijkstra), the same as ACOColony trip costs.
+ * Cells which can't be reached keep INDEX_NONE / MAX_FLT.
+ */
+struct ACO_API ACODistanceField
+{
+	ACODistanceField();
+
+	void Build(const ACOGrid& grid, int32 source);
+	/** repairs the costs after the terrain cost of a walkable cell changed, the steps stay the same */
+	void UpdateTerrainCost(const ACOGrid& grid, int32 cell, float previousTerrainCost);
+
+	bool IsReachable(int32 cell) const { return Steps[cell] != INDEX_NONE; }
+
+	int32 Source;
+	TArray<int32> Steps;
+	TArray<float> Costs;
+
+private:
+	typedef std::priority_queue<std::pair<float, int32>, std::vector<std::pair<float, int32>>, std::greater<std::pair<float, int32>>> CostQueue;
+
+	/** Dijkstra from the cells which are already in the queue, costs are only lowered */
+	void propagateCosts(const ACOGrid& grid, CostQueue& open);
+};
@@ -0,0 +1,636 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ACO.h"
+#include "ACOGrid.h"
+#include "Async/ParallelFor.h"
+
+namespace
+{
+	template<typename T>
+	void appendValues(TArray<uint8>& data, const T* values, int32 amount)
+	{
+		const int32 offset = data.Num();
+		data.AddUninitialized(amount * sizeof(T));
+		FMemory::Memcpy(data.GetData() + offset, values, amount * sizeof(T));
+	}
+
+	/** copies amount values from the file into the array, false if the file is too short */
+	template<typename T>
+	bool readValues(const TArray<uint8>& data, int64& offset, int32 amount, TArray<T>& values)
+	{
+		if (amount < 0 || offset + static_cast<int64>(amount) * sizeof(T) > data.Num())
+			return false;
+		values.SetNumUninitialized(amount);
+		FMemory::Memcpy(values.GetData(), data.GetData() + offset, amount * sizeof(T));
+		offset += amount * sizeof(T);
+		return true;
+	}
+
+	bool isValidTerrainType(ETerrainType type)
+	{
+		switch (type)
+		{
+		case ETerrainType::TT_Mountain:
+		case ETerrainType::TT_Anthill:
+		case ETerrainType::TT_Street:
+		case ETerrainType::TT_Grass:
+		case ETerrainType::TT_Sand:
+		case ETerrainType::TT_Mud:
+		case ETerrainType::TT_Water:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	/** the cells of a baked grid cover at least 1/16 of the columns and rows they span, m_cellIndices is sized by them */
+	bool isValidGridArea(const TArray<FIntPoint>& coordinates)
+	{
+		FIntPoint size(0, 0);
+		for (const auto& coordinate : coordinates)
+			size = FIntPoint(FMath::Max(size.X, coordinate.X + 1), FMath::Max(size.Y, coordinate.Y + 1));
+		const int64 area = static_cast<int64>(size.X) * size.Y;
+		if (area > 16 * static_cast<int64>(coordinates.Num()) + 65536 || area > MAX_int32)
+			return false;
+
+		//every cell has its own coordinate
+		TArray<uint8> isUsed;
+		isUsed.SetNumZeroed(static_cast<int32>(area));
+		for (const auto& coordinate : coordinates)
+		{
+			const int32 index = coordinate.Y * size.X + coordinate.X;
+			if (isUsed[index])
+				return false;
+			isUsed[index] = 1;
+		}
+		return true;
+	}
+}
+
+ACOGrid::ACOGrid() : Size(0, 0), HexagonExtent(100.f, 86.6f), CoordinateOffset(0, 0)
+{
+}
+
+int32 ACOGrid::GetCellIndex(const FIntPoint& coordinate) const
+{
+	if (coordinate.X < 0 || coordinate.Y < 0 || coordinate.X >= Size.X || coordinate.Y >= Size.Y)
+		return INDEX_NONE;
+	return m_cellIndices[coordinate.Y * Size.X + coordinate.X];
+}
+
+int32 ACOGrid::GetCellIndex(const AHexagon* hexagon) const
+{
+	const int32* cell = m_hexagonIndices.Find(hexagon);
+	return cell ? *cell : INDEX_NONE;
+}
+
+float ACOGrid::GetDistanceHeuristic(int32 start, int32 goal) const
+{
+	return FVector2D::Distance(Locations[start], Locations[goal]) / 10;
+}
+
+const ACODistanceField* ACOGrid::GetAnthillDistances(int32 anthill) const
+{
+	const int32 index = Anthills.Find(anthill);
+	return AnthillDistances.IsValidIndex(index) ? &AnthillDistances[index] : nullptr;
+}
+
+bool ACOGrid::SetTerrainType(int32 cell, ETerrainType type)
+{
+	//the neighbours only contain walkable cells, a changed walkability would need a new grid
+	if (!IsWalkable(cell) || IsAnthill(cell) || type == ETerrainType::TT_Mountain || type == ETerrainType::TT_Anthill)
+		return false;
+
+	const float previousTerrainCost = GetTerrainCost(cell);
+	TerrainTypes[cell] = type;
+	for (auto& distances : AnthillDistances)
+		distances.UpdateTerrainCost(*this, cell, previousTerrainCost);
+	return true;
+}
+
+void ACOGrid::SetFoodSource(int32 cell, bool yesOrNo)
+{
+	if (yesOrNo == IsFoodSource(cell))
+		return;
+
+	m_foodSourceFlags[cell] = yesOrNo ? 1 : 0;
+	if (yesOrNo)
+		FoodSources.Add(cell);
+	else
+		FoodSources.Remove(cell);
+}
+
+void ACOGrid::RenumberCells(const TArray<int32>& order)
+{
+	check(order.Num() == Num());
+	TArray<int32> newCells;
+	newCells.SetNumUninitialized(Num());
+	for (int32 cell = 0; cell < Num(); ++cell)
+		newCells[order[cell]] = cell;
+
+	auto permute = [&order](auto& values)
+	{
+		typename TRemoveReference<decltype(values)>::Type permuted;
+		permuted.Reserve(values.Num());
+		for (int32 oldCell : order)
+			permuted.Add(values[oldCell]);
+		values = MoveTemp(permuted);
+	};
+	permute(Coordinates);
+	permute(Locations);
+	permute(TerrainTypes);
+	permute(m_foodSourceFlags);
+	if (Hexagons.Num() > 0)
+	{
+		permute(Hexagons);
+		for (auto& hexagonIndex : m_hexagonIndices)
+			hexagonIndex.Value = newCells[hexagonIndex.Value];
+	}
+
+	TArray<int32> neighbourOffsets;
+	TArray<int32> neighbours;
+	neighbourOffsets.SetNumUninitialized(Num() + 1);
+	neighbours.Reserve(Neighbours.Num());
+	for (int32 cell = 0; cell < Num(); ++cell)
+	{
+		neighbourOffsets[cell] = neighbours.Num();
+		for (int32 i = NeighbourOffsets[order[cell]]; i < NeighbourOffsets[order[cell] + 1]; ++i)
+			neighbours.Add(newCells[Neighbours[i]]);
+	}
+	neighbourOffsets[Num()] = neighbours.Num();
+	NeighbourOffsets = MoveTemp(neighbourOffsets);
+	Neighbours = MoveTemp(neighbours);
+
+	//the list order is kept, it decides which colony an anthill belongs to
+	for (int32& anthill : Anthills)
+		anthill = newCells[anthill];
+	for (auto& distances : AnthillDistances)
+	{
+		distances.Source = newCells[distances.Source];
+		permute(distances.Steps);
+		permute(distances.Costs);
+	}
+	for (int32& foodSource : FoodSources)
+		foodSource = newCells[foodSource];
+	for (int32& cellIndex : m_cellIndices)
+	{
+		if (cellIndex != INDEX_NONE)
+			cellIndex = newCells[cellIndex];
+	}
+}
+
+ACOGrid ACOGrid::CreateGenerated(const FIntPoint& size, int32 seed, int32 foodSourceAmount, int32 anthillAmount)
+{
+	static const ETerrainType walkableTypes[] = { ETerrainType::TT_Street, ETerrainType::TT_Grass, ETerrainType::TT_Sand, ETerrainType::TT_Mud, ETerrainType::TT_Water };
+
+	FRandomStream randomStream(seed);
+	ACOGrid grid;
+	//a single anthill stays in the center
+	TArray<int32, TInlineAllocator<8>> anthillColumns;
+	for (int32 i = 0; i < anthillAmount; ++i)
+		anthillColumns.AddUnique(size.X * (i + 1) / (anthillAmount + 1));
+
+	for (int y = 0; y < size.Y; ++y)
+	{
+		for (int x = 0; x < size.X; ++x)
+		{
+			ETerrainType type = walkableTypes[randomStream.RandHelper(ARRAY_COUNT(walkableTypes))];
+			if (y == size.Y / 2 && anthillColumns.Contains(x))
+				type = ETerrainType::TT_Anthill;
+			else if (randomStream.FRand() < 0.1f)
+				type = ETerrainType::TT_Mountain;
+			grid.addCell(FIntPoint(x, y), type);
+		}
+	}
+	grid.finalize();
+
+	//place food sources on walkable cells in the outer half of the map, away from every anthill
+	const float minDistance = grid.GetDistanceHeuristic(grid.GetCellIndex(FIntPoint(0, 0)), grid.Anthills[0]) * 0.5f / grid.Anthills.Num();
+	for (int i = 0, tries = 0; i < foodSourceAmount && tries < grid.Num(); ++tries)
+	{
+		int32 cell = randomStream.RandHelper(grid.Num());
+		if (!grid.IsWalkable(cell) || grid.IsAnthill(cell) || grid.IsFoodSource(cell)
+			|| grid.Anthills.ContainsByPredicate([&grid, cell, minDistance](int32 anthill) { return grid.GetDistanceHeuristic(cell, anthill) < minDistance; }))
+			continue;
+		grid.SetFoodSource(cell, true);
+		++i;
+	}
+
+	return grid;
+}
+
+ACOGrid ACOGrid::CreateFromTerrain(const FIntPoint& size, TArray<ETerrainType>&& terrainTypes, const TArray<int32>& foodSources)
+{
+	ACOGrid grid;
+	check(terrainTypes.Num() == size.X * size.Y);
+
+	//every cell is part of the grid, so the coordinates follow from the index
+	grid.TerrainTypes = MoveTemp(terrainTypes);
+	grid.Coordinates.SetNumUninitialized(grid.TerrainTypes.Num());
+	grid.m_foodSourceFlags.SetNumZeroed(grid.TerrainTypes.Num());
+	ParallelFor(size.Y, [&grid, &size](int32 y)
+	{
+		for (int32 x = 0; x < size.X; ++x)
+			grid.Coordinates[y * size.X + x] = FIntPoint(x, y);
+	});
+	for (int32 cell = 0; cell < grid.Num(); ++cell)
+	{
+		if (grid.IsAnthill(cell))
+			grid.Anthills.Add(cell);
+	}
+	grid.finalize();
+
+	for (int32 cell : foodSources)
+		grid.SetFoodSource(cell, true);
+	return grid;
+}
+
+ACOGrid ACOGrid::CreateFromHexagons(const TArray<AHexagon*>& hexagons, bool isUsingOverlappingNeighbours)
+{
+	ACOGrid grid;
+	if (hexagons.Num() == 0)
+		return grid;
+
+	FVector extent = hexagons[0]->GetMeshComponent()->GetStaticMesh()->GetBounds().BoxExtent;
+	grid.HexagonExtent = FVector2D(extent.X, extent.Y);
+
+	//the lowest column is kept even so the odd column shift stays the same
+	TArray<FIntPoint> coordinates;
+	FIntPoint minCoordinate(MAX_int32, MAX_int32);
+	for (auto hex : hexagons)
+	{
+		const FIntPoint coordinate = getHexagonCoordinate(hex->GetActorLocation(), grid.HexagonExtent);
+		coordinates.Add(coordinate);
+		minCoordinate = FIntPoint(FMath::Min(minCoordinate.X, coordinate.X), FMath::Min(minCoordinate.Y, coordinate.Y));
+	}
+	minCoordinate.X -= FMath::Abs(minCoordinate.X % 2);
+	grid.CoordinateOffset = minCoordinate;
+
+	for (int32 cell = 0; cell < hexagons.Num(); ++cell)
+	{
+		AHexagon* hex = hexagons[cell];
+		grid.addCell(coordinates[cell] - minCoordinate, hex->GetTerrainType());
+		grid.Hexagons.Add(hex);
+		grid.Locations.Add(FVector2D(hex->GetActorLocation().X, hex->GetActorLocation().Y));
+		grid.m_hexagonIndices.Add(hex, cell);
+		if (hex->IsFoodSource())
+			grid.SetFoodSource(cell, true);
+	}
+
+	//the overlaps are only known in a running world, otherwise finalize derives the neighbours from the coordinates
+	if (isUsingOverlappingNeighbours)
+	{
+		grid.NeighbourOffsets.SetNumUninitialized(grid.Num() + 1);
+		for (int32 cell = 0; cell < grid.Num(); ++cell)
+		{
+			grid.NeighbourOffsets[cell] = grid.Neighbours.Num();
+			for (auto neighbour : hexagons[cell]->GetNeighbourHexagons())
+			{
+				int32 neighbourCell = grid.GetCellIndex(neighbour);
+				if (neighbourCell != INDEX_NONE)
+					grid.Neighbours.Add(neighbourCell);
+			}
+		}
+		grid.NeighbourOffsets[grid.Num()] = grid.Neighbours.Num();
+	}
+
+	grid.finalize();
+	return grid;
+}
+
+ACOGrid ACOGrid::CreateCoarse(const ACOGrid& grid, int32 factor, TArray<int32>& superCells)
+{
+	static const ETerrainType walkableTypes[] = { ETerrainType::TT_Street, ETerrainType::TT_Grass, ETerrainType::TT_Sand, ETerrainType::TT_Mud, ETerrainType::TT_Water };
+	static const uint8 AnthillFlag = 1;
+	static const uint8 FoodSourceFlag = 2;
+
+	factor = FMath::Max(2, factor + factor % 2);
+	const FIntPoint size((grid.Size.X + factor - 1) / factor, (grid.Size.Y + factor - 1) / factor);
+	const int32 blocks = size.X * size.Y;
+
+	TArray<int32> blockIndices;
+	blockIndices.SetNumUninitialized(grid.Num());
+	TArray<int32> cellCounts;
+	TArray<int32> walkableCounts;
+	TArray<float> costSums;
+	TArray<uint8> flags;
+	cellCounts.SetNumZeroed(blocks);
+	walkableCounts.SetNumZeroed(blocks);
+	costSums.SetNumZeroed(blocks);
+	flags.SetNumZeroed(blocks);
+	for (int32 cell = 0; cell < grid.Num(); ++cell)
+	{
+		const int32 block = (grid.Coordinates[cell].Y / factor) * size.X + grid.Coordinates[cell].X / factor;
+		blockIndices[cell] = block;
+		++cellCounts[block];
+		if (grid.IsAnthill(cell))
+		{
+			flags[block] |= AnthillFlag;
+		}
+		else if (grid.IsWalkable(cell))
+		{
+			++walkableCounts[block];
+			costSums[block] += grid.GetTerrainCost(cell);
+		}
+		if (grid.IsFoodSource(cell))
+			flags[block] |= FoodSourceFlag;
+	}
+
+	ACOGrid coarse;
+	coarse.HexagonExtent = grid.HexagonExtent * factor;
+	TArray<int32> blockCells;
+	blockCells.Init(INDEX_NONE, blocks);
+	TArray<int32> foodSources;
+	for (int32 block = 0; block < blocks; ++block)
+	{
+		if (cellCounts[block] == 0)
+			continue;
+
+		ETerrainType type = ETerrainType::TT_Mountain;
+		if (flags[block] & AnthillFlag)
+		{
+			type = ETerrainType::TT_Anthill;
+		}
+		else if ((flags[block] & FoodSourceFlag) || walkableCounts[block] * 2 > cellCounts[block])
+		{
+			const float meanCost = walkableCounts[block] > 0 ? costSums[block] / walkableCounts[block] : 0.f;
+			type = walkableTypes[0];
+			for (ETerrainType walkableType : walkableTypes)
+			{
+				if (FMath::Abs(static_cast<float>(walkableType) - meanCost) < FMath::Abs(static_cast<float>(type) - meanCost))
+					type = walkableType;
+			}
+		}
+
+		blockCells[block] = coarse.Num();
+		//a food source in the block of the anthill would end every trip at once, the anthill wins
+		if ((flags[block] & FoodSourceFlag) && type != ETerrainType::TT_Anthill)
+			foodSources.Add(coarse.Num());
+		coarse.addCell(FIntPoint(block % size.X, block / size.X), type);
+	}
+	coarse.finalize();
+	for (int32 cell : foodSources)
+		coarse.SetFoodSource(cell, true);
+
+	superCells.SetNumUninitialized(grid.Num());
+	for (int32 cell = 0; cell < grid.Num(); ++cell)
+		superCells[cell] = blockCells[blockIndices[cell]];
+	return coarse;
+}
+
+FString ACOGrid::GetBakedFilename(const UWorld* world)
+{
+	return FPaths::GameContentDir() / TEXT("ACO") / UWorld::RemovePIEPrefix(world->GetMapName()) + TEXT(".acogrid");
+}
+
+bool ACOGrid::SaveBaked(const FString& filename) const
+{
+	ACOGridFileHeader header;
+	header.Magic = Magic;
+	header.Version = Version;
+	header.Cells = Num();
+	header.Neighbours = Neighbours.Num();
+	header.Anthills = Anthills.Num();
+	header.FoodSources = FoodSources.Num();
+	header.CoordinateOffset = CoordinateOffset;
+	header.HexagonExtent = HexagonExtent;
+
+	TArray<uint8> data;
+	data.Reserve(sizeof(header) + Num() * (sizeof(FIntPoint) + sizeof(FVector2D) + sizeof(int32) + Anthills.Num() * 2 * sizeof(int32) + 1) + Neighbours.Num() * sizeof(int32));
+	appendValues(data, &header, 1);
+	appendValues(data, Coordinates.GetData(), Num());
+	appendValues(data, Locations.GetData(), Num());
+	appendValues(data, NeighbourOffsets.GetData(), Num() + 1);
+	appendValues(data, Neighbours.GetData(), Neighbours.Num());
+	appendValues(data, Anthills.GetData(), Anthills.Num());
+	appendValues(data, FoodSources.GetData(), FoodSources.Num());
+	for (const auto& distances : AnthillDistances)
+	{
+		appendValues(data, distances.Steps.GetData(), Num());
+		appendValues(data, distances.Costs.GetData(), Num());
+	}
+	appendValues(data, TerrainTypes.GetData(), Num());
+
+	if (!FFileHelper::SaveArrayToFile(data, *filename))
+	{
+		UE_LOG(LogACO, Error, TEXT("Couldn't write the baked grid %s!"), *filename);
+		return false;
+	}
+	UE_LOG(LogACO, Log, TEXT("Grid with %d cells baked to %s"), Num(), *filename);
+	return true;
+}
+
+bool ACOGrid::LoadBaked(const FString& filename, ACOGrid& grid)
+{
+	TArray<uint8> data;
+	if (!FFileHelper::LoadFileToArray(data, *filename, FILEREAD_Silent))
+		return false;
+
+	ACOGridFileHeader header;
+	if (data.Num() < sizeof(header))
+	{
+		UE_LOG(LogACO, Error, TEXT("Baked grid %s is truncated!"), *filename);
+		return false;
+	}
+	FMemory::Memcpy(&header, data.GetData(), sizeof(header));
+	if (header.Magic != Magic || header.Version != Version)
+	{
+		UE_LOG(LogACO, Error, TEXT("%s is no baked grid of version %u!"), *filename, Version);
+		return false;
+	}
+
+	ACOGrid loaded;
+	int64 offset = sizeof(header);
+	bool isValid = readValues(data, offset, header.Cells, loaded.Coordinates) && readValues(data, offset, header.Cells, loaded.Locations)
+		&& readValues(data, offset, header.Cells + 1, loaded.NeighbourOffsets) && readValues(data, offset, header.Neighbours, loaded.Neighbours)
+		&& readValues(data, offset, header.Anthills, loaded.Anthills) && readValues(data, offset, header.FoodSources, loaded.FoodSources);
+	loaded.AnthillDistances.SetNum(isValid ? header.Anthills : 0);
+	for (int32 i = 0; i < loaded.AnthillDistances.Num() && isValid; ++i)
+	{
+		loaded.AnthillDistances[i].Source = loaded.Anthills[i];
+		isValid = readValues(data, offset, header.Cells, loaded.AnthillDistances[i].Steps) && readValues(data, offset, header.Cells, loaded.AnthillDistances[i].Costs);
+	}
+	isValid = isValid && readValues(data, offset, header.Cells, loaded.TerrainTypes);
+
+	//indices are checked once here, the colonies trust them
+	for (int32 i = 0; isValid && i < loaded.Neighbours.Num(); ++i)
+		isValid = loaded.Neighbours[i] >= 0 && loaded.Neighbours[i] < header.Cells;
+	for (int32 cell = 0; isValid && cell <= header.Cells; ++cell)
+		isValid = loaded.NeighbourOffsets[cell] >= (cell > 0 ? loaded.NeighbourOffsets[cell - 1] : 0) && loaded.NeighbourOffsets[cell] <= header.Neighbours;
+	for (int32 i = 0; isValid && i < loaded.Anthills.Num(); ++i)
+		isValid = loaded.Anthills[i] >= 0 && loaded.Anthills[i] < header.Cells;
+	for (int32 i = 0; isValid && i < loaded.FoodSources.Num(); ++i)
+		isValid = loaded.FoodSources[i] >= 0 && loaded.FoodSources[i] < header.Cells;
+	for (int32 i = 0; isValid && i < loaded.Coordinates.Num(); ++i)
+		isValid = loaded.Coordinates[i].X >= 0 && loaded.Coordinates[i].Y >= 0 && loaded.Coordinates[i].X < MAX_int32 / 2 && loaded.Coordinates[i].Y < MAX_int32 / 2;
+	isValid = isValid && isValidGridArea(loaded.Coordinates);
+	//the anthills are exactly the cells with anthill terrain, like the ones CreateFromTerrain finds
+	int32 anthillCells = 0;
+	for (int32 cell = 0; isValid && cell < header.Cells; ++cell)
+	{
+		isValid = isValidTerrainType(loaded.TerrainTypes[cell]);
+		anthillCells += loaded.TerrainTypes[cell] == ETerrainType::TT_Anthill ? 1 : 0;
+	}
+	isValid = isValid && anthillCells == loaded.Anthills.Num();
+	for (int32 i = 0; isValid && i < loaded.Anthills.Num(); ++i)
+		isValid = loaded.TerrainTypes[loaded.Anthills[i]] == ETerrainType::TT_Anthill && loaded.Anthills.Find(loaded.Anthills[i]) == i;
+	if (!isValid)
+	{
+		UE_LOG(LogACO, Error, TEXT("Baked grid %s is truncated or broken!"), *filename);
+		return false;
+	}
+
+	loaded.HexagonExtent = header.HexagonExtent;
+	loaded.CoordinateOffset = header.CoordinateOffset;
+	const TArray<int32> foodSources = MoveTemp(loaded.FoodSources);
+	loaded.FoodSources.Reset();
+	loaded.m_foodSourceFlags.SetNumZeroed(header.Cells);
+	loaded.finalize();
+	for (int32 cell : foodSources)
+		loaded.SetFoodSource(cell, true);
+	grid = MoveTemp(loaded);
+	return true;
+}
+
+bool ACOGrid::AttachHexagons(const TArray<AHexagon*>& hexagons)
+{
+	if (hexagons.Num() != Num())
+		return false;
+
+	//the world is only read, every hexagon finds its cell on its own
+	TArray<int32> cells;
+	cells.SetNumUninitialized(hexagons.Num());
+	FThreadSafeCounter mismatches;
+	ParallelFor(hexagons.Num(), [&](int32 i)
+	{
+		cells[i] = GetCellIndex(getHexagonCoordinate(hexagons[i]->GetActorLocation(), HexagonExtent) - CoordinateOffset);
+		if (cells[i] == INDEX_NONE || TerrainTypes[cells[i]] != hexagons[i]->GetTerrainType())
+			mismatches.Increment();
+	});
+	if (mismatches.GetValue() > 0)
+		return false;
+
+	Hexagons.Init(nullptr, Num());
+	m_hexagonIndices.Reset();
+	m_hexagonIndices.Reserve(Num());
+	for (int32 i = 0; i < hexagons.Num(); ++i)
+	{
+		//two hexagons on one cell
+		if (Hexagons[cells[i]])
+		{
+			Hexagons.Reset();
+			m_hexagonIndices.Reset();
+			return false;
+		}
+		Hexagons[cells[i]] = hexagons[i];
+		m_hexagonIndices.Add(hexagons[i], cells[i]);
+		if (hexagons[i]->IsFoodSource())
+			SetFoodSource(cells[i], true);
+	}
+	return true;
+}
+
+FIntPoint ACOGrid::getHexagonCoordinate(const FVector& location, const FVector2D& extent)
+{
+	const int32 column = FMath::RoundToInt(location.X / (1.5f * extent.X));
+	const int32 row = FMath::RoundToInt((location.Y + (column % 2 != 0 ? extent.Y : 0.f)) / (2 * extent.Y));
+	return FIntPoint(column, row);
+}
+
+void ACOGrid::addCell(const FIntPoint& coordinate, ETerrainType type)
+{
+	int32 cell = Num();
+	Coordinates.Add(coordinate);
+	TerrainTypes.Add(type);
+	m_foodSourceFlags.Add(0);
+	if (type == ETerrainType::TT_Anthill)
+		Anthills.Add(cell);
+}
+
+void ACOGrid::finalize()
+{
+	Size = FIntPoint(0, 0);
+	for (const auto& coordinate : Coordinates)
+		Size = FIntPoint(FMath::Max(Size.X, coordinate.X + 1), FMath::Max(Size.Y, coordinate.Y + 1));
+
+	//every cell has its own coordinate, so the cells can be written in parallel
+	m_cellIndices.Init(INDEX_NONE, Size.X * Size.Y);
+	ParallelFor(Num(), [this](int32 cell)
+	{
+		m_cellIndices[Coordinates[cell].Y * Size.X + Coordinates[cell].X] = cell;
+	});
+
+	if (Locations.Num() != Num())
+		buildLocations();
+	if (NeighbourOffsets.Num() != Num() + 1)
+		buildNeighbours();
+	if (AnthillDistances.Num() != Anthills.Num())
+		buildAnthillDistances();
+}
+
+void ACOGrid::buildLocations()
+{
+	Locations.SetNumUninitialized(Num());
+	ParallelFor(Num(), [this](int32 cell)
+	{
+		const FIntPoint& coordinate = Coordinates[cell];
+
+		//same as AGridGenerator::alingHexagons
+		float yCoord = coordinate.Y * (2 * HexagonExtent.Y);
+		float xCoord = coordinate.X * (1.5f * HexagonExtent.X);
+		if (coordinate.X % 2 == 1)
+			yCoord -= HexagonExtent.Y;
+		Locations[cell] = FVector2D(xCoord, yCoord);
+	});
+}
+
+void ACOGrid::buildNeighbours()
+{
+	/* odd columns are shifted up by half a hexagon, so the rows touching a cell in the neighbouring columns are
+	 * even column: y and y + 1
+	 * odd column: y - 1 and y
+	 */
+	static const FIntPoint evenColumnOffsets[] = { FIntPoint(0, -1), FIntPoint(0, 1), FIntPoint(-1, 0), FIntPoint(-1, 1), FIntPoint(1, 0), FIntPoint(1, 1) };
+	static const FIntPoint oddColumnOffsets[] = { FIntPoint(0, -1), FIntPoint(0, 1), FIntPoint(-1, -1), FIntPoint(-1, 0), FIntPoint(1, -1), FIntPoint(1, 0) };
+
+	//same as AHexagon::findNeighbourHexagons, only walkable neighbours are stored
+	auto forEachNeighbour = [this](int32 cell, auto function)
+	{
+		const FIntPoint& coordinate = Coordinates[cell];
+		const FIntPoint* offsets = coordinate.X % 2 == 1 ? oddColumnOffsets : evenColumnOffsets;
+		for (int i = 0; i < 6; ++i)
+		{
+			int32 neighbour = GetCellIndex(coordinate + offsets[i]);
+			if (neighbour != INDEX_NONE && IsWalkable(neighbour))
+				function(neighbour);
+		}
+	};
+
+	//count the neighbours of every cell in parallel, the offsets are their prefix sum, then every cell fills its own row
+	NeighbourOffsets.SetNumUninitialized(Num() + 1);
+	ParallelFor(Num(), [&](int32 cell)
+	{
+		int32 count = 0;
+		forEachNeighbour(cell, [&count](int32 neighbour) { ++count; });
+		NeighbourOffsets[cell + 1] = count;
+	});
+	NeighbourOffsets[0] = 0;
+	for (int32 cell = 0; cell < Num(); ++cell)
+		NeighbourOffsets[cell + 1] += NeighbourOffsets[cell];
+
+	Neighbours.SetNumUninitialized(NeighbourOffsets[Num()]);
+	ParallelFor(Num(), [&](int32 cell)
+	{
+		int32 index = NeighbourOffsets[cell];
+		forEachNeighbour(cell, [this, &index](int32 neighbour) { Neighbours[index++] = neighbour; });
+	});
+}
+
+void ACOGrid::buildAnthillDistances()
+{
+	AnthillDistances.SetNum(Anthills.Num());
+	ParallelFor(Anthills.Num(), [this](int32 i)
+	{
+		AnthillDistances[i].Build(*this, Anthills[i]);
+	});
+}
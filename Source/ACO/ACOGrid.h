@@ -0,0 +1,126 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Hexagon.h"
+#include "ACODistanceField.h"
+
+/**
+ * Baked grid of a level, written by AGridGenerator at edit time and read at once when the ACO starts.
+ * Everything is stored 4 byte aligned in native byte order:
+ *
+ * Header     ACOGridFileHeader
+ * Cells      coordinates [Cells], locations [Cells], neighbour offsets [Cells + 1], neighbours [Neighbours]
+ * Lists      anthills [Anthills], food sources [FoodSources]
+ * Distances  per anthill steps [Cells], costs [Cells]
+ * Terrain    terrain types [Cells]
+ */
+struct ACOGridFileHeader
+{
+	uint32 Magic;
+	uint32 Version;
+	int32 Cells;
+	int32 Neighbours;
+	int32 Anthills;
+	int32 FoodSources;
+	FIntPoint CoordinateOffset;
+	FVector2D HexagonExtent;
+};
+
+/**
+ * Read-only hexagon map which can be shared by any number of colonies.
+ * Cells are addressed by dense indices and the walkable neighbours of every cell are stored in compressed rows.
+ * The layout matches AGridGenerator::alingHexagons (columns along X, odd columns shifted by half a hexagon).
+ */
+struct ACO_API ACOGrid
+{
+	ACOGrid();
+
+	/** column (X) and row (Y) of every cell */
+	TArray<FIntPoint> Coordinates;
+	/** world location of every cell, used for distance heuristics */
+	TArray<FVector2D> Locations;
+	TArray<ETerrainType> TerrainTypes;
+	/** walkable neighbours of cell i are Neighbours[NeighbourOffsets[i]] .. Neighbours[NeighbourOffsets[i + 1] - 1] */
+	TArray<int32> NeighbourOffsets;
+	TArray<int32> Neighbours;
+	TArray<int32> Anthills;
+	/** distances from Anthills[i] to every cell */
+	TArray<ACODistanceField> AnthillDistances;
+	TArray<int32> FoodSources;
+	/** only set if the grid was created from the hexagons of a world */
+	TArray<class AHexagon*> Hexagons;
+
+	/** columns and rows spanned by the coordinates */
+	FIntPoint Size;
+	FVector2D HexagonExtent;
+	/** world column and row of the cell at (0, 0), the coordinates of the hexagons of a world don't start at 0 */
+	FIntPoint CoordinateOffset;
+
+	int32 Num() const { return TerrainTypes.Num(); }
+	float GetTerrainCost(int32 cell) const { return static_cast<float>(TerrainTypes[cell]); }
+	bool IsWalkable(int32 cell) const { return TerrainTypes[cell] != ETerrainType::TT_Mountain; }
+	bool IsAnthill(int32 cell) const { return TerrainTypes[cell] == ETerrainType::TT_Anthill; }
+	bool IsFoodSource(int32 cell) const { return m_foodSourceFlags[cell] != 0; }
+	const int32* GetNeighboursBegin(int32 cell) const { return Neighbours.GetData() + NeighbourOffsets[cell]; }
+	const int32* GetNeighboursEnd(int32 cell) const { return Neighbours.GetData() + NeighbourOffsets[cell + 1]; }
+	int32 GetNeighbourCount(int32 cell) const { return NeighbourOffsets[cell + 1] - NeighbourOffsets[cell]; }
+	/** returns INDEX_NONE for coordinates outside of the grid */
+	int32 GetCellIndex(const FIntPoint& coordinate) const;
+	/** returns INDEX_NONE for hexagons which aren't part of the grid */
+	int32 GetCellIndex(const class AHexagon* hexagon) const;
+	/** same metric as Pathfinding::AStarSearchHeuristic */
+	float GetDistanceHeuristic(int32 start, int32 goal) const;
+	/** distance heuristic of two cells above each other */
+	float GetStepHeuristic() const { return 2 * HexagonExtent.Y / 10; }
+	/** returns nullptr if the cell is no anthill */
+	const ACODistanceField* GetAnthillDistances(int32 anthill) const;
+
+	void SetFoodSource(int32 cell, bool yesOrNo);
+	/** changes the terrain of a walkable cell to another walkable terrain and repairs the anthill distances, returns false for other changes */
+	bool SetTerrainType(int32 cell, ETerrainType type);
+	/**
+	 * stores the cells in the given order, order[newCell] = oldCell, e.g. ACOSpatialPartition::GetCurveOrder.
+	 * All per cell arrays, the neighbours and the anthill/food source lists are remapped, the neighbour order of a cell is kept.
+	 * Has to be done before colonies or pheromone fields use the grid.
+	 */
+	void RenumberCells(const TArray<int32>& order);
+
+	/** creates a size.X * size.Y grid with random terrain, anthillAmount anthills evenly spaced along the middle row and foodSourceAmount food sources */
+	static ACOGrid CreateGenerated(const FIntPoint& size, int32 seed, int32 foodSourceAmount = 3, int32 anthillAmount = 1);
+	/** creates a size.X * size.Y grid from row major terrain types, e.g. of ACOMapImporter */
+	static ACOGrid CreateFromTerrain(const FIntPoint& size, TArray<ETerrainType>&& terrainTypes, const TArray<int32>& foodSources);
+	/** creates a grid from the hexagons of a world, the overlapping neighbours of AHexagon or the ones of the coordinates are used */
+	static ACOGrid CreateFromHexagons(const TArray<class AHexagon*>& hexagons, bool isUsingOverlappingNeighbours = true);
+	/**
+	 * aggregates blocks of factor * factor cells into the super cells of a coarse grid, superCells gets the super cell of every cell.
+	 * A super cell keeps the anthills and food sources of its block and the walkable terrain nearest to the mean cost of the block,
+	 * it is a mountain if most of its cells are. An odd factor is rounded up, so the coarse columns are shifted like the fine ones.
+	 */
+	static ACOGrid CreateCoarse(const ACOGrid& grid, int32 factor, TArray<int32>& superCells);
+
+	static const uint32 Magic = 0x474F4341; //"ACOG"
+	static const uint32 Version = 1;
+	/** Content/ACO/<map>.acogrid, add Content/ACO to the directories which are staged as non asset files */
+	static FString GetBakedFilename(const class UWorld* world);
+	bool SaveBaked(const FString& filename) const;
+	/** reads the whole file at once, the lookup tables are built in parallel */
+	static bool LoadBaked(const FString& filename, ACOGrid& grid);
+	/** assigns the hexagons of the world to the cells of a loaded grid, false if they don't match the baked ones */
+	bool AttachHexagons(const TArray<class AHexagon*>& hexagons);
+
+protected:
+	/** column and row of a hexagon in the world, inverts AGridGenerator::alingHexagons */
+	static FIntPoint getHexagonCoordinate(const FVector& location, const FVector2D& extent);
+	void addCell(const FIntPoint& coordinate, ETerrainType type);
+	/** fills the lookup tables and, if they are not set yet, Locations, NeighbourOffsets, Neighbours and AnthillDistances */
+	void finalize();
+	void buildLocations();
+	void buildNeighbours();
+	void buildAnthillDistances();
+
+	TArray<uint8> m_foodSourceFlags;
+	/** cell index per coordinate, row major over Size */
+	TArray<int32> m_cellIndices;
+	TMap<const class AHexagon*, int32> m_hexagonIndices;
+};
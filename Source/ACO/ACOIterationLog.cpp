@@ -0,0 +1,199 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ACO.h"
+#include "ACOIterationLog.h"
+
+ACOIterationLog::ACOIterationLog() : m_file(nullptr), m_thread(nullptr), m_dataEvent(nullptr), m_pheromoneInterval(100), m_pheromoneThreshold(0.01f),
+	m_maxCellsPerRecord(0), m_previousIterationTime(0.0), m_droppedRecords(0), m_totalDroppedRecords(0)
+{
+}
+
+ACOIterationLog::~ACOIterationLog()
+{
+	Close();
+}
+
+bool ACOIterationLog::OpenFromCommandLine(const TCHAR* stream, int32 cells, int32 channels, int32 colonies)
+{
+	FString filename;
+	if (!FParse::Value(stream, TEXT("ACOLog="), filename))
+		return false;
+
+	int32 bufferMegabytes = 16;
+	FParse::Value(stream, TEXT("ACOLogPheromoneInterval="), m_pheromoneInterval);
+	FParse::Value(stream, TEXT("ACOLogPheromoneThreshold="), m_pheromoneThreshold);
+	FParse::Value(stream, TEXT("ACOLogBufferMB="), bufferMegabytes);
+	return Open(filename, cells, channels, colonies, FMath::Clamp(bufferMegabytes, 1, 1024) * 1024 * 1024);
+}
+
+bool ACOIterationLog::Open(const FString& filename, int32 cells, int32 channels, int32 colonies, int32 bufferSize)
+{
+	Close();
+	m_file = IFileManager::Get().CreateFileWriter(*filename);
+	if (!m_file)
+	{
+		UE_LOG(LogACO, Error, TEXT("Couldn't create ACO log %s!"), *filename);
+		return false;
+	}
+
+	ACOLogHeader header;
+	header.Magic = Magic;
+	header.Version = Version;
+	header.Cells = cells;
+	header.Channels = channels;
+	header.Colonies = colonies;
+	m_file->Serialize(&header, sizeof(header));
+
+	m_ringBuffer.Reset(new ACORingBuffer(bufferSize));
+	m_maxCellsPerRecord = (m_ringBuffer->GetCapacity() / 4 - sizeof(ACOLogRecordHeader) - sizeof(ACOLogPheromoneRecord)) / sizeof(ACOLogPheromoneCell);
+	m_loggedPheromoneLevels.SetNumZeroed(cells * channels);
+	m_previousIterationTime = 0.0;
+	m_droppedRecords = 0;
+	m_totalDroppedRecords = 0;
+
+	m_stopTaskCounter.Reset();
+	m_dataEvent = FPlatformProcess::GetSynchEventFromPool(false);
+	m_thread = FRunnableThread::Create(this, TEXT("ACO_Log_Writer"), 0, TPri_BelowNormal);
+	UE_LOG(LogACO, Log, TEXT("ACO log %s with a %d MB ring buffer opened!"), *filename, m_ringBuffer->GetCapacity() / (1024 * 1024));
+	return true;
+}
+
+void ACOIterationLog::Close()
+{
+	if (m_thread)
+	{
+		Stop();
+		m_thread->WaitForCompletion();
+		delete m_thread;
+		m_thread = nullptr;
+	}
+	if (m_dataEvent)
+	{
+		FPlatformProcess::ReturnSynchEventToPool(m_dataEvent);
+		m_dataEvent = nullptr;
+	}
+	if (m_file)
+	{
+		drain();
+		if (m_totalDroppedRecords > 0)
+			UE_LOG(LogACO, Warning, TEXT("%d records of the ACO log were dropped, increase -ACOLogBufferMB!"), m_totalDroppedRecords);
+		m_file->Close();
+		delete m_file;
+		m_file = nullptr;
+	}
+}
+
+void ACOIterationLog::LogIteration(int32 iteration, const TArray<ACOColony*>& colonies, const ACOPheromoneField& pheromoneField, const ACOIterationTrace& trace)
+{
+	const double now = FPlatformTime::Seconds();
+	for (int32 i = 0; i < colonies.Num(); ++i)
+	{
+		const ACOColony* colony = colonies[i];
+		ACOLogIterationRecord record;
+		record.Iteration = iteration;
+		record.Colony = i;
+		record.FoodFound = colony->GetIterationStatistics().FoodFound;
+		record.ReturnedHome = colony->GetIterationStatistics().ReturnedHome;
+		record.IterationBestTripCost = colony->GetIterationBestTripCost();
+		record.BestTripCost = colony->GetBestTripCost();
+		record.MeanTripCost = colony->GetIterationMeanTripCost();
+		record.IterationMilliseconds = m_previousIterationTime > 0.0 ? (now - m_previousIterationTime) * 1000.0 : 0.f;
+		for (int32 phase = 0; phase < static_cast<int32>(EACOPhase::Num); ++phase)
+			record.PhaseMilliseconds[phase] = trace.PhaseSeconds[phase] * 1000.0;
+		push(EACOLogRecord::Iteration, &record, sizeof(record));
+	}
+	m_previousIterationTime = now;
+
+	if (m_pheromoneInterval > 0 && iteration % m_pheromoneInterval == 0)
+		logPheromoneDeltas(iteration, pheromoneField);
+}
+
+void ACOIterationLog::logPheromoneDeltas(int32 iteration, const ACOPheromoneField& pheromoneField)
+{
+	const int32 channels = pheromoneField.GetChannelAmount();
+	for (int32 channel = 0; channel < channels; ++channel)
+	{
+		m_pheromoneRecord.SetNumUninitialized(sizeof(ACOLogPheromoneRecord), false);
+		for (int32 cell = 0; cell < pheromoneField.Num(); ++cell)
+		{
+			const float level = pheromoneField.GetPheromoneLevel(cell, channel);
+			if (FMath::Abs(level - m_loggedPheromoneLevels[cell * channels + channel]) <= m_pheromoneThreshold)
+				continue;
+
+			ACOLogPheromoneCell changedCell = { cell, level };
+			const int32 offset = m_pheromoneRecord.AddUninitialized(sizeof(changedCell));
+			FMemory::Memcpy(m_pheromoneRecord.GetData() + offset, &changedCell, sizeof(changedCell));
+			if ((m_pheromoneRecord.Num() - sizeof(ACOLogPheromoneRecord)) / sizeof(ACOLogPheromoneCell) == m_maxCellsPerRecord)
+			{
+				pushPheromoneRecord(iteration, channel, channels);
+				m_pheromoneRecord.SetNumUninitialized(sizeof(ACOLogPheromoneRecord), false);
+			}
+		}
+		if (m_pheromoneRecord.Num() > sizeof(ACOLogPheromoneRecord))
+			pushPheromoneRecord(iteration, channel, channels);
+	}
+}
+
+void ACOIterationLog::pushPheromoneRecord(int32 iteration, int32 channel, int32 channels)
+{
+	ACOLogPheromoneRecord record;
+	record.Iteration = iteration;
+	record.Channel = channel;
+	record.Amount = (m_pheromoneRecord.Num() - sizeof(ACOLogPheromoneRecord)) / sizeof(ACOLogPheromoneCell);
+	FMemory::Memcpy(m_pheromoneRecord.GetData(), &record, sizeof(record));
+	if (!push(EACOLogRecord::Pheromones, m_pheromoneRecord.GetData(), m_pheromoneRecord.Num()))
+		return;
+
+	//a dropped record leaves the logged levels as they were, so its cells are logged again with the next delta
+	const ACOLogPheromoneCell* cells = reinterpret_cast<const ACOLogPheromoneCell*>(m_pheromoneRecord.GetData() + sizeof(ACOLogPheromoneRecord));
+	for (int32 i = 0; i < record.Amount; ++i)
+		m_loggedPheromoneLevels[cells[i].Cell * channels + channel] = cells[i].PheromoneLevel;
+}
+
+bool ACOIterationLog::push(EACOLogRecord type, const void* payload, int32 payloadSize)
+{
+	ACOLogRecordHeader header;
+	header.Reserved = 0;
+	if (m_droppedRecords > 0)
+	{
+		header.Type = static_cast<uint16>(EACOLogRecord::Dropped);
+		header.Size = sizeof(int32);
+		if (m_ringBuffer->Push(&header, sizeof(header), &m_droppedRecords, sizeof(int32)))
+			m_droppedRecords = 0;
+	}
+
+	header.Type = static_cast<uint16>(type);
+	header.Size = payloadSize;
+	if (!m_ringBuffer->Push(&header, sizeof(header), payload, payloadSize))
+	{
+		++m_droppedRecords;
+		++m_totalDroppedRecords;
+		return false;
+	}
+	return true;
+}
+
+uint32 ACOIterationLog::Run()
+{
+	while (m_stopTaskCounter.GetValue() == 0)
+	{
+		m_dataEvent->Wait(20u);
+		drain();
+	}
+	return 0;
+}
+
+void ACOIterationLog::Stop()
+{
+	m_stopTaskCounter.Increment();
+	if (m_dataEvent)
+		m_dataEvent->Trigger();
+}
+
+void ACOIterationLog::drain()
+{
+	m_ringBuffer->Consume([this](const uint8* data, int64 size)
+	{
+		m_file->Serialize(const_cast<uint8*>(data), size);
+	});
+}
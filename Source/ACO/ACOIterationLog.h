@@ -0,0 +1,125 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "ACORingBuffer.h"
+#include "ACOColony.h"
+
+/**
+ * Binary iteration log, native byte order:
+ *
+ * File      ACOLogHeader, then records
+ * Record    ACOLogRecordHeader, then Size bytes of payload
+ *           Iteration:  ACOLogIterationRecord
+ *           Pheromones: ACOLogPheromoneRecord, then Amount * ACOLogPheromoneCell
+ *           Dropped:    int32 amount of records which didn't fit into the ring buffer since the last Dropped record
+ */
+struct ACOLogHeader
+{
+	uint32 Magic;
+	uint32 Version;
+	int32 Cells;
+	int32 Channels;
+	int32 Colonies;
+};
+
+enum class EACOLogRecord : uint16
+{
+	Iteration = 1,
+	Pheromones = 2,
+	Dropped = 3
+};
+
+struct ACOLogRecordHeader
+{
+	uint16 Type;
+	uint16 Reserved;
+	int32 Size;
+};
+
+struct ACOLogIterationRecord
+{
+	int32 Iteration;
+	int32 Colony;
+	int32 FoodFound;
+	int32 ReturnedHome;
+	float IterationBestTripCost;
+	float BestTripCost;
+	float MeanTripCost;
+	/** wall clock time since the previous iteration */
+	float IterationMilliseconds;
+	/** of the worker which logs the iteration */
+	float PhaseMilliseconds[static_cast<int32>(EACOPhase::Num)];
+};
+
+struct ACOLogPheromoneRecord
+{
+	int32 Iteration;
+	int32 Channel;
+	int32 Amount;
+};
+
+struct ACOLogPheromoneCell
+{
+	int32 Cell;
+	float PheromoneLevel;
+};
+
+/**
+ * Streams ACOLogIterationRecords and sparse pheromone deltas to a file.
+ * The iteration is logged by one thread at a time (ACOWorker::updateThingsByOneWorker), the records go through a lock free
+ * ring buffer to a writer thread, so the workers never wait for the disk. If the writer falls behind, records are dropped and counted.
+ *
+ * -ACOLog=<file> -ACOLogPheromoneInterval=100 -ACOLogPheromoneThreshold=0.01 -ACOLogBufferMB=16
+ */
+class ACO_API ACOIterationLog : public FRunnable
+{
+public:
+	static const uint32 Magic = 0x4C4F4341; //"ACOL"
+	static const uint32 Version = 1;
+
+	ACOIterationLog();
+	~ACOIterationLog();
+
+	/** opens the file of -ACOLog and starts the writer thread, returns false if there is no -ACOLog or it couldn't be opened */
+	bool OpenFromCommandLine(const TCHAR* stream, int32 cells, int32 channels, int32 colonies);
+	bool Open(const FString& filename, int32 cells, int32 channels, int32 colonies, int32 bufferSize);
+	/** writes the remaining records and stops the writer thread */
+	void Close();
+	bool IsOpen() const { return m_file != nullptr; }
+
+	/** producer side, logs one record per colony and, every pheromone interval, the changed pheromone levels */
+	void LogIteration(int32 iteration, const TArray<ACOColony*>& colonies, const ACOPheromoneField& pheromoneField, const ACOIterationTrace& trace);
+
+	//Begin FRunnable Methods
+	uint32 Run() override;
+	void Stop() override;
+	//End
+
+private:
+	/** records which don't fit into the ring buffer are counted and reported with the next record which fits, returns false for a dropped record */
+	bool push(EACOLogRecord type, const void* payload, int32 payloadSize);
+	void logPheromoneDeltas(int32 iteration, const ACOPheromoneField& pheromoneField);
+	/** the cells of the record count as logged once it is in the ring buffer */
+	void pushPheromoneRecord(int32 iteration, int32 channel, int32 channels);
+	void drain();
+
+	TUniquePtr<ACORingBuffer> m_ringBuffer;
+	FArchive* m_file;
+	FRunnableThread* m_thread;
+	FEvent* m_dataEvent;
+	FThreadSafeCounter m_stopTaskCounter;
+
+	//producer only
+	int32 m_pheromoneInterval;
+	float m_pheromoneThreshold;
+	/** pheromone levels of the last pushed pheromone records, the next one only contains cells which changed more than the threshold */
+	TArray<float> m_loggedPheromoneLevels;
+	/** ACOLogPheromoneRecord and its cells, at most m_maxCellsPerRecord so a record always fits into the ring buffer */
+	TArray<uint8> m_pheromoneRecord;
+	int32 m_maxCellsPerRecord;
+	double m_previousIterationTime;
+	/** not yet reported in a Dropped record */
+	int32 m_droppedRecords;
+	int32 m_totalDroppedRecords;
+};
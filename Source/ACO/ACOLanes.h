@@ -0,0 +1,95 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+/**
+ * Kernels which choose the next cell of Width searching ants at once, see EACOStepKernel.
+ * The inputs are slot major, [slot * Width + lane], one slot per neighbour of a hexagon. A neighbour an ant can't visit and
+ * an unused lane have a pheromone weight of 0. The weight of a slot is pheromone weight * terrain weight.
+ *
+ * The kernels do the same float operations in the same order as ACOPolicies::SelectProportional on the visitable neighbours
+ * (adding the 0 weights doesn't change a sum), so all kernels choose the same slots as the per ant path, see ACO.Lanes.SelectProportional.
+ *
+ * Only the roulette runs in the lanes. ACOColony::chooseNextCellsInLanes gathers the weights per ant like chooseNextCell, and the Pow of the
+ * pheromone weight in there is most of the cost of a step. A vector Pow would round differently from FMath::Pow and the lanes would
+ * choose other cells than the per ant path. The kernel selects in about a tenth of the time of the per ant selection, a whole step is
+ * about as fast on both paths.
+ *
+ * There is no runtime dispatch on the instruction set. ACOVectorLanes uses the VectorRegister the module is built with (SSE or NEON),
+ * the build has no per-file ISA flags for an AVX2 or AVX-512 kernel of 8 or 16 lanes. The default kernel is fixed at compile time
+ * by PLATFORM_ENABLE_VECTORINTRINSICS, -ACOStepKernel= overrides it.
+ */
+namespace ACOLanes
+{
+	static const int32 Width = 4;
+	static const int32 Slots = 6;
+}
+
+/** fallback without vector registers */
+struct ACOScalarLanes
+{
+	static void SelectProportional(const float* pheromoneWeights, const float* terrainWeights, const float* uniforms, int32* slots)
+	{
+		for (int32 lane = 0; lane < ACOLanes::Width; ++lane)
+		{
+			float weights[ACOLanes::Slots];
+			float weightSum = 0.f;
+			int32 lastSlot = 0;
+			for (int32 slot = 0; slot < ACOLanes::Slots; ++slot)
+			{
+				weights[slot] = pheromoneWeights[slot * ACOLanes::Width + lane] * terrainWeights[slot * ACOLanes::Width + lane];
+				weightSum += weights[slot];
+				lastSlot = weights[slot] > 0.f ? slot : lastSlot;
+			}
+
+			const float target = uniforms[lane] * weightSum;
+			float cumulativeWeight = 0.f;
+			int32 chosenSlot = 0;
+			for (int32 slot = 0; slot < ACOLanes::Slots; ++slot)
+			{
+				cumulativeWeight += weights[slot];
+				chosenSlot += cumulativeWeight <= target ? 1 : 0;
+			}
+			//rounding left the target at the sum, the last visitable slot takes it
+			slots[lane] = chosenSlot < ACOLanes::Slots ? chosenSlot : lastSlot;
+		}
+	}
+};
+
+/** one lane per vector component, the counts are kept as floats so everything stays in the registers */
+struct ACOVectorLanes
+{
+	static void SelectProportional(const float* pheromoneWeights, const float* terrainWeights, const float* uniforms, int32* slots)
+	{
+		static_assert(ACOLanes::Width == 4, "a VectorRegister has 4 lanes");
+		const VectorRegister zero = VectorZero();
+		const VectorRegister one = VectorOne();
+
+		VectorRegister weights[ACOLanes::Slots];
+		VectorRegister weightSum = zero;
+		VectorRegister lastSlot = zero;
+		VectorRegister slotIndex = zero;
+		for (int32 slot = 0; slot < ACOLanes::Slots; ++slot)
+		{
+			weights[slot] = VectorMultiply(VectorLoad(pheromoneWeights + slot * ACOLanes::Width), VectorLoad(terrainWeights + slot * ACOLanes::Width));
+			weightSum = VectorAdd(weightSum, weights[slot]);
+			lastSlot = VectorSelect(VectorCompareGT(weights[slot], zero), slotIndex, lastSlot);
+			slotIndex = VectorAdd(slotIndex, one);
+		}
+
+		const VectorRegister target = VectorMultiply(VectorLoad(uniforms), weightSum);
+		VectorRegister cumulativeWeight = zero;
+		VectorRegister chosenSlot = zero;
+		for (int32 slot = 0; slot < ACOLanes::Slots; ++slot)
+		{
+			cumulativeWeight = VectorAdd(cumulativeWeight, weights[slot]);
+			chosenSlot = VectorAdd(chosenSlot, VectorBitwiseAnd(VectorCompareGE(target, cumulativeWeight), one));
+		}
+		chosenSlot = VectorSelect(VectorCompareGE(chosenSlot, slotIndex), lastSlot, chosenSlot);
+
+		float chosenSlots[ACOLanes::Width];
+		VectorStore(chosenSlot, chosenSlots);
+		for (int32 lane = 0; lane < ACOLanes::Width; ++lane)
+			slots[lane] = static_cast<int32>(chosenSlots[lane]);
+	}
+};
@@ -0,0 +1,152 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ACO.h"
+#include "ACOLogConvertCommandlet.h"
+#include "ACOIterationLog.h"
+#include "ACOMappedFile.h"
+
+namespace
+{
+	/** CSV file which is written in blocks, a log of millions of iterations doesn't fit into one string */
+	class CSVWriter
+	{
+	public:
+		CSVWriter(const FString& filename, const TCHAR* header) : m_file(IFileManager::Get().CreateFileWriter(*filename)), m_text(header) {}
+		~CSVWriter()
+		{
+			flush();
+			delete m_file;
+		}
+
+		bool IsValid() const { return m_file != nullptr; }
+
+		void AddLine(const FString& line)
+		{
+			m_text += line;
+			if (m_text.Len() > 1024 * 1024)
+				flush();
+		}
+
+	private:
+		void flush()
+		{
+			if (m_file && m_text.Len() > 0)
+			{
+				FTCHARToUTF8 text(*m_text);
+				m_file->Serialize(const_cast<ANSICHAR*>(text.Get()), text.Length());
+			}
+			m_text.Reset();
+		}
+
+		FArchive* m_file;
+		FString m_text;
+	};
+}
+
+UACOLogConvertCommandlet::UACOLogConvertCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UACOLogConvertCommandlet::Main(const FString& Params)
+{
+	FString logFilename;
+	if (!FParse::Value(*Params, TEXT("-Log="), logFilename))
+	{
+		UE_LOG(LogACO, Error, TEXT("Usage: -run=ACOLogConvert -Log=<file> [-Output=<prefix>]"));
+		return 1;
+	}
+	FString output = FPaths::GetPath(logFilename) / FPaths::GetBaseFilename(logFilename);
+	FParse::Value(*Params, TEXT("-Output="), output);
+
+	ACOMappedFile file;
+	if (!file.Open(logFilename))
+		return 1;
+	const ACOLogHeader* header = reinterpret_cast<const ACOLogHeader*>(file.GetData());
+	if (file.GetSize() < sizeof(ACOLogHeader) || header->Magic != ACOIterationLog::Magic || header->Version != ACOIterationLog::Version)
+	{
+		UE_LOG(LogACO, Error, TEXT("%s is no ACO log of version %u!"), *logFilename, ACOIterationLog::Version);
+		return 1;
+	}
+
+	CSVWriter iterations(output + TEXT("Iterations.csv"), TEXT("Iteration,Colony,FoodFound,ReturnedHome,IterationBestTripCost,BestTripCost,MeanTripCost,IterationMs,")
+		TEXT("TraverseMs,TraverseBarrierMs,MarkMs,MarkBarrierMs,EvaporateMs,EvaporateBarrierMs,UpdateByOneWorkerMs,UpdateBarrierMs\n"));
+	CSVWriter pheromones(output + TEXT("Pheromones.csv"), TEXT("Iteration,Channel,Cell,PheromoneLevel\n"));
+	if (!iterations.IsValid() || !pheromones.IsValid())
+	{
+		UE_LOG(LogACO, Error, TEXT("Couldn't create the CSV files %s*.csv!"), *output);
+		return 1;
+	}
+
+	int64 iterationRecords = 0, pheromoneRecords = 0, droppedRecords = 0;
+	int64 offset = sizeof(ACOLogHeader);
+	while (offset + static_cast<int64>(sizeof(ACOLogRecordHeader)) <= file.GetSize())
+	{
+		//records are written with memcpy, so they are only 4 byte aligned and are copied before they are read
+		ACOLogRecordHeader recordHeader;
+		FMemory::Memcpy(&recordHeader, file.GetData() + offset, sizeof(recordHeader));
+		offset += sizeof(recordHeader);
+		if (recordHeader.Size < 0 || offset + recordHeader.Size > file.GetSize())
+		{
+			UE_LOG(LogACO, Warning, TEXT("%s ends with a truncated record, it was probably still written."), *logFilename);
+			break;
+		}
+		const uint8* payload = file.GetData() + offset;
+		offset += recordHeader.Size;
+
+		//a record can't be shorter than the fixed part of its payload, the rest of the file can't be trusted then
+		const EACOLogRecord type = static_cast<EACOLogRecord>(recordHeader.Type);
+		const int32 fixedSize = type == EACOLogRecord::Iteration ? sizeof(ACOLogIterationRecord) : type == EACOLogRecord::Pheromones ? sizeof(ACOLogPheromoneRecord)
+			: type == EACOLogRecord::Dropped ? sizeof(int32) : 0;
+		if (recordHeader.Size < fixedSize)
+		{
+			UE_LOG(LogACO, Error, TEXT("%s has a record of type %u with %d bytes, expected at least %d, the rest is skipped!"), *logFilename, recordHeader.Type, recordHeader.Size, fixedSize);
+			break;
+		}
+
+		switch (type)
+		{
+		case EACOLogRecord::Iteration:
+		{
+			ACOLogIterationRecord record;
+			FMemory::Memcpy(&record, payload, sizeof(record));
+			FString line = FString::Printf(TEXT("%d,%d,%d,%d,%g,%g,%g,%.3f"), record.Iteration, record.Colony, record.FoodFound, record.ReturnedHome,
+				record.IterationBestTripCost < MAX_FLT ? record.IterationBestTripCost : -1.f, record.BestTripCost < MAX_FLT ? record.BestTripCost : -1.f, record.MeanTripCost, record.IterationMilliseconds);
+			for (float milliseconds : record.PhaseMilliseconds)
+				line += FString::Printf(TEXT(",%.3f"), milliseconds);
+			iterations.AddLine(line + TEXT("\n"));
+			++iterationRecords;
+			break;
+		}
+		case EACOLogRecord::Pheromones:
+		{
+			ACOLogPheromoneRecord record;
+			FMemory::Memcpy(&record, payload, sizeof(record));
+			for (int32 i = 0; i < record.Amount && sizeof(record) + (i + 1) * sizeof(ACOLogPheromoneCell) <= static_cast<uint32>(recordHeader.Size); ++i)
+			{
+				ACOLogPheromoneCell cell;
+				FMemory::Memcpy(&cell, payload + sizeof(record) + i * sizeof(ACOLogPheromoneCell), sizeof(cell));
+				pheromones.AddLine(FString::Printf(TEXT("%d,%d,%d,%g\n"), record.Iteration, record.Channel, cell.Cell, cell.PheromoneLevel));
+			}
+			++pheromoneRecords;
+			break;
+		}
+		case EACOLogRecord::Dropped:
+		{
+			int32 amount = 0;
+			FMemory::Memcpy(&amount, payload, sizeof(amount));
+			droppedRecords += amount;
+			break;
+		}
+		default:
+			//unknown records of newer versions are skipped
+			break;
+		}
+	}
+
+	UE_LOG(LogACO, Log, TEXT("%lld iteration and %lld pheromone records converted to %s*.csv, %lld records were dropped while logging"), iterationRecords, pheromoneRecords, *output, droppedRecords);
+	return 0;
+}
@@ -0,0 +1,21 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+#include "ACOLogConvertCommandlet.generated.h"
+
+/**
+ * Converts a binary ACOIterationLog to <Output>Iterations.csv and <Output>Pheromones.csv.
+ * UE4Editor-Cmd.exe ACO.uproject -run=ACOLogConvert -Log=Run.acolog -Output=Run
+ */
+UCLASS()
+class UACOLogConvertCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UACOLogConvertCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,325 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ACO.h"
+#include "ACOMapImporter.h"
+#include "ACOMappedFile.h"
+#include "Async/ParallelFor.h"
+#include "IImageWrapper.h"
+#include "IImageWrapperModule.h"
+
+namespace
+{
+	bool isBlank(char character)
+	{
+		return character == ' ' || character == '\t' || character == '\r';
+	}
+
+	bool hasContent(const char* position, const char* end)
+	{
+		for (; position < end; ++position)
+		{
+			if (!isBlank(*position))
+				return true;
+		}
+		return false;
+	}
+
+	/** parses the class values of one line into classes (can be null to only count them), returns the amount of values or INDEX_NONE for invalid lines */
+	int32 parseLine(const char* position, const char* end, uint8* classes, int32 maxValues)
+	{
+		int32 amount = 0;
+		while (true)
+		{
+			while (position < end && isBlank(*position))
+				++position;
+			if (position == end)
+				return amount;
+
+			const char* digits = position;
+			int32 value = 0;
+			while (position < end && *position >= '0' && *position <= '9')
+			{
+				value = value * 10 + (*position - '0');
+				if (value > 255)
+					return INDEX_NONE;
+				++position;
+			}
+			if (position == digits)
+				return INDEX_NONE;
+			if (classes)
+			{
+				if (amount >= maxValues)
+					return INDEX_NONE;
+				classes[amount] = static_cast<uint8>(value);
+			}
+			++amount;
+
+			while (position < end && isBlank(*position))
+				++position;
+			if (position == end)
+				return amount;
+			if (*position != ',' && *position != ';')
+				return INDEX_NONE;
+			++position;
+		}
+	}
+
+	const char* findLineEnd(const char* position, const char* end)
+	{
+		const char* lineEnd = static_cast<const char*>(memchr(position, '\n', end - position));
+		return lineEnd ? lineEnd : end;
+	}
+
+	const char* nextLine(const char* lineEnd, const char* end)
+	{
+		return lineEnd < end ? lineEnd + 1 : end;
+	}
+}
+
+ACOMapLegend::ACOMapLegend()
+{
+	for (int32 i = 0; i < 256; ++i)
+	{
+		TerrainTypes[i] = ETerrainType::TT_Mountain;
+		isFoodSource[i] = false;
+		isDefined[i] = false;
+	}
+	for (ETerrainType type : { ETerrainType::TT_Mountain, ETerrainType::TT_Anthill, ETerrainType::TT_Street, ETerrainType::TT_Grass, ETerrainType::TT_Sand, ETerrainType::TT_Mud, ETerrainType::TT_Water })
+	{
+		TerrainTypes[static_cast<uint8>(type)] = type;
+		isDefined[static_cast<uint8>(type)] = true;
+	}
+	TerrainTypes[255] = ETerrainType::TT_Grass;
+	isFoodSource[255] = true;
+	isDefined[255] = true;
+}
+
+bool ACOMapLegend::Load(const FString& filename)
+{
+	TArray<FString> lines;
+	if (!FFileHelper::LoadANSITextFileToStrings(*filename, nullptr, lines))
+	{
+		UE_LOG(LogACO, Error, TEXT("Couldn't read map legend %s!"), *filename);
+		return false;
+	}
+
+	//a legend replaces the default one completely
+	*this = ACOMapLegend();
+	for (auto& a : isDefined)
+		a = false;
+
+	for (const auto& line : lines)
+	{
+		FString trimmedLine = line.Trim().TrimTrailing();
+		if (trimmedLine.IsEmpty() || trimmedLine.StartsWith(TEXT(";")))
+			continue;
+
+		FString classValue, entry, foodTerrain;
+		ETerrainType type = ETerrainType::TT_Grass;
+		bool isFood = false;
+		if (!trimmedLine.Split(TEXT("="), &classValue, &entry) || !classValue.IsNumeric() || FCString::Atoi(*classValue) < 0 || FCString::Atoi(*classValue) > 255)
+		{
+			UE_LOG(LogACO, Error, TEXT("Invalid map legend entry %s, expected <class>=<terrain>"), *line);
+			return false;
+		}
+		if (entry.StartsWith(TEXT("Food")))
+		{
+			isFood = true;
+			if (entry.Split(TEXT(","), nullptr, &foodTerrain) && !parseTerrainType(foodTerrain, type))
+			{
+				UE_LOG(LogACO, Error, TEXT("Unknown terrain %s in map legend entry %s"), *foodTerrain, *line);
+				return false;
+			}
+		}
+		else if (!parseTerrainType(entry, type))
+		{
+			UE_LOG(LogACO, Error, TEXT("Unknown terrain %s in map legend entry %s"), *entry, *line);
+			return false;
+		}
+
+		const int32 index = FCString::Atoi(*classValue);
+		TerrainTypes[index] = type;
+		isFoodSource[index] = isFood;
+		isDefined[index] = true;
+	}
+	return true;
+}
+
+bool ACOMapLegend::parseTerrainType(const FString& name, ETerrainType& type)
+{
+	static const TCHAR* names[] = { TEXT("Mountain"), TEXT("Anthill"), TEXT("Street"), TEXT("Grass"), TEXT("Sand"), TEXT("Mud"), TEXT("Water") };
+	static const ETerrainType types[] = { ETerrainType::TT_Mountain, ETerrainType::TT_Anthill, ETerrainType::TT_Street, ETerrainType::TT_Grass, ETerrainType::TT_Sand, ETerrainType::TT_Mud, ETerrainType::TT_Water };
+	for (int32 i = 0; i < ARRAY_COUNT(names); ++i)
+	{
+		if (name.Trim().TrimTrailing() == names[i])
+		{
+			type = types[i];
+			return true;
+		}
+	}
+	return false;
+}
+
+bool ACOMapImporter::Import(const FString& filename, const ACOMapLegend& legend, ACOGrid& grid)
+{
+	const double startTime = FPlatformTime::Seconds();
+	TArray<uint8> classes;
+	FIntPoint size(0, 0);
+	const FString extension = FPaths::GetExtension(filename);
+	if (extension == TEXT("csv"))
+	{
+		if (!parseCSV(filename, classes, size))
+			return false;
+	}
+	else if (extension == TEXT("png"))
+	{
+		if (!decodePNG(filename, classes, size))
+			return false;
+	}
+	else
+	{
+		UE_LOG(LogACO, Error, TEXT("Unknown map format %s, expected .csv or .png"), *filename);
+		return false;
+	}
+
+	//class values to terrain types, the food sources of every row are collected separately to stay lock free
+	TArray<ETerrainType> terrainTypes;
+	terrainTypes.SetNumUninitialized(classes.Num());
+	TArray<TArray<int32>> rowFoodSources;
+	rowFoodSources.SetNum(size.Y);
+	FThreadSafeCounter undefinedCells;
+	ParallelFor(size.Y, [&](int32 y)
+	{
+		for (int32 cell = y * size.X; cell < (y + 1) * size.X; ++cell)
+		{
+			const uint8 classValue = classes[cell];
+			if (!legend.isDefined[classValue])
+				undefinedCells.Increment();
+			terrainTypes[cell] = legend.TerrainTypes[classValue];
+			if (legend.isFoodSource[classValue])
+				rowFoodSources[y].Add(cell);
+		}
+	});
+	if (undefinedCells.GetValue() > 0)
+	{
+		UE_LOG(LogACO, Error, TEXT("%d cells of map %s have classes which aren't part of the legend!"), undefinedCells.GetValue(), *filename);
+		return false;
+	}
+
+	TArray<int32> foodSources;
+	for (const auto& a : rowFoodSources)
+		foodSources.Append(a);
+
+	grid = ACOGrid::CreateFromTerrain(size, MoveTemp(terrainTypes), foodSources);
+	UE_LOG(LogACO, Log, TEXT("Map %s with %dx%d cells, %d anthills and %d food sources imported after %.2fs"), *filename, size.X, size.Y, grid.Anthills.Num(), grid.FoodSources.Num(), FPlatformTime::Seconds() - startTime);
+	return true;
+}
+
+bool ACOMapImporter::parseCSV(const FString& filename, TArray<uint8>& classes, FIntPoint& size)
+{
+	ACOMappedFile file;
+	if (!file.Open(filename))
+		return false;
+
+	const char* begin = reinterpret_cast<const char*>(file.GetData());
+	const char* end = begin + file.GetSize();
+	//UTF-8 byte order mark
+	if (end - begin >= 3 && FMemory::Memcmp(begin, "\xEF\xBB\xBF", 3) == 0)
+		begin += 3;
+
+	//the width is the amount of values in the first line
+	const char* firstLine = begin;
+	while (firstLine < end && !hasContent(firstLine, findLineEnd(firstLine, end)))
+		firstLine = nextLine(findLineEnd(firstLine, end), end);
+	const int32 width = parseLine(firstLine, findLineEnd(firstLine, end), nullptr, 0);
+	if (width <= 0)
+	{
+		UE_LOG(LogACO, Error, TEXT("Map %s has no valid first row!"), *filename);
+		return false;
+	}
+
+	//every chunk starts after a line break, so each line belongs to exactly one chunk
+	const int64 fileSize = end - begin;
+	const int32 chunkAmount = static_cast<int32>(FMath::Clamp<int64>(fileSize / (256 * 1024), 1, 1024));
+	TArray<const char*> chunkStarts;
+	chunkStarts.SetNumUninitialized(chunkAmount + 1);
+	chunkStarts[0] = begin;
+	for (int32 chunk = 1; chunk < chunkAmount; ++chunk)
+	{
+		const char* start = FMath::Max(begin + fileSize * chunk / chunkAmount, chunkStarts[chunk - 1]);
+		while (start < end && start[-1] != '\n')
+			++start;
+		chunkStarts[chunk] = start;
+	}
+	chunkStarts[chunkAmount] = end;
+
+	//first pass counts the rows of every chunk, so the second one knows where its rows are stored
+	TArray<int32> chunkRows;
+	chunkRows.SetNumZeroed(chunkAmount + 1);
+	ParallelFor(chunkAmount, [&](int32 chunk)
+	{
+		for (const char* line = chunkStarts[chunk]; line < chunkStarts[chunk + 1];)
+		{
+			const char* lineEnd = findLineEnd(line, chunkStarts[chunk + 1]);
+			if (hasContent(line, lineEnd))
+				++chunkRows[chunk + 1];
+			line = nextLine(lineEnd, chunkStarts[chunk + 1]);
+		}
+	});
+	for (int32 chunk = 1; chunk <= chunkAmount; ++chunk)
+		chunkRows[chunk] += chunkRows[chunk - 1];
+
+	size = FIntPoint(width, chunkRows[chunkAmount]);
+	classes.SetNumUninitialized(size.X * size.Y);
+
+	//second pass parses the values, every chunk remembers its first invalid row
+	TArray<int32> invalidRows;
+	invalidRows.Init(INDEX_NONE, chunkAmount);
+	ParallelFor(chunkAmount, [&](int32 chunk)
+	{
+		int32 row = chunkRows[chunk];
+		for (const char* line = chunkStarts[chunk]; line < chunkStarts[chunk + 1] && invalidRows[chunk] == INDEX_NONE;)
+		{
+			const char* lineEnd = findLineEnd(line, chunkStarts[chunk + 1]);
+			if (hasContent(line, lineEnd))
+			{
+				if (parseLine(line, lineEnd, classes.GetData() + row * width, width) != width)
+					invalidRows[chunk] = row;
+				++row;
+			}
+			line = nextLine(lineEnd, chunkStarts[chunk + 1]);
+		}
+	});
+	for (int32 invalidRow : invalidRows)
+	{
+		if (invalidRow != INDEX_NONE)
+		{
+			UE_LOG(LogACO, Error, TEXT("Row %d of map %s is invalid, expected %d class values between 0 and 255!"), invalidRow + 1, *filename, width);
+			return false;
+		}
+	}
+	return true;
+}
+
+bool ACOMapImporter::decodePNG(const FString& filename, TArray<uint8>& classes, FIntPoint& size)
+{
+	TArray<uint8> compressedData;
+	if (!FFileHelper::LoadFileToArray(compressedData, *filename))
+	{
+		UE_LOG(LogACO, Error, TEXT("Couldn't read map %s!"), *filename);
+		return false;
+	}
+
+	IImageWrapperModule& imageWrapperModule = FModuleManager::LoadModuleChecked<IImageWrapperModule>(FName("ImageWrapper"));
+	TSharedPtr<IImageWrapper> imageWrapper = imageWrapperModule.CreateImageWrapper(EImageFormat::PNG);
+	const TArray<uint8>* rawData = nullptr;
+	if (!imageWrapper.IsValid() || !imageWrapper->SetCompressed(compressedData.GetData(), compressedData.Num()) || !imageWrapper->GetRaw(ERGBFormat::Gray, 8, rawData) || !rawData)
+	{
+		UE_LOG(LogACO, Error, TEXT("Couldn't decode map %s as 8 bit grayscale PNG!"), *filename);
+		return false;
+	}
+
+	size = FIntPoint(imageWrapper->GetWidth(), imageWrapper->GetHeight());
+	classes = *rawData;
+	return classes.Num() == size.X * size.Y && classes.Num() > 0;
+}
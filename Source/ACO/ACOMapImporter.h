@@ -0,0 +1,45 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "ACOGrid.h"
+
+/**
+ * Maps the 8 bit class values of a map file to terrain types and markers.
+ * Without a legend file the class value is the ETerrainType value (0 = Mountain, 1 = Anthill, 10 = Street, ...)
+ * and 255 marks a food source on grass.
+ *
+ * Legend file, one entry per line, lines starting with ; are comments:
+ * <class>=<Mountain|Anthill|Street|Grass|Sand|Mud|Water|Food>[,<terrain of the food source>]
+ */
+struct ACO_API ACOMapLegend
+{
+	ACOMapLegend();
+
+	bool Load(const FString& filename);
+
+	ETerrainType TerrainTypes[256];
+	bool isFoodSource[256];
+	bool isDefined[256];
+
+private:
+	static bool parseTerrainType(const FString& name, ETerrainType& type);
+};
+
+/**
+ * Imports large hexagon maps directly into an ACOGrid, without spawning hexagon actors.
+ * Rows of the file are rows (Y) of the grid, columns are columns (X), the layout is the one of AGridGenerator.
+ *
+ * .csv: one line per row, comma separated class values. The mapped file is split into chunks which are parsed in parallel.
+ * .png: 8 bit grayscale class map.
+ */
+class ACO_API ACOMapImporter
+{
+public:
+	static bool Import(const FString& filename, const ACOMapLegend& legend, ACOGrid& grid);
+	static bool Import(const FString& filename, ACOGrid& grid) { return Import(filename, ACOMapLegend(), grid); }
+
+private:
+	static bool parseCSV(const FString& filename, TArray<uint8>& classes, FIntPoint& size);
+	static bool decodePNG(const FString& filename, TArray<uint8>& classes, FIntPoint& size);
+};
@@ -0,0 +1,106 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ACO.h"
+#include "ACOMappedFile.h"
+
+#if PLATFORM_WINDOWS
+#include "AllowWindowsPlatformTypes.h"
+#include <windows.h>
+#include "HideWindowsPlatformTypes.h"
+#elif PLATFORM_LINUX || PLATFORM_MAC
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+ACOMappedFile::ACOMappedFile() : m_data(nullptr), m_size(0)
+#if PLATFORM_WINDOWS
+	, m_fileHandle(nullptr), m_mappingHandle(nullptr)
+#elif PLATFORM_LINUX || PLATFORM_MAC
+	, m_fileDescriptor(-1)
+#endif
+{
+}
+
+ACOMappedFile::~ACOMappedFile()
+{
+	Close();
+}
+
+bool ACOMappedFile::Open(const FString& filename)
+{
+	Close();
+	const FString fullFilename = FPaths::ConvertRelativePathToFull(filename);
+
+#if PLATFORM_WINDOWS
+	m_fileHandle = CreateFileW(*fullFilename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (m_fileHandle == INVALID_HANDLE_VALUE)
+	{
+		m_fileHandle = nullptr;
+		return false;
+	}
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(m_fileHandle, &size) || size.QuadPart == 0)
+	{
+		Close();
+		return false;
+	}
+	m_mappingHandle = CreateFileMappingW(m_fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (m_mappingHandle)
+		m_data = static_cast<const uint8*>(MapViewOfFile(m_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+	m_size = size.QuadPart;
+#elif PLATFORM_LINUX || PLATFORM_MAC
+	m_fileDescriptor = open(TCHAR_TO_UTF8(*fullFilename), O_RDONLY);
+	if (m_fileDescriptor < 0)
+		return false;
+	struct stat fileStatus;
+	if (fstat(m_fileDescriptor, &fileStatus) != 0 || fileStatus.st_size == 0)
+	{
+		Close();
+		return false;
+	}
+	void* data = mmap(nullptr, fileStatus.st_size, PROT_READ, MAP_PRIVATE, m_fileDescriptor, 0);
+	if (data != MAP_FAILED)
+		m_data = static_cast<const uint8*>(data);
+	m_size = fileStatus.st_size;
+#else
+	if (FFileHelper::LoadFileToArray(m_fileContent, *fullFilename) && m_fileContent.Num() > 0)
+	{
+		m_data = m_fileContent.GetData();
+		m_size = m_fileContent.Num();
+	}
+#endif
+
+	if (!m_data)
+	{
+		UE_LOG(LogACO, Error, TEXT("Couldn't map %s!"), *fullFilename);
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void ACOMappedFile::Close()
+{
+#if PLATFORM_WINDOWS
+	if (m_data)
+		UnmapViewOfFile(m_data);
+	if (m_mappingHandle)
+		CloseHandle(m_mappingHandle);
+	if (m_fileHandle)
+		CloseHandle(m_fileHandle);
+	m_mappingHandle = nullptr;
+	m_fileHandle = nullptr;
+#elif PLATFORM_LINUX || PLATFORM_MAC
+	if (m_data)
+		munmap(const_cast<uint8*>(m_data), m_size);
+	if (m_fileDescriptor >= 0)
+		close(m_fileDescriptor);
+	m_fileDescriptor = -1;
+#else
+	m_fileContent.Empty();
+#endif
+	m_data = nullptr;
+	m_size = 0;
+}
@@ -0,0 +1,36 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+/**
+ * Read only memory mapping of a whole file, the pages are only loaded when they are touched.
+ * Platforms without a mapping implementation fall back to reading the file into memory.
+ */
+class ACO_API ACOMappedFile
+{
+public:
+	ACOMappedFile();
+	~ACOMappedFile();
+
+	bool Open(const FString& filename);
+	void Close();
+
+	bool IsOpen() const { return m_data != nullptr; }
+	const uint8* GetData() const { return m_data; }
+	int64 GetSize() const { return m_size; }
+
+private:
+	ACOMappedFile(const ACOMappedFile&) = delete;
+	ACOMappedFile& operator=(const ACOMappedFile&) = delete;
+
+	const uint8* m_data;
+	int64 m_size;
+#if PLATFORM_WINDOWS
+	void* m_fileHandle;
+	void* m_mappingHandle;
+#elif PLATFORM_LINUX || PLATFORM_MAC
+	int m_fileDescriptor;
+#else
+	TArray<uint8> m_fileContent;
+#endif
+};
@@ -0,0 +1,171 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ACO.h"
+#include "ACOMultiLevel.h"
+#include "Async/ParallelFor.h"
+
+ACOMultiLevelSettings::ACOMultiLevelSettings() : IsEnabled(false), CoarseFactor(8), CoarseAnts(1000), CoarseIterations(200), SeedStrength(1.f),
+	RecoarsenInterval(0), RecoarsenIterations(20)
+{
+}
+
+bool ACOMultiLevelSettings::Parse(const TCHAR* stream)
+{
+	IsEnabled = FParse::Param(stream, TEXT("ACOMultiLevel"));
+	FParse::Value(stream, TEXT("-ACOCoarseFactor="), CoarseFactor);
+	FParse::Value(stream, TEXT("-ACOCoarseAnts="), CoarseAnts);
+	FParse::Value(stream, TEXT("-ACOCoarseIterations="), CoarseIterations);
+	FParse::Value(stream, TEXT("-ACOSeedStrength="), SeedStrength);
+	FParse::Value(stream, TEXT("-ACORecoarsenInterval="), RecoarsenInterval);
+	FParse::Value(stream, TEXT("-ACORecoarsenIterations="), RecoarsenIterations);
+
+	if (CoarseFactor < 2 || CoarseAnts <= 0 || CoarseIterations < 0 || SeedStrength < 0.f || RecoarsenInterval < 0 || RecoarsenIterations < 0)
+	{
+		UE_LOG(LogACO, Error, TEXT("Invalid multi-level settings!"));
+		return false;
+	}
+	return true;
+}
+
+ACOMultiLevel::ACOMultiLevel(const ACOGrid& grid, const TArray<int32>& anthills, const ACOParameters& parameters, const ACOMultiLevelSettings& settings)
+	: m_grid(grid), m_parameters(parameters), m_settings(settings)
+{
+	m_coarseGrid = ACOGrid::CreateCoarse(grid, settings.CoarseFactor, m_superCells);
+	m_superCellSizes.SetNumZeroed(m_coarseGrid.Num());
+	for (int32 superCell : m_superCells)
+		++m_superCellSizes[superCell];
+
+	//the coarse run is a short warm up, so it always uses floats and moves every ant every iteration
+	m_parameters.AntAmount = settings.CoarseAnts;
+	m_parameters.EventDriven = false;
+	m_parameters.PheromoneStorage = EACOPheromoneStorage::Float;
+	m_coarsePheromoneField.Init(m_coarseGrid.Num(), anthills.Num(), m_parameters.PheromoneStorage, m_parameters.Deterministic);
+	for (int32 channel = 0; channel < anthills.Num(); ++channel)
+		m_colonies.Emplace(new ACOColony(m_coarseGrid, m_coarsePheromoneField, channel, m_superCells[anthills[channel]], m_parameters));
+
+	//a deterministic colony seeds its ants itself, the tasks only need streams of their own
+	const int32 tasks = FMath::Clamp(settings.CoarseAnts / 256, 1, FMath::Max(FPlatformMisc::NumberOfCoresIncludingHyperthreads(), 1));
+	for (int32 i = 0; i < tasks * m_colonies.Num(); ++i)
+		m_randomStreams.Add(FRandomStream(parameters.Seed * 7919 + i));
+}
+
+double ACOMultiLevel::Seed(ACOPheromoneField& pheromoneField)
+{
+	const double startTime = FPlatformTime::Seconds();
+	iterateCoarse(m_settings.CoarseIterations);
+	project(pheromoneField);
+	const double seconds = FPlatformTime::Seconds() - startTime;
+
+	UE_LOG(LogACO, Log, TEXT("Pheromones seeded from %d super cells (%dx%d) after %d coarse iterations in %.3f ms"), m_coarseGrid.Num(), m_coarseGrid.Size.X, m_coarseGrid.Size.Y,
+		m_settings.CoarseIterations, seconds * 1000.0);
+	for (int32 channel = 0; channel < m_colonies.Num(); ++channel)
+	{
+		if (GetCoarseBestTripCost(channel) == MAX_FLT)
+			UE_LOG(LogACO, Warning, TEXT("The coarse ants of channel %d found no food, the channel isn't seeded"), channel);
+	}
+	return seconds;
+}
+
+bool ACOMultiLevel::OnIterationFinished(ACOPheromoneField& pheromoneField, int32 iteration, bool (*passControlPoint)())
+{
+	if (m_settings.RecoarsenInterval <= 0 || iteration % m_settings.RecoarsenInterval != 0)
+		return true;
+
+	restrict(pheromoneField);
+	if (!iterateCoarse(m_settings.RecoarsenIterations, passControlPoint))
+		return false;
+	project(pheromoneField);
+	return true;
+}
+
+bool ACOMultiLevel::iterateCoarse(int32 iterations, bool (*passControlPoint)())
+{
+	const int32 colonies = m_colonies.Num();
+	const int32 tasks = m_randomStreams.Num() / FMath::Max(colonies, 1);
+	TArray<ACOTripStatistics> statistics;
+	statistics.SetNum(m_randomStreams.Num());
+	auto getRange = [tasks](int32 amount, int32 task) { return FIntPoint(amount * task / tasks, amount * (task + 1) / tasks); };
+
+	//the colonies work on different channels, so the tasks of all colonies run together
+	for (int32 iteration = 0; iteration < iterations; ++iteration)
+	{
+		if (passControlPoint && !passControlPoint())
+			return false;
+		ParallelFor(m_randomStreams.Num(), [&](int32 i)
+		{
+			ACOColony& colony = *m_colonies[i / tasks];
+			const FIntPoint ants = getRange(colony.GetAntAmount(), i % tasks);
+			colony.TraverseAnts(ants.X, ants.Y, m_randomStreams[i], statistics[i]);
+		});
+		ParallelFor(m_randomStreams.Num(), [&](int32 i)
+		{
+			ACOColony& colony = *m_colonies[i / tasks];
+			const FIntPoint ants = getRange(colony.GetAntAmount(), i % tasks);
+			colony.MarkAnts(ants.X, ants.Y);
+		});
+		ParallelFor(m_randomStreams.Num(), [&](int32 i)
+		{
+			const FIntPoint cells = getRange(m_coarseGrid.Num(), i % tasks);
+			m_colonies[i / tasks]->EvaporateCells(cells.X, cells.Y);
+		});
+		for (auto& colony : m_colonies)
+			colony->FinishIteration();
+	}
+	return true;
+}
+
+void ACOMultiLevel::restrict(const ACOPheromoneField& pheromoneField)
+{
+	const int32 channels = m_colonies.Num();
+	TArray<float> levelSums;
+	levelSums.SetNumZeroed(m_coarseGrid.Num() * channels);
+	for (int32 cell = 0; cell < m_grid.Num(); ++cell)
+	{
+		for (int32 channel = 0; channel < channels; ++channel)
+			levelSums[m_superCells[cell] * channels + channel] += pheromoneField.GetPheromoneLevel(cell, channel);
+	}
+
+	m_coarsePheromoneField.ResetMaxPheromoneLevels();
+	for (int32 superCell = 0; superCell < m_coarseGrid.Num(); ++superCell)
+	{
+		for (int32 channel = 0; channel < channels; ++channel)
+			m_coarsePheromoneField.SetPheromoneLevel(superCell, channel, levelSums[superCell * channels + channel] / m_superCellSizes[superCell]);
+	}
+}
+
+void ACOMultiLevel::project(ACOPheromoneField& pheromoneField) const
+{
+	const int32 channels = m_colonies.Num();
+	//only the pheromones above the evaporation floor are trails, MaxMin never evaporates below MinPheromoneLevel
+	const bool isMaxMin = m_parameters.Variant == EACOVariant::MaxMin;
+	const float floorLevel = isMaxMin ? m_parameters.MinPheromoneLevel : 0.f;
+	TArray<float, TInlineAllocator<8>> coarseMaxLevels;
+	TArray<float, TInlineAllocator<8>> seedLevels;
+	coarseMaxLevels.SetNumZeroed(channels);
+	for (int32 superCell = 0; superCell < m_coarseGrid.Num(); ++superCell)
+	{
+		for (int32 channel = 0; channel < channels; ++channel)
+			coarseMaxLevels[channel] = FMath::Max(coarseMaxLevels[channel], m_coarsePheromoneField.GetPheromoneLevel(superCell, channel) - floorLevel);
+	}
+	//the seed is relative to the current trails, so a re-coarsening doesn't drown them
+	for (int32 channel = 0; channel < channels; ++channel)
+	{
+		const float referenceLevel = FMath::Max(pheromoneField.GetMaxPheromoneLevel(channel), m_parameters.InitialPheromoneLevel);
+		seedLevels.Add(coarseMaxLevels[channel] > 0.f ? referenceLevel * m_settings.SeedStrength / coarseMaxLevels[channel] : 0.f);
+	}
+
+	ParallelFor(m_grid.Num(), [&](int32 cell)
+	{
+		if (!m_grid.IsWalkable(cell))
+			return;
+		for (int32 channel = 0; channel < channels; ++channel)
+		{
+			const float coarseLevel = m_coarsePheromoneField.GetPheromoneLevel(m_superCells[cell], channel) - floorLevel;
+			float seededLevel = m_parameters.InitialPheromoneLevel + seedLevels[channel] * coarseLevel;
+			if (isMaxMin)
+				seededLevel = FMath::Min(seededLevel, m_parameters.MaxPheromoneLevel);
+			if (coarseLevel > 0.f && seededLevel > pheromoneField.GetPheromoneLevel(cell, channel))
+				pheromoneField.SetPheromoneLevel(cell, channel, seededLevel);
+		}
+	});
+}
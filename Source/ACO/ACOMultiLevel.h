@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "ACOColony.h"
+
+/**
+ * Settings of ACOMultiLevel.
+ *
+ * Command line syntax: -ACOMultiLevel -ACOCoarseFactor=8 -ACOCoarseAnts=1000 -ACOCoarseIterations=200 -ACOSeedStrength=1
+ * -ACORecoarsenInterval=0 -ACORecoarsenIterations=20
+ */
+struct ACO_API ACOMultiLevelSettings
+{
+	ACOMultiLevelSettings();
+
+	bool IsEnabled;
+	/** columns and rows of the fine grid per super cell, see ACOGrid::CreateCoarse */
+	int32 CoarseFactor;
+	/** ants per coarse colony */
+	int32 CoarseAnts;
+	/** coarse iterations before the fine colonies start */
+	int32 CoarseIterations;
+	/** a seeded cell gets InitialPheromoneLevel + reference level * SeedStrength * coarse level / max coarse level */
+	float SeedStrength;
+	/** fine iterations between two re-coarsenings, 0 = only seed once */
+	int32 RecoarsenInterval;
+	int32 RecoarsenIterations;
+
+	/** keeps the defaults of missing values, returns false on invalid values */
+	bool Parse(const TCHAR* stream);
+};
+
+/**
+ * Coarse-to-fine seeding of the pheromone field of a large grid.
+ * The grid is aggregated into super cells and one cheap colony per fine colony runs on the coarse grid, where a trip to a food source
+ * only takes a few steps. Its trails are projected onto the fine cells of every marked super cell, so the fine ants start with a corridor
+ * towards the food instead of uniform pheromones.
+ * A re-coarsening restricts the fine field to the coarse one (mean level of a super cell), continues the coarse colonies and projects
+ * their trails again, a projection only raises fine levels, it never lowers them.
+ */
+class ACO_API ACOMultiLevel
+{
+public:
+	/** the fine grid has to outlive the object, anthills has the anthill of every channel of the fine field */
+	ACOMultiLevel(const ACOGrid& grid, const TArray<int32>& anthills, const ACOParameters& parameters, const ACOMultiLevelSettings& settings);
+
+	/** runs the coarse iterations and seeds the fine field, returns the seconds it took */
+	double Seed(ACOPheromoneField& pheromoneField);
+	/**
+	 * has to be called by one thread at an iteration boundary, re-coarsens every RecoarsenInterval iterations.
+	 * passControlPoint is called before every coarse iteration, if it returns false the re-coarsening stops without a projection and false is returned.
+	 */
+	bool OnIterationFinished(ACOPheromoneField& pheromoneField, int32 iteration, bool (*passControlPoint)() = nullptr);
+
+	const ACOGrid& GetCoarseGrid() const { return m_coarseGrid; }
+	const ACOPheromoneField& GetCoarsePheromoneField() const { return m_coarsePheromoneField; }
+	/** super cell of a fine cell */
+	int32 GetSuperCell(int32 cell) const { return m_superCells[cell]; }
+	/** terrain cost of the cheapest coarse trip of the channel, MAX_FLT until a coarse ant found food */
+	float GetCoarseBestTripCost(int32 channel) const { return m_colonies[channel]->GetBestTripCost(); }
+
+private:
+	/** the phases of the coarse colonies, the ants of a colony are moved by several tasks, false if passControlPoint stopped them */
+	bool iterateCoarse(int32 iterations, bool (*passControlPoint)() = nullptr);
+	/** mean fine level of every super cell */
+	void restrict(const ACOPheromoneField& pheromoneField);
+	void project(ACOPheromoneField& pheromoneField) const;
+
+	const ACOGrid& m_grid;
+	ACOParameters m_parameters;
+	ACOMultiLevelSettings m_settings;
+	ACOGrid m_coarseGrid;
+	TArray<int32> m_superCells;
+	/** fine cells per super cell */
+	TArray<int32> m_superCellSizes;
+	ACOPheromoneField m_coarsePheromoneField;
+	TArray<TUniquePtr<ACOColony>> m_colonies;
+	TArray<FRandomStream> m_randomStreams;
+};
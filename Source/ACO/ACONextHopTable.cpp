@@ -0,0 +1,188 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ACO.h"
+#include "ACONextHopTable.h"
+#include "ACOGrid.h"
+
+ACONextHopTable::ACONextHopTable(const ACOGrid& grid, float referenceLevel) : m_grid(grid), m_referenceLevel(FMath::Max(referenceLevel, KINDA_SMALL_NUMBER)),
+	m_tolerance(0.05f), m_channels(0), m_changedCells(0)
+{
+}
+
+void ACONextHopTable::Update(const TArray<float>& pheromoneLevels, int32 channels)
+{
+	const int32 cells = m_grid.Num();
+	check(pheromoneLevels.Num() == cells * channels);
+	const bool isRebuilding = channels != m_channels || m_costs.Num() != cells * channels;
+	if (isRebuilding)
+	{
+		m_channels = channels;
+		m_costs.SetNumUninitialized(cells * channels);
+		m_trees.Reset();
+		m_trees.SetNum(channels * static_cast<int32>(EACORouteTarget::Num));
+		for (int32 channel = 0; channel < channels; ++channel)
+		{
+			for (EACORouteTarget target : { EACORouteTarget::Food, EACORouteTarget::Anthill })
+			{
+				m_trees[GetTreeIndex(channel, target)].Channel = channel;
+				m_trees[GetTreeIndex(channel, target)].Target = target;
+			}
+		}
+	}
+
+	//small changes keep the old cost, otherwise every tree would be repaired everywhere after each evaporation
+	TArray<TArray<int32>> increased;
+	TArray<TArray<int32>> decreased;
+	increased.SetNum(channels);
+	decreased.SetNum(channels);
+	ParallelFor(channels, [&](int32 channel)
+	{
+		float* costs = m_costs.GetData() + channel * cells;
+		for (int32 cell = 0; cell < cells; ++cell)
+		{
+			const float cost = getCost(pheromoneLevels[cell * channels + channel]);
+			if (isRebuilding)
+			{
+				costs[cell] = cost;
+			}
+			else if (cost > costs[cell] * (1.f + m_tolerance))
+			{
+				costs[cell] = cost;
+				increased[channel].Add(cell);
+			}
+			else if (cost < costs[cell] * (1.f - m_tolerance))
+			{
+				costs[cell] = cost;
+				decreased[channel].Add(cell);
+			}
+		}
+	});
+	m_changedCells = 0;
+	for (int32 channel = 0; channel < channels; ++channel)
+		m_changedCells += increased[channel].Num() + decreased[channel].Num();
+
+	ParallelFor(m_trees.Num(), [&](int32 i)
+	{
+		Tree& tree = m_trees[i];
+		TArray<int32> targets;
+		getTargets(tree, targets);
+		if (isRebuilding || targets != tree.Targets)
+		{
+			tree.Targets = MoveTemp(targets);
+			build(tree);
+		}
+		else if (increased[tree.Channel].Num() > 0 || decreased[tree.Channel].Num() > 0)
+		{
+			repair(tree, increased[tree.Channel], decreased[tree.Channel]);
+		}
+	});
+}
+
+void ACONextHopTable::getTargets(const Tree& tree, TArray<int32>& targets) const
+{
+	if (tree.Target == EACORouteTarget::Food)
+	{
+		targets = m_grid.FoodSources;
+		targets.Sort();
+	}
+	else if (m_grid.Anthills.IsValidIndex(tree.Channel))
+	{
+		targets.Add(m_grid.Anthills[tree.Channel]);
+	}
+}
+
+void ACONextHopTable::build(Tree& tree)
+{
+	tree.Distances.Init(MAX_FLT, m_grid.Num());
+	tree.NextHops.Init(INDEX_NONE, m_grid.Num());
+	DistanceQueue open;
+	for (int32 target : tree.Targets)
+	{
+		tree.Distances[target] = 0.f;
+		open.emplace(0.f, target);
+	}
+	propagate(tree, open);
+}
+
+void ACONextHopTable::repair(Tree& tree, const TArray<int32>& increased, const TArray<int32>& decreased)
+{
+	const float* costs = m_costs.GetData() + tree.Channel * m_grid.Num();
+
+	//the distance of a cell contains the cost of its next hop, so a more expensive cell invalidates the cells leading through it
+	TArray<int32> affectedCells;
+	TArray<uint8> isAffected;
+	isAffected.SetNumZeroed(m_grid.Num());
+	auto addCellsLeadingThrough = [&](int32 cell)
+	{
+		for (const int32* neighbour = m_grid.GetNeighboursBegin(cell); neighbour != m_grid.GetNeighboursEnd(cell); ++neighbour)
+		{
+			if (!isAffected[*neighbour] && tree.NextHops[*neighbour] == cell)
+			{
+				isAffected[*neighbour] = 1;
+				affectedCells.Add(*neighbour);
+			}
+		}
+	};
+	for (int32 cell : increased)
+	{
+		//the changed cell keeps its own distance, only the cells behind it are affected
+		int32 i = affectedCells.Num();
+		addCellsLeadingThrough(cell);
+		for (; i < affectedCells.Num(); ++i)
+			addCellsLeadingThrough(affectedCells[i]);
+	}
+
+	for (int32 cell : affectedCells)
+	{
+		tree.Distances[cell] = MAX_FLT;
+		tree.NextHops[cell] = INDEX_NONE;
+	}
+
+	//restart the search from the unaffected border and from the cheaper cells
+	DistanceQueue open;
+	for (int32 cell : affectedCells)
+	{
+		for (const int32* neighbour = m_grid.GetNeighboursBegin(cell); neighbour != m_grid.GetNeighboursEnd(cell); ++neighbour)
+		{
+			if (tree.Distances[*neighbour] < MAX_FLT && tree.Distances[*neighbour] + costs[*neighbour] < tree.Distances[cell])
+			{
+				tree.Distances[cell] = tree.Distances[*neighbour] + costs[*neighbour];
+				tree.NextHops[cell] = *neighbour;
+			}
+		}
+		if (tree.Distances[cell] < MAX_FLT)
+			open.emplace(tree.Distances[cell], cell);
+	}
+	for (int32 cell : decreased)
+	{
+		if (tree.Distances[cell] < MAX_FLT)
+			open.emplace(tree.Distances[cell], cell);
+	}
+	propagate(tree, open);
+}
+
+void ACONextHopTable::propagate(Tree& tree, DistanceQueue& open)
+{
+	const float* costs = m_costs.GetData() + tree.Channel * m_grid.Num();
+	while (!open.empty())
+	{
+		const float distance = open.top().first;
+		const int32 cell = open.top().second;
+		open.pop();
+		//outdated entry, the cell was lowered again after it was queued
+		if (distance > tree.Distances[cell])
+			continue;
+
+		//the neighbours reach the targets by entering the cell
+		const float newDistance = distance + costs[cell];
+		for (const int32* neighbour = m_grid.GetNeighboursBegin(cell); neighbour != m_grid.GetNeighboursEnd(cell); ++neighbour)
+		{
+			if (newDistance < tree.Distances[*neighbour])
+			{
+				tree.Distances[*neighbour] = newDistance;
+				tree.NextHops[*neighbour] = cell;
+				open.emplace(newDistance, *neighbour);
+			}
+		}
+	}
+}
@@ -0,0 +1,78 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <queue>
+
+struct ACOGrid;
+
+/** where a next hop leads to */
+enum class EACORouteTarget : uint8
+{
+	/** the nearest food source */
+	Food,
+	/** the anthill of the channel, channel i belongs to ACOGrid::Anthills[i] */
+	Anthill,
+	Num
+};
+
+/**
+ * Next neighbour of every cell on the cheapest route to a target along the trails of a channel.
+ * Entering a cell costs 1 / (1 + level / ReferenceLevel), so an unmarked cell costs one step and trails are cheaper.
+ * The tables are shortest path trees towards the targets. Update only repairs the parts of the trees below cells whose
+ * cost changed by more than the tolerance, a full rebuild is only needed when the targets change.
+ */
+class ACO_API ACONextHopTable
+{
+public:
+	ACONextHopTable(const ACOGrid& grid, float referenceLevel);
+
+	/** relative cost change below which a cell keeps its old cost */
+	void SetTolerance(float tolerance) { m_tolerance = tolerance; }
+
+	/** levels has the channels of a cell next to each other, see ACOPheromoneField::GetPheromoneLevels */
+	void Update(const TArray<float>& pheromoneLevels, int32 channels);
+
+	int32 GetChannelAmount() const { return m_channels; }
+	/** INDEX_NONE at the target and where it can't be reached */
+	int32 GetNextHop(int32 cell, int32 channel, EACORouteTarget target) const { return getTree(channel, target).NextHops[cell]; }
+	/** cost of the route from the cell to the target, MAX_FLT if it can't be reached */
+	float GetDistance(int32 cell, int32 channel, EACORouteTarget target) const { return getTree(channel, target).Distances[cell]; }
+	/** the next hops of a tree, see GetTreeIndex */
+	const TArray<int32>& GetNextHops(int32 tree) const { return m_trees[tree].NextHops; }
+	/** cells which got a new cost with the last update */
+	int32 GetChangedCellAmount() const { return m_changedCells; }
+
+	static int32 GetTreeIndex(int32 channel, EACORouteTarget target) { return channel * static_cast<int32>(EACORouteTarget::Num) + static_cast<int32>(target); }
+
+private:
+	struct Tree
+	{
+		int32 Channel;
+		EACORouteTarget Target;
+		/** sorted, compared to find out if the tree has to be rebuilt */
+		TArray<int32> Targets;
+		TArray<float> Distances;
+		TArray<int32> NextHops;
+	};
+
+	typedef std::priority_queue<std::pair<float, int32>, std::vector<std::pair<float, int32>>, std::greater<std::pair<float, int32>>> DistanceQueue;
+
+	const Tree& getTree(int32 channel, EACORouteTarget target) const { return m_trees[GetTreeIndex(channel, target)]; }
+	float getCost(float pheromoneLevel) const { return 1.f / (1.f + pheromoneLevel / m_referenceLevel); }
+	void getTargets(const Tree& tree, TArray<int32>& targets) const;
+	void build(Tree& tree);
+	/** increased and decreased are the cells whose cost changed */
+	void repair(Tree& tree, const TArray<int32>& increased, const TArray<int32>& decreased);
+	/** Dijkstra towards the targets from the cells which are already in the queue, distances are only lowered */
+	void propagate(Tree& tree, DistanceQueue& open);
+
+	const ACOGrid& m_grid;
+	float m_referenceLevel;
+	float m_tolerance;
+	int32 m_channels;
+	/** entering cost of every cell per channel, [channel * cells + cell] */
+	TArray<float> m_costs;
+	TArray<Tree> m_trees;
+	int32 m_changedCells;
+};
@@ -0,0 +1,87 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ACO.h"
+#include "ACOParameters.h"
+
+ACOParameters::ACOParameters() : TraversePhaseConstantA(5.f), TraversePhaseConstantB(9.f), EvaporationCoefficentP(0.05f), AntAmount(5000), Seed(0),
+	Variant(EACOVariant::AntSystem), ExploitationProbabilityQ0(0.9f), LocalEvaporationCoefficentXi(0.1f), InitialPheromoneLevel(1.f),
+	MinPheromoneLevel(1.f), MaxPheromoneLevel(100.f), RankedTrips(6), EraseLoops(false), EventDriven(false), TravelTimePerCost(0.1f),
+	StepKernel(PLATFORM_ENABLE_VECTORINTRINSICS ? EACOStepKernel::VectorLanes : EACOStepKernel::ScalarLanes), PheromoneStorage(EACOPheromoneStorage::Float), Deterministic(false)
+{
+}
+
+const TCHAR* ACOParameters::GetVariantName(EACOVariant variant)
+{
+	switch (variant)
+	{
+	case EACOVariant::AntSystem: return TEXT("AntSystem");
+	case EACOVariant::AntColonySystem: return TEXT("AntColonySystem");
+	case EACOVariant::MaxMin: return TEXT("MaxMin");
+	case EACOVariant::RankBased: return TEXT("RankBased");
+	default:
+		return TEXT("Unknown");
+	}
+}
+
+bool ACOParameters::ParseVariant(const FString& name, EACOVariant& variant)
+{
+	for (EACOVariant a : { EACOVariant::AntSystem, EACOVariant::AntColonySystem, EACOVariant::MaxMin, EACOVariant::RankBased })
+	{
+		if (name == GetVariantName(a))
+		{
+			variant = a;
+			return true;
+		}
+	}
+	return false;
+}
+
+const TCHAR* ACOParameters::GetStepKernelName(EACOStepKernel kernel)
+{
+	switch (kernel)
+	{
+	case EACOStepKernel::PerAnt: return TEXT("PerAnt");
+	case EACOStepKernel::ScalarLanes: return TEXT("ScalarLanes");
+	case EACOStepKernel::VectorLanes: return TEXT("VectorLanes");
+	default:
+		return TEXT("Unknown");
+	}
+}
+
+bool ACOParameters::ParseStepKernel(const FString& name, EACOStepKernel& kernel)
+{
+	for (EACOStepKernel a : { EACOStepKernel::PerAnt, EACOStepKernel::ScalarLanes, EACOStepKernel::VectorLanes })
+	{
+		if (name == GetStepKernelName(a))
+		{
+			kernel = a;
+			return true;
+		}
+	}
+	return false;
+}
+
+const TCHAR* ACOParameters::GetPheromoneStorageName(EACOPheromoneStorage storage)
+{
+	switch (storage)
+	{
+	case EACOPheromoneStorage::Float: return TEXT("Float");
+	case EACOPheromoneStorage::Half: return TEXT("Half");
+	case EACOPheromoneStorage::Log16: return TEXT("Log16");
+	default:
+		return TEXT("Unknown");
+	}
+}
+
+bool ACOParameters::ParsePheromoneStorage(const FString& name, EACOPheromoneStorage& storage)
+{
+	for (EACOPheromoneStorage a : { EACOPheromoneStorage::Float, EACOPheromoneStorage::Half, EACOPheromoneStorage::Log16 })
+	{
+		if (name == GetPheromoneStorageName(a))
+		{
+			storage = a;
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+/** update rules of the colony, see ACOPolicies.h */
+enum class EACOVariant : uint8
+{
+	AntSystem,
+	/** pseudo-random-proportional choice, local updates and only the best-so-far trip deposits */
+	AntColonySystem,
+	/** only the iteration-best trips deposit, pheromones are bound to [MinPheromoneLevel, MaxPheromoneLevel] */
+	MaxMin,
+	/** trips deposit weighted by their rank among the best trips of the previous iteration */
+	RankBased
+};
+
+/** how the searching ants of a traverse phase choose their next cell, all kernels choose the same cells, see ACOLanes.h */
+enum class EACOStepKernel : uint8
+{
+	/** one ant after another */
+	PerAnt,
+	/** groups of ants in plain float loops */
+	ScalarLanes,
+	/** groups of ants in vector registers (SSE / NEON) */
+	VectorLanes
+};
+
+/** how ACOPheromoneField stores the levels */
+enum class EACOPheromoneStorage : uint8
+{
+	Float,
+	/** 16 bit IEEE half, about 3 significant digits up to 65504 */
+	Half,
+	/** 16 bit logarithm of the level, the same relative precision from 2^-16 to 2^24 */
+	Log16
+};
+
+struct ACO_API ACOParameters
+{
+	ACOParameters();
+
+	float TraversePhaseConstantA;
+	float TraversePhaseConstantB;
+	float EvaporationCoefficentP;
+	int32 AntAmount;
+	int32 Seed;
+
+	EACOVariant Variant;
+	/** Ant Colony System: probability to move to the best neighbour instead of a random one */
+	float ExploitationProbabilityQ0;
+	/** Ant Colony System: local update tau = (1 - xi) * tau + xi * tau0 */
+	float LocalEvaporationCoefficentXi;
+	float InitialPheromoneLevel;
+	/** MAX-MIN: bounds of the pheromone level */
+	float MinPheromoneLevel;
+	float MaxPheromoneLevel;
+	/** rank-based: amount of ranked trips */
+	int32 RankedTrips;
+	/** a searching ant which moves next to an earlier cell of its trip cuts the detour in between from the trip */
+	bool EraseLoops;
+	/** an ant moves again TravelTimePerCost * terrain cost iterations (at least one) after it entered a cell, instead of every iteration */
+	bool EventDriven;
+	float TravelTimePerCost;
+	/** transitions with a local update (Ant Colony System) always move one ant after another */
+	EACOStepKernel StepKernel;
+	/** storage of a pheromone field the colony creates itself */
+	EACOPheromoneStorage PheromoneStorage;
+	/**
+	 * the results only depend on the seed, not on the amount of workers: every ant draws from its own random stream, the field
+	 * sums the deposits in fixed point and applies the local updates of Ant Colony System at the end of the iteration
+	 */
+	bool Deterministic;
+
+	static const TCHAR* GetVariantName(EACOVariant variant);
+	static bool ParseVariant(const FString& name, EACOVariant& variant);
+	static const TCHAR* GetStepKernelName(EACOStepKernel kernel);
+	static bool ParseStepKernel(const FString& name, EACOStepKernel& kernel);
+	static const TCHAR* GetPheromoneStorageName(EACOPheromoneStorage storage);
+	static bool ParsePheromoneStorage(const FString& name, EACOPheromoneStorage& storage);
+};
@@ -0,0 +1,323 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ACO.h"
+#include "ACOPheromoneField.h"
+
+namespace
+{
+	/** compare and swap on the bits of a float, replaces the critical section per hexagon */
+	template<typename TOperation>
+	void atomicUpdate(float* value, TOperation operation)
+	{
+		static_assert(sizeof(float) == sizeof(int32), "float has to fit into int32");
+		volatile int32* bits = reinterpret_cast<volatile int32*>(value);
+		int32 expected = *bits;
+		while (true)
+		{
+			float current;
+			FMemory::Memcpy(&current, &expected, sizeof(float));
+			float desired = operation(current);
+			int32 desiredBits;
+			FMemory::Memcpy(&desiredBits, &desired, sizeof(float));
+			int32 previous = FPlatformAtomics::InterlockedCompareExchange(bits, desiredBits, expected);
+			if (previous == expected)
+				return;
+			expected = previous;
+		}
+	}
+
+	/** compare and swap on 32 bits, the operation returns the new value */
+	template<typename TOperation>
+	void atomicUpdateBits(int32* value, TOperation operation)
+	{
+		volatile int32* bits = value;
+		int32 expected = *bits;
+		while (true)
+		{
+			int32 previous = FPlatformAtomics::InterlockedCompareExchange(bits, operation(expected), expected);
+			if (previous == expected)
+				return;
+			expected = previous;
+		}
+	}
+}
+
+//2^24, deposits are exact to 6e-8 and a level can take 5e11 of them
+const double ACOPheromoneField::FixedPointScale = 16777216.0;
+
+ACOPheromoneField::ACOPheromoneField() : m_channels(0), m_levelAmount(0), m_storage(EACOPheromoneStorage::Float), m_decodeTable(nullptr), m_isDeterministic(false)
+{
+}
+
+ACOPheromoneField::ACOPheromoneField(int32 cellAmount, int32 channels, EACOPheromoneStorage storage, bool isDeterministic)
+	: m_channels(0), m_levelAmount(0), m_storage(EACOPheromoneStorage::Float), m_decodeTable(nullptr), m_isDeterministic(false)
+{
+	Init(cellAmount, channels, storage, isDeterministic);
+}
+
+ACOPheromoneField::~ACOPheromoneField()
+{
+	releaseAddedPheromoneBlocks();
+}
+
+void ACOPheromoneField::Init(int32 cellAmount, int32 channels, EACOPheromoneStorage storage, bool isDeterministic)
+{
+	m_channels = channels;
+	m_storage = storage;
+	m_decodeTable = getDecodeTable(storage);
+	const int32 levels = cellAmount * channels;
+	m_levelAmount = levels;
+	releaseAddedPheromoneBlocks();
+	if (m_decodeTable)
+	{
+		m_pheromoneLevels.Empty();
+		m_compactLevels.SetNumZeroed(levels + (levels & 1));
+		m_depositFlags.SetNumZeroed((levels + DepositBlockSize - 1) / DepositBlockSize);
+		//the compact storages only keep accumulators for the flag words which got pheromones, a deterministic field uses its fixed point sums
+		if (!isDeterministic)
+			m_addedPheromoneBlocks.SetNumZeroed(m_depositFlags.Num());
+		m_addedPheromones.Empty();
+	}
+	else
+	{
+		m_pheromoneLevels.SetNumZeroed(levels);
+		m_compactLevels.Empty();
+		m_depositFlags.Empty();
+		m_addedPheromones.SetNumZeroed(isDeterministic ? 0 : levels);
+	}
+	m_maxPheromoneLevels.SetNumZeroed(channels);
+	m_isDeterministic = isDeterministic;
+	if (isDeterministic)
+	{
+		m_fixedPointDeposits.SetNumZeroed(levels);
+		m_localUpdates.SetNumZeroed(levels);
+	}
+	else
+	{
+		m_fixedPointDeposits.Empty();
+		m_localUpdates.Empty();
+	}
+}
+
+const float* ACOPheromoneField::getDecodeTable(EACOPheromoneStorage storage)
+{
+	struct DecodeTable
+	{
+		DecodeTable(EACOPheromoneStorage storage)
+		{
+			for (int32 code = 0; code < 65536; ++code)
+			{
+				if (storage == EACOPheromoneStorage::Half)
+				{
+					//only positive normal halfs and 0 are encoded
+					uint32 bits = code == 0 ? 0 : (static_cast<uint32>(code & 0x7fff) + ((127 - 15) << 10)) << 13;
+					FMemory::Memcpy(&Levels[code], &bits, sizeof(float));
+				}
+				else
+				{
+					Levels[code] = code == 0 ? 0.f : FMath::Exp2((code - 1) * (40.f / 65534.f) - 16.f);
+				}
+			}
+		}
+
+		float Levels[65536];
+	};
+
+	static const DecodeTable halfTable(EACOPheromoneStorage::Half);
+	static const DecodeTable log16Table(EACOPheromoneStorage::Log16);
+	switch (storage)
+	{
+	case EACOPheromoneStorage::Half:
+		return halfTable.Levels;
+	case EACOPheromoneStorage::Log16:
+		return log16Table.Levels;
+	default:
+		return nullptr;
+	}
+}
+
+float ACOPheromoneField::GetTotalPheromoneLevel(int32 cell) const
+{
+	float total = 0.f;
+	for (int32 channel = 0; channel < m_channels; ++channel)
+		total += GetPheromoneLevel(cell, channel);
+	return total;
+}
+
+const TArray<float>& ACOPheromoneField::GetPheromoneLevels(TArray<float>& decodedLevels) const
+{
+	if (!m_decodeTable)
+		return m_pheromoneLevels;
+	decodedLevels.SetNumUninitialized(m_levelAmount);
+	CopyPheromoneLevels(decodedLevels.GetData());
+	return decodedLevels;
+}
+
+void ACOPheromoneField::CopyPheromoneLevels(float* levels) const
+{
+	if (!m_decodeTable)
+	{
+		FMemory::Memcpy(levels, m_pheromoneLevels.GetData(), m_pheromoneLevels.Num() * sizeof(float));
+		return;
+	}
+	for (int32 i = 0; i < m_levelAmount; ++i)
+		levels[i] = m_decodeTable[m_compactLevels[i]];
+}
+
+void ACOPheromoneField::CopyAddedPheromones(float* addedPheromones) const
+{
+	if (m_isDeterministic)
+	{
+		for (int32 i = 0; i < m_levelAmount; ++i)
+			addedPheromones[i] = static_cast<float>(m_fixedPointDeposits[i] / FixedPointScale);
+		return;
+	}
+	if (!m_decodeTable)
+	{
+		FMemory::Memcpy(addedPheromones, m_addedPheromones.GetData(), m_levelAmount * sizeof(float));
+		return;
+	}
+	//the evaporation zeroes the accumulator of every level it takes, so a block only holds the pending deposits
+	for (int32 block = 0; block < m_addedPheromoneBlocks.Num(); ++block)
+	{
+		const int32 first = block * DepositBlockSize;
+		const int32 amount = FMath::Min(DepositBlockSize, m_levelAmount - first);
+		if (m_addedPheromoneBlocks[block])
+			FMemory::Memcpy(addedPheromones + first, m_addedPheromoneBlocks[block], amount * sizeof(float));
+		else
+			FMemory::Memzero(addedPheromones + first, amount * sizeof(float));
+	}
+}
+
+uint32 ACOPheromoneField::GetHash() const
+{
+	const uint32 hash = m_decodeTable ? FCrc::MemCrc32(m_compactLevels.GetData(), m_compactLevels.Num() * sizeof(uint16))
+		: FCrc::MemCrc32(m_pheromoneLevels.GetData(), m_pheromoneLevels.Num() * sizeof(float));
+	return FCrc::MemCrc32(m_maxPheromoneLevels.GetData(), m_maxPheromoneLevels.Num() * sizeof(float), hash);
+}
+
+void ACOPheromoneField::AddPheromones(int32 cell, int32 channel, float amount)
+{
+	const int32 index = cell * m_channels + channel;
+	if (m_isDeterministic)
+		FPlatformAtomics::InterlockedAdd(&m_fixedPointDeposits[index], static_cast<int64>(amount * FixedPointScale + 0.5));
+	else
+		atomicUpdate(m_decodeTable ? getAddedPheromones(index) : &m_addedPheromones[index], [amount](float current) { return current + amount; });
+	if (m_decodeTable)
+		setDepositFlag(index);
+}
+
+void ACOPheromoneField::ApplyLocalUpdate(int32 cell, int32 channel, float localEvaporationCoefficentXi, float initialPheromoneLevel)
+{
+	auto localUpdate = [localEvaporationCoefficentXi, initialPheromoneLevel](float current)
+	{
+		return (1.0f - localEvaporationCoefficentXi) * current + localEvaporationCoefficentXi * initialPheromoneLevel;
+	};
+	const int32 index = cell * m_channels + channel;
+	if (m_isDeterministic)
+	{
+		//the other ants of the phase would see the update in an order which depends on the scheduling
+		FPlatformAtomics::InterlockedIncrement(&m_localUpdates[index]);
+		return;
+	}
+	if (!m_decodeTable)
+	{
+		atomicUpdate(&m_pheromoneLevels[index], localUpdate);
+		return;
+	}
+
+	//there is no 16 bit compare and swap on every platform, so the pair of levels the index belongs to is swapped
+	atomicUpdateBits(reinterpret_cast<int32*>(&m_compactLevels[index & ~1]), [this, index, &localUpdate](int32 current)
+	{
+		uint16 pair[2];
+		FMemory::Memcpy(pair, &current, sizeof(int32));
+		pair[index & 1] = encode(localUpdate(m_decodeTable[pair[index & 1]]));
+		int32 desired;
+		FMemory::Memcpy(&desired, pair, sizeof(int32));
+		return desired;
+	});
+}
+
+void ACOPheromoneField::setDepositFlag(int32 index)
+{
+	const int32 bit = 1 << (index & 31);
+	int32& flags = m_depositFlags[index >> 5];
+	//most deposits land on trails which are already flagged
+	if ((flags & bit) == 0)
+		atomicUpdateBits(&flags, [bit](int32 current) { return current | bit; });
+}
+
+void ACOPheromoneField::clearDepositFlag(int32 index)
+{
+	const int32 bit = 1 << (index & 31);
+	//the workers evaporate neighbouring ranges which can share a word
+	atomicUpdateBits(&m_depositFlags[index >> 5], [bit](int32 current) { return current & ~bit; });
+}
+
+float* ACOPheromoneField::getAddedPheromones(int32 index)
+{
+	float** block = &m_addedPheromoneBlocks[index / DepositBlockSize];
+	if (!*block)
+	{
+		//several ants can hit a new block at once, the first one installs its allocation
+		float* newBlock = static_cast<float*>(FMemory::Malloc(DepositBlockSize * sizeof(float)));
+		FMemory::Memzero(newBlock, DepositBlockSize * sizeof(float));
+		if (FPlatformAtomics::InterlockedCompareExchangePointer(reinterpret_cast<void**>(block), newBlock, nullptr) != nullptr)
+			FMemory::Free(newBlock);
+	}
+	return *block + index % DepositBlockSize;
+}
+
+void ACOPheromoneField::releaseAddedPheromoneBlocks()
+{
+	for (float* block : m_addedPheromoneBlocks)
+		FMemory::Free(block);
+	m_addedPheromoneBlocks.Empty();
+}
+
+void ACOPheromoneField::restore(const float* pheromoneLevels, const float* addedPheromones, const float* maxPheromoneLevels)
+{
+	const int32 levels = m_levelAmount;
+	if (m_decodeTable)
+	{
+		for (int32 i = 0; i < levels; ++i)
+		{
+			m_compactLevels[i] = encode(pheromoneLevels[i]);
+			if (addedPheromones[i] != 0.f)
+				setDepositFlag(i);
+			else
+				clearDepositFlag(i);
+			if (!m_isDeterministic && (addedPheromones[i] != 0.f || m_addedPheromoneBlocks[i / DepositBlockSize]))
+				*getAddedPheromones(i) = addedPheromones[i];
+		}
+	}
+	else
+	{
+		FMemory::Memcpy(m_pheromoneLevels.GetData(), pheromoneLevels, levels * sizeof(float));
+	}
+	if (m_isDeterministic)
+	{
+		for (int32 i = 0; i < levels; ++i)
+		{
+			m_fixedPointDeposits[i] = static_cast<int64>(addedPheromones[i] * FixedPointScale + 0.5);
+			m_localUpdates[i] = 0;
+		}
+	}
+	else if (!m_decodeTable)
+	{
+		FMemory::Memcpy(m_addedPheromones.GetData(), addedPheromones, levels * sizeof(float));
+	}
+	FMemory::Memcpy(m_maxPheromoneLevels.GetData(), maxPheromoneLevels, m_channels * sizeof(float));
+}
+
+void ACOPheromoneField::ResetMaxPheromoneLevels()
+{
+	for (auto& a : m_maxPheromoneLevels)
+		a = 0.f;
+}
+
+void ACOPheromoneField::updateMaxPheromoneLevel(int32 channel, float level)
+{
+	if (level > m_maxPheromoneLevels[channel])
+		atomicUpdate(&m_maxPheromoneLevels[channel], [level](float current) { return FMath::Max(current, level); });
+}
@@ -0,0 +1,230 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "ACOParameters.h"
+
+/**
+ * Pheromones of one or more colonies (channels) on a grid.
+ * The channels of a cell are stored next to each other, so a worker touching a cell gets all colonies in one cache line.
+ * A compact storage (EACOPheromoneStorage) keeps 16 bit levels and flags the cells which got pheromones, so the evaporation
+ * only reads the float accumulator of the deposited cells. The accumulator is sparse, a block of floats is allocated for a word
+ * of deposit flags at its first deposit and kept for the trails of the next iterations.
+ * A deterministic field sums the deposits as fixed point integers, which add up to the same value in any order, and only counts
+ * the local updates during the traverse phase, n updates in a row are applied at the evaporation in closed form.
+ */
+class ACO_API ACOPheromoneField
+{
+	friend class ACOSnapshot;
+
+public:
+	ACOPheromoneField();
+	ACOPheromoneField(int32 cellAmount, int32 channels, EACOPheromoneStorage storage = EACOPheromoneStorage::Float, bool isDeterministic = false);
+	~ACOPheromoneField();
+	ACOPheromoneField(const ACOPheromoneField&) = delete;
+	ACOPheromoneField& operator=(const ACOPheromoneField&) = delete;
+
+	void Init(int32 cellAmount, int32 channels, EACOPheromoneStorage storage = EACOPheromoneStorage::Float, bool isDeterministic = false);
+
+	int32 Num() const { return m_channels > 0 ? m_levelAmount / m_channels : 0; }
+	int32 GetChannelAmount() const { return m_channels; }
+	EACOPheromoneStorage GetStorage() const { return m_storage; }
+	bool IsDeterministic() const { return m_isDeterministic; }
+	float GetPheromoneLevel(int32 cell, int32 channel) const
+	{
+		const int32 index = cell * m_channels + channel;
+		return m_decodeTable ? m_decodeTable[m_compactLevels[index]] : m_pheromoneLevels[index];
+	}
+	float GetTotalPheromoneLevel(int32 cell) const;
+	/** levels of all cells, the channels of a cell next to each other, a compact storage is decoded into decodedLevels */
+	const TArray<float>& GetPheromoneLevels(TArray<float>& decodedLevels) const;
+	/** writes Num() * GetChannelAmount() levels in the order of GetPheromoneLevels */
+	void CopyPheromoneLevels(float* levels) const;
+	/** writes the pheromones added since the last evaporation in the order of GetPheromoneLevels */
+	void CopyAddedPheromones(float* addedPheromones) const;
+	/** CRC of the stored levels and the max levels, equal fields of the same storage have the same hash */
+	uint32 GetHash() const;
+	/** highest level of the channel since the last ResetMaxPheromoneLevels */
+	float GetMaxPheromoneLevel(int32 channel) const { return m_maxPheromoneLevels[channel]; }
+
+	/** not thread safe, only between two iterations, e.g. to seed the levels, see ACOMultiLevel */
+	void SetPheromoneLevel(int32 cell, int32 channel, float level)
+	{
+		setLevel(cell * m_channels + channel, level);
+		updateMaxPheromoneLevel(channel, level);
+	}
+
+	/** thread safe, the pheromones are added to the level with the next evaporation */
+	void AddPheromones(int32 cell, int32 channel, float amount);
+	/** thread safe, tau = (1 - xi) * tau + xi * tau0 directly on the level, a deterministic field applies it at the evaporation */
+	void ApplyLocalUpdate(int32 cell, int32 channel, float localEvaporationCoefficentXi, float initialPheromoneLevel);
+
+	/** applies the evaporation rule (see ACOPolicies.h) to one channel and adds the added pheromones */
+	template<typename TEvaporationRule>
+	void Evaporate(int32 first, int32 last, int32 channel, const ACOParameters& parameters);
+	/** same as above for all channels in one pass, channelParameters has one entry per channel */
+	template<typename TEvaporationRule>
+	void Evaporate(int32 first, int32 last, const ACOParameters* channelParameters);
+	void ResetMaxPheromoneLevels();
+
+private:
+	template<typename TEvaporationRule>
+	float evaporate(int32 index, float remainingPheromones, const ACOParameters& parameters);
+	void updateMaxPheromoneLevel(int32 channel, float level);
+
+	/** nearest code of the compact storage */
+	uint16 encode(float level) const { return m_storage == EACOPheromoneStorage::Half ? encodeHalf(level) : encodeLog16(level); }
+	static uint16 encodeHalf(float level);
+	static uint16 encodeLog16(float level);
+	/** level of every code, nullptr for floats */
+	static const float* getDecodeTable(EACOPheromoneStorage storage);
+	/** level before the evaporation, the counted local updates are applied and reset */
+	float takeLevel(int32 index, const ACOParameters& parameters);
+	void setLevel(int32 index, float level);
+	/** clears the flag and the accumulator, the flag of a compact storage tells if the accumulator has to be read at all */
+	float takeAddedPheromones(int32 index);
+	void setDepositFlag(int32 index);
+	void clearDepositFlag(int32 index);
+	/** accumulator of a compact storage, the block of the flag word is allocated by the first deposit */
+	float* getAddedPheromones(int32 index);
+	void releaseAddedPheromoneBlocks();
+	/** sets the state of a snapshot, every array has one entry per level or channel */
+	void restore(const float* pheromoneLevels, const float* addedPheromones, const float* maxPheromoneLevels);
+
+	int32 m_channels;
+	/** cells * channels */
+	int32 m_levelAmount;
+	EACOPheromoneStorage m_storage;
+	const float* m_decodeTable;
+	/** float storage */
+	TArray<float> m_pheromoneLevels;
+	/** compact storage, padded to an even amount so the compare and swap of a local update can use the surrounding 32 bits */
+	TArray<uint16> m_compactLevels;
+	/** compact storage: one bit per level which got pheromones since the last evaporation */
+	TArray<int32> m_depositFlags;
+	/** compact storage: one block of DepositBlockSize floats per word of m_depositFlags, nullptr until its first deposit */
+	TArray<float*> m_addedPheromoneBlocks;
+	/** float storage */
+	TArray<float> m_addedPheromones;
+	TArray<float> m_maxPheromoneLevels;
+	/** deterministic field: the added pheromones in units of 1 / FixedPointScale and the local updates of the current traverse phase */
+	bool m_isDeterministic;
+	TArray<int64> m_fixedPointDeposits;
+	TArray<int32> m_localUpdates;
+
+	static const double FixedPointScale;
+	/** levels per deposit flag word */
+	static const int32 DepositBlockSize = 32;
+};
+
+inline uint16 ACOPheromoneField::encodeHalf(float level)
+{
+	//levels are positive, the ones below the smallest normal half are 0 and the larger ones are clamped to the largest half
+	if (!(level >= 6.1035156e-05f))
+		return 0;
+	if (level >= 65504.f)
+		return 0x7bff;
+	uint32 bits;
+	FMemory::Memcpy(&bits, &level, sizeof(float));
+	//round the 13 dropped mantissa bits to nearest even, a carry moves into the exponent, then rebias the exponent from 127 to 15
+	bits += 0xfff + ((bits >> 13) & 1);
+	return static_cast<uint16>((bits >> 13) - ((127 - 15) << 10));
+}
+
+inline uint16 ACOPheromoneField::encodeLog16(float level)
+{
+	//code 0 is 0, the codes 1 to 65535 cover log2 levels from -16 to 24 evenly
+	if (!(level >= 1.52587891e-05f))
+		return 0;
+	const int32 code = 1 + FMath::RoundToInt((FMath::Log2(level) + 16.f) * (65534.f / 40.f));
+	return static_cast<uint16>(FMath::Min(code, 65535));
+}
+
+inline float ACOPheromoneField::takeLevel(int32 index, const ACOParameters& parameters)
+{
+	const float level = m_decodeTable ? m_decodeTable[m_compactLevels[index]] : m_pheromoneLevels[index];
+	if (!m_isDeterministic || m_localUpdates[index] == 0)
+		return level;
+
+	//n local updates in a row: tau = (1 - xi)^n * tau + (1 - (1 - xi)^n) * tau0
+	const float remainingLevel = FMath::Pow(1.0f - parameters.LocalEvaporationCoefficentXi, static_cast<float>(m_localUpdates[index]));
+	m_localUpdates[index] = 0;
+	return remainingLevel * level + (1.0f - remainingLevel) * parameters.InitialPheromoneLevel;
+}
+
+inline void ACOPheromoneField::setLevel(int32 index, float level)
+{
+	if (m_decodeTable)
+		m_compactLevels[index] = encode(level);
+	else
+		m_pheromoneLevels[index] = level;
+}
+
+inline float ACOPheromoneField::takeAddedPheromones(int32 index)
+{
+	if (m_decodeTable)
+	{
+		if ((m_depositFlags[index >> 5] & (1 << (index & 31))) == 0)
+			return 0.f;
+		clearDepositFlag(index);
+	}
+	if (m_isDeterministic)
+	{
+		const int64 fixedPointDeposit = m_fixedPointDeposits[index];
+		m_fixedPointDeposits[index] = 0;
+		return static_cast<float>(fixedPointDeposit / FixedPointScale);
+	}
+	//a flagged level always has its block
+	float& addedPheromones = m_addedPheromoneBlocks[index / DepositBlockSize][index % DepositBlockSize];
+	const float amount = addedPheromones;
+	addedPheromones = 0.0f;
+	return amount;
+}
+
+template<typename TEvaporationRule>
+void ACOPheromoneField::Evaporate(int32 first, int32 last, int32 channel, const ACOParameters& parameters)
+{
+	const float remainingPheromones = 1.0f - parameters.EvaporationCoefficentP;
+	float maxLevel = 0.f;
+	for (int32 cell = first; cell < last; ++cell)
+		maxLevel = FMath::Max(maxLevel, evaporate<TEvaporationRule>(cell * m_channels + channel, remainingPheromones, parameters));
+	updateMaxPheromoneLevel(channel, maxLevel);
+}
+
+template<typename TEvaporationRule>
+void ACOPheromoneField::Evaporate(int32 first, int32 last, const ACOParameters* channelParameters)
+{
+	//at most a few colonies, so the per channel values stay on the stack
+	TArray<float, TInlineAllocator<8>> remainingPheromones;
+	TArray<float, TInlineAllocator<8>> maxLevels;
+	for (int32 channel = 0; channel < m_channels; ++channel)
+	{
+		remainingPheromones.Add(1.0f - channelParameters[channel].EvaporationCoefficentP);
+		maxLevels.Add(0.f);
+	}
+
+	for (int32 index = first * m_channels; index < last * m_channels; index += m_channels)
+	{
+		for (int32 channel = 0; channel < m_channels; ++channel)
+			maxLevels[channel] = FMath::Max(maxLevels[channel], evaporate<TEvaporationRule>(index + channel, remainingPheromones[channel], channelParameters[channel]));
+	}
+
+	for (int32 channel = 0; channel < m_channels; ++channel)
+		updateMaxPheromoneLevel(channel, maxLevels[channel]);
+}
+
+template<typename TEvaporationRule>
+float ACOPheromoneField::evaporate(int32 index, float remainingPheromones, const ACOParameters& parameters)
+{
+	if (m_decodeTable || m_isDeterministic)
+	{
+		const float level = TEvaporationRule::Evaporate(takeLevel(index, parameters), takeAddedPheromones(index), remainingPheromones, parameters);
+		setLevel(index, level);
+		return level;
+	}
+
+	float pheromoneLevel = TEvaporationRule::Evaporate(m_pheromoneLevels[index], m_addedPheromones[index], remainingPheromones, parameters);
+	m_pheromoneLevels[index] = pheromoneLevel;
+	m_addedPheromones[index] = 0.0f;
+	return pheromoneLevel;
+}
@@ -7,6 +7,8 @@
 #include "Hexagon.h"
 #include "EngineUtils.h"
 #include "ACOWorker.h"
+#include "ACOSnapshot.h"
+#include "ACOSpatialPartition.h"
 
 TArray<class AHexagon*> AACOPlayerController::s_currentFoodSources;
 
@@ -20,6 +22,8 @@ AACOPlayerController::~AACOPlayerController()
 {
 	for (auto a : m_acoWorkers)
 		delete a;
+	for (auto a : m_colonies)
+		delete a;
 }
 
 TArray<AHexagon*>& AACOPlayerController::GetFoodSources()
@@ -45,13 +49,12 @@ void AACOPlayerController::SetupInputComponent()
 	InputComponent->BindAction("StartACO", IE_Pressed, this, &AACOPlayerController::startACO);
 	InputComponent->BindAction("TogglePauseACO", IE_Pressed, this, &AACOPlayerController::togglePauseACO);
 	InputComponent->BindAction("ToggleShowBestPath", IE_Pressed, this, &AACOPlayerController::toggleShowBestPath);
+	InputComponent->BindAction("ChangeTerrain", IE_Pressed, this, &AACOPlayerController::changeTerrain);
 }
 
 void AACOPlayerController::Destroyed()
 {
 	APlayerController::Destroyed();
-	if (m_isAcoPaused)
-		togglePauseACO();
 	killACOWorker();
 }
 
@@ -69,11 +72,29 @@ void AACOPlayerController::addOrDeleteFoodSource()
 	hex->SetFoodSource(!containsFoodSource);
 }
 
+void AACOPlayerController::changeTerrain()
+{
+	static const ETerrainType walkableTypes[] = { ETerrainType::TT_Street, ETerrainType::TT_Grass, ETerrainType::TT_Sand, ETerrainType::TT_Mud, ETerrainType::TT_Water };
+
+	//a changed walkability would need a new grid, so mountains and anthills stay
+	auto hex = getMouseTargetedHexagon();
+	if (!hex || !hex->IsWalkable() || hex->GetTerrainType() == ETerrainType::TT_Anthill) return;
+
+	int32 index = 0;
+	while (index < ARRAY_COUNT(walkableTypes) && walkableTypes[index] != hex->GetTerrainType())
+		++index;
+	const ETerrainType type = walkableTypes[(index + 1) % ARRAY_COUNT(walkableTypes)];
+	if (m_isAcoRunning && !ACOWorker::SetTerrainType(hex, type))
+		return;
+	hex->SetTerrainType(type);
+}
+
 void AACOPlayerController::addFoodSource(AHexagon* hex)
 {
 	GLog->Log("added food source!");
 	s_currentFoodSources.Add(hex);
 	hex->ActivateBlinking(true);
+	ACOWorker::SetFoodSource(hex, true);
 }
 
 void AACOPlayerController::deleteFoodSource(AHexagon* hex)
@@ -81,6 +102,7 @@ void AACOPlayerController::deleteFoodSource(AHexagon* hex)
 	GLog->Log("deleted food source!");
 	hex->ActivateBlinking(false);
 	s_currentFoodSources.Remove(hex);
+	ACOWorker::SetFoodSource(hex, false);
 }
 
 AHexagon* AACOPlayerController::getMouseTargetedHexagon() const
@@ -114,54 +136,133 @@ void AACOPlayerController::startACO()
 		return;
 	}
 
+	//ants per colony
 	int antAmount = 5000;
 	//how much threads?
 	int acoThreads = 10;
-	AHexagon* antHill = nullptr;
-	TArray<AHexagon*> usableHex;
 
-	for (auto a : m_worldHex)
+	//a baked grid skips the overlap queries of the hexagons, -ACOGrid=<file> loads another one
+	const double gridTime = FPlatformTime::Seconds();
+	FString gridFilename = ACOGrid::GetBakedFilename(GetWorld());
+	FParse::Value(FCommandLine::Get(), TEXT("ACOGrid="), gridFilename);
+	const bool isGridBaked = ACOGrid::LoadBaked(gridFilename, m_grid) && m_grid.AttachHexagons(m_worldHex);
+	if (!isGridBaked)
+	{
+		UE_LOG(LogACO, Warning, TEXT("No matching baked grid %s, creating the grid from the hexagons"), *gridFilename);
+		m_grid = ACOGrid::CreateFromHexagons(m_worldHex);
+	}
+	UE_LOG(LogACO, Log, TEXT("Grid with %d cells %s in %.3f ms"), m_grid.Num(), isGridBaked ? TEXT("loaded") : TEXT("created"), (FPlatformTime::Seconds() - gridTime) * 1000.0);
+	//the partition curve also decides the storage order of the cells, unless -ACOCellOrder=Hilbert|Morton|None says otherwise
+	EACOSpaceFillingCurve curve = EACOSpaceFillingCurve::Hilbert;
+	FString curveName;
+	if (FParse::Value(FCommandLine::Get(), TEXT("ACOPartition="), curveName) && !ACOSpatialPartition::ParseCurve(curveName, curve))
+		UE_LOG(LogACO, Warning, TEXT("Unknown partition %s, using %s"), *curveName, ACOSpatialPartition::GetCurveName(curve));
+	EACOSpaceFillingCurve cellOrder = curve;
+	if (FParse::Value(FCommandLine::Get(), TEXT("ACOCellOrder="), curveName) && !ACOSpatialPartition::ParseCurve(curveName, cellOrder))
+		UE_LOG(LogACO, Warning, TEXT("Unknown cell order %s, using %s"), *curveName, ACOSpatialPartition::GetCurveName(cellOrder));
+	if (cellOrder != EACOSpaceFillingCurve::None)
+		m_grid.RenumberCells(ACOSpatialPartition::GetCurveOrder(m_grid, cellOrder));
+	int usableHex = 0;
+	for (int32 cell = 0; cell < m_grid.Num(); ++cell)
 	{
-		if (a->IsWalkable())
-		{
-			//locate anthill hexagon
-			if (!antHill && a->GetTerrainType() == ETerrainType::TT_Anthill)
-				antHill = a;
-
-			//locate usable hexs
-			if(antHill != a)
-				usableHex.Push(a);
-		}
+		if (m_grid.IsWalkable(cell) && !m_grid.IsAnthill(cell))
+			++usableHex;
 	}
-	if (!antHill || usableHex.Num() == 0)
+	if (m_grid.Anthills.Num() == 0 || usableHex == 0)
 	{
 		UE_LOG(LogACO, Error, TEXT("Couldn't find Anthill OR there is no usable/ walkable Hexagon!!!"));
 		return;
 	}
 
-	/** split the resoures and create the thread worker */
-	int hexFractionPerThread = usableHex.Num() / acoThreads;
+	//update rules, e.g. -ACOVariant=MaxMin
+	ACOParameters parameters;
+	parameters.AntAmount = antAmount;
+	FString variant;
+	if (FParse::Value(FCommandLine::Get(), TEXT("ACOVariant="), variant) && !ACOParameters::ParseVariant(variant, parameters.Variant))
+		UE_LOG(LogACO, Warning, TEXT("Unknown ACO variant %s, using %s"), *variant, ACOParameters::GetVariantName(parameters.Variant));
+	parameters.EraseLoops = FParse::Param(FCommandLine::Get(), TEXT("ACOEraseLoops"));
+	//-ACOEventDriven -ACOTravelTimePerCost=0.1, street = 1 iteration, water = 5 iterations
+	parameters.EventDriven = FParse::Param(FCommandLine::Get(), TEXT("ACOEventDriven"));
+	FParse::Value(FCommandLine::Get(), TEXT("ACOTravelTimePerCost="), parameters.TravelTimePerCost);
+	//-ACOStepKernel=PerAnt|ScalarLanes|VectorLanes, all kernels move the ants the same way
+	FString stepKernel;
+	if (FParse::Value(FCommandLine::Get(), TEXT("ACOStepKernel="), stepKernel) && !ACOParameters::ParseStepKernel(stepKernel, parameters.StepKernel))
+		UE_LOG(LogACO, Warning, TEXT("Unknown step kernel %s, using %s"), *stepKernel, ACOParameters::GetStepKernelName(parameters.StepKernel));
+	//-ACOPheromoneStorage=Float|Half|Log16, the 16 bit storages halve the memory traffic of large maps
+	FString pheromoneStorage;
+	if (FParse::Value(FCommandLine::Get(), TEXT("ACOPheromoneStorage="), pheromoneStorage) && !ACOParameters::ParsePheromoneStorage(pheromoneStorage, parameters.PheromoneStorage))
+		UE_LOG(LogACO, Warning, TEXT("Unknown pheromone storage %s, using %s"), *pheromoneStorage, ACOParameters::GetPheromoneStorageName(parameters.PheromoneStorage));
+
+	//-ACODeterministic -ACOSeed=0, runs with the same seed give the same results with any amount of workers
+	parameters.Deterministic = FParse::Param(FCommandLine::Get(), TEXT("ACODeterministic"));
+	FParse::Value(FCommandLine::Get(), TEXT("ACOSeed="), parameters.Seed);
+
+	/** every anthill gets its own colony and pheromone channel */
+	m_pheromoneField.Init(m_grid.Num(), m_grid.Anthills.Num(), parameters.PheromoneStorage, parameters.Deterministic);
+	for (int32 channel = 0; channel < m_grid.Anthills.Num(); ++channel)
+	{
+		m_colonies.Push(new ACOColony(m_grid, m_pheromoneField, channel, m_grid.Anthills[channel], parameters));
+	}
+
+	//e.g. -OnConvergence=Stop -ConvergenceWindow=100, see ACOConvergenceCriteria
+	ACOConvergenceCriteria convergenceCriteria;
+	convergenceCriteria.Parse(FCommandLine::Get());
+	ACOWorker::SetConvergenceCriteria(convergenceCriteria);
+	//-ACOTrace=<file>.csv, written when the workers are killed
+	ACOTrace::EnableFromCommandLine(FCommandLine::Get());
+	//-ACOLog=<file>, see ACOIterationLog
+	m_iterationLog.Reset(new ACOIterationLog());
+	ACOWorker::SetIterationLog(m_iterationLog->OpenFromCommandLine(FCommandLine::Get(), m_grid.Num(), m_pheromoneField.GetChannelAmount(), m_colonies.Num()) ? m_iterationLog.Get() : nullptr);
+	//-ACOSharedMemory=<name>, see ACOSharedMemoryExport
+	m_sharedMemoryExport.Reset(new ACOSharedMemoryExport());
+	ACOWorker::SetSharedMemoryExport(m_sharedMemoryExport->OpenFromCommandLine(FCommandLine::Get(), m_grid, m_pheromoneField.GetChannelAmount(), m_colonies.Num()) ? m_sharedMemoryExport.Get() : nullptr);
+	//disabled unless -ACORouteEpochInterval=10 -ACORouteEpochThreshold=0.05, see ACORouteQueryService
+	m_routeQueryService.Reset(new ACORouteQueryService(m_grid, parameters.InitialPheromoneLevel));
+	m_routeQueryService->ParseCommandLine(FCommandLine::Get());
+	ACOWorker::SetRouteQueryService(m_routeQueryService->IsEnabled() ? m_routeQueryService.Get() : nullptr);
+
+	//-ACOResume=<file> continues a snapshot, -ACOCheckpoint=<file> -ACOCheckpointInterval=<iterations> writes them
+	FString snapshotFilename;
+	int32 iteration = 0;
+	if (FParse::Value(FCommandLine::Get(), TEXT("ACOResume="), snapshotFilename) && ACOSnapshot::Restore(snapshotFilename, m_pheromoneField, m_colonies, iteration))
+		ACOWorker::SetIterationCounter(iteration);
+	//-ACOMultiLevel -ACOCoarseFactor=8 seeds the trails from a coarse run, a resumed snapshot has its trails already, see ACOMultiLevel
+	ACOMultiLevelSettings multiLevelSettings;
+	m_multiLevel.Reset();
+	if (multiLevelSettings.Parse(FCommandLine::Get()) && multiLevelSettings.IsEnabled)
+	{
+		m_multiLevel.Reset(new ACOMultiLevel(m_grid, m_grid.Anthills, parameters, multiLevelSettings));
+		if (iteration == 0)
+			m_multiLevel->Seed(m_pheromoneField);
+	}
+	ACOWorker::SetMultiLevel(m_multiLevel.Get());
+
+	snapshotFilename.Empty();
+	int32 checkpointInterval = 1000;
+	FParse::Value(FCommandLine::Get(), TEXT("ACOCheckpoint="), snapshotFilename);
+	FParse::Value(FCommandLine::Get(), TEXT("ACOCheckpointInterval="), checkpointInterval);
+	ACOWorker::SetCheckpoint(snapshotFilename, checkpointInterval);
+
+	//every worker evaporates a compact tile along a space-filling curve, e.g. -ACOPartition=Morton -ACOAntMigrationInterval=10
+	ACOSpatialPartition partition;
+	partition.Build(m_grid, acoThreads, curve);
+	int32 antMigrationInterval = 0;
+	FParse::Value(FCommandLine::Get(), TEXT("ACOAntMigrationInterval="), antMigrationInterval);
+	ACOWorker::SetAntMigration(partition.GetCellRanks(), antMigrationInterval);
+
+	/** split the resoures and create the thread worker, every worker gets a part of the ants of every colony */
 	int antAmountPerThread = antAmount / acoThreads;
 
-	
-	for (int i = 1; i <= acoThreads; ++i)
+	for (int i = 0; i < acoThreads; ++i)
 	{
-		TArray<AHexagon*> threadHex;
-		int threadAntAmount;
-		if (i == acoThreads)
-		{
-			//remaining hex/ants
-			threadAntAmount = antAmount;
-			threadHex = usableHex;
-		}
-		else
-		{
-			antAmount -= antAmountPerThread;
-			threadAntAmount = antAmountPerThread;
-			for (int x = 0; x < hexFractionPerThread; ++x)
-				threadHex.Push(usableHex.Pop());
-		}
-		m_acoWorkers.Push(new ACOWorker(threadHex, antHill, threadAntAmount));
+		//remaining ants go to the last worker
+		bool isLastThread = i == acoThreads - 1;
+
+		TArray<FIntPoint> antRanges;
+		for (int32 colony = 0; colony < m_colonies.Num(); ++colony)
+			antRanges.Add(FIntPoint(i * antAmountPerThread, isLastThread ? antAmount : (i + 1) * antAmountPerThread));
+
+		m_acoWorkers.Push(new ACOWorker(m_grid, m_pheromoneField, m_colonies, i < partition.GetTileAmount() ? partition.GetCellRanges(i) : TArray<FIntPoint>(), antRanges));
 	}
 
 	m_isAcoRunning = true;
@@ -171,13 +272,10 @@ void AACOPlayerController::startACO()
 void AACOPlayerController::togglePauseACO()
 {
 	if (m_acoWorkers.Num() == 0) return;
-	for(auto a : m_acoWorkers)
-	{
-		if (m_isAcoPaused)
-			a->Unpause();
-		else
-			a->Pause();
-	}
+	if (m_isAcoPaused)
+		ACOWorker::ResumeAll();
+	else
+		UE_LOG(LogACO, Log, TEXT("ACO workers paused after %.3f ms"), ACOWorker::PauseAll() * 1000.0);
 	m_isAcoPaused = !m_isAcoPaused;
 }
 
@@ -188,8 +286,35 @@ void AACOPlayerController::toggleShowBestPath()
 
 void AACOPlayerController::killACOWorker()
 {
+	//keep the state of a running colony, the workers write the snapshot at the next iteration boundary
+	if (m_acoWorkers.Num() > 0 && ACOWorker::IsCheckpointEnabled() && !m_isAcoPaused && !ACOWorker::HasStoppedOnConvergence())
+	{
+		const int32 checkpointCounter = ACOWorker::RequestCheckpoint();
+		const double timeout = FPlatformTime::Seconds() + 5.0;
+		while (ACOWorker::GetCheckpointCounter() == checkpointCounter && FPlatformTime::Seconds() < timeout)
+			FPlatformProcess::Sleep(0.01f);
+	}
+
+	//the workers leave at their next control point, paused ones are woken up
+	const double stopTime = FPlatformTime::Seconds();
+	ACOWorker::RequestStop();
 	for (auto a : m_acoWorkers)
-		a->Stop();
+		a->WaitForExit();
+	if (m_acoWorkers.Num() > 0)
+		UE_LOG(LogACO, Log, TEXT("ACO workers stopped after %.3f ms"), (FPlatformTime::Seconds() - stopTime) * 1000.0);
+	m_isAcoPaused = false;
+	ACOWorker::ReleaseBestPaths();
 
-	FPlatformProcess::Sleep(0.2);
+	if (ACOTrace::IsEnabled())
+		ACOTrace::Flush();
+	ACOSnapshot::WaitForPendingWrites();
+	ACOWorker::SetIterationLog(nullptr);
+	if (m_iterationLog)
+		m_iterationLog->Close();
+	ACOWorker::SetSharedMemoryExport(nullptr);
+	if (m_sharedMemoryExport)
+		m_sharedMemoryExport->Close();
+	//the last epoch stays available for queries
+	ACOWorker::SetRouteQueryService(nullptr);
+	ACOWorker::SetMultiLevel(nullptr);
 }
@@ -13,6 +13,8 @@ public:
 	AACOPlayerController();
 	~AACOPlayerController();
 	static TArray<class AHexagon*>& GetFoodSources();
+	/** best route queries of other systems, nullptr before the ACO was started */
+	ACORouteQueryService* GetRouteQueryService() const { return m_routeQueryService.Get(); }
 
 protected:
 
@@ -27,6 +29,8 @@ protected:
 	void addOrDeleteFoodSource();
 	void addFoodSource(class AHexagon* hex);
 	void deleteFoodSource(class AHexagon* hex);
+	/** cycles the walkable terrain of the targeted hexagon */
+	void changeTerrain();
 	class AHexagon* getMouseTargetedHexagon() const;
 
 	//pheormone level control
@@ -41,6 +45,14 @@ protected:
 	static TArray<class AHexagon*> s_currentFoodSources;
 	TArray<class AHexagon*> m_worldHex;
 	TArray<ACOWorker*> m_acoWorkers;
+	ACOGrid m_grid;
+	ACOPheromoneField m_pheromoneField;
+	/** one colony per anthill */
+	TArray<ACOColony*> m_colonies;
+	TUniquePtr<ACOIterationLog> m_iterationLog;
+	TUniquePtr<ACOSharedMemoryExport> m_sharedMemoryExport;
+	TUniquePtr<ACORouteQueryService> m_routeQueryService;
+	TUniquePtr<ACOMultiLevel> m_multiLevel;
 	bool m_isAcoRunning = false;
 	bool m_isAcoPaused = false;
 };
@@ -0,0 +1,200 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "ACOParameters.h"
+#include "ACOPheromoneField.h"
+#include <limits>
+
+/**
+ * Update rules of the colony as policy types. ACOColony and ACOPheromoneField are specialised on them at compile time,
+ * the variant is only looked at once per phase (see DispatchACOVariant), so the inner loops have no dispatch at all.
+ *
+ * Transition rule: int32 ChooseNeighbour(weights, amount, weightSum, parameters, randomStream) returns the chosen slot
+ *                  void OnMove(pheromoneField, cell, channel, parameters) is called for the new position of a searching ant
+ *                  bool CanMoveInLanes, ChooseNeighbour is ChooseProportional and OnMove does nothing, see ACOLanes.h
+ * Deposit rule:    float GetDepositFactor(tripCost, ranking, parameters) scales the pheromones of a trip, 0 = no deposit
+ * Evaporation rule: float Evaporate(level, addedPheromones, remainingPheromones, parameters) returns the new level
+ */
+
+/** best trips a deposit rule can rank a new trip against, only changes between iterations */
+struct ACOTripRanking
+{
+	ACOTripRanking() : BestTripCost(MAX_FLT) {}
+
+	/** best-so-far */
+	float BestTripCost;
+	/** the cheapest trips of the previous iteration, ascending */
+	TArray<float> PreviousIterationTripCosts;
+};
+
+namespace ACOPolicies
+{
+	/**
+	 * roulette wheel on the unnormalised weights, uniform in [0, 1) is scaled by the sum of the weights, so there is no normalisation
+	 * and no retry. The slot is the amount of cumulative weights at or below the target, the last slot takes what rounding leaves over.
+	 * Deterministic for a given uniform, so the distribution can be checked without a random stream.
+	 */
+	inline int32 SelectProportional(const float* weights, int32 amount, float weightSum, float uniform)
+	{
+		const float target = uniform * weightSum;
+		float cumulativeWeight = 0.f;
+		int32 slot = 0;
+		for (int32 i = 0; i < amount - 1; ++i)
+		{
+			cumulativeWeight += weights[i];
+			slot += cumulativeWeight <= target ? 1 : 0;
+		}
+		return slot;
+	}
+
+	/** random proportional choice, pij = weight j / sum of all weights, one draw */
+	inline int32 ChooseProportional(const float* weights, int32 amount, float weightSum, FRandomStream& randomStream)
+	{
+		return SelectProportional(weights, amount, weightSum, randomStream.FRand());
+	}
+}
+
+struct AntSystemTransition
+{
+	static const bool CanMoveInLanes = true;
+
+	static int32 ChooseNeighbour(const float* weights, int32 amount, float weightSum, const ACOParameters& parameters, FRandomStream& randomStream)
+	{
+		return ACOPolicies::ChooseProportional(weights, amount, weightSum, randomStream);
+	}
+
+	static void OnMove(ACOPheromoneField& pheromoneField, int32 cell, int32 channel, const ACOParameters& parameters) {}
+};
+
+struct AntColonySystemTransition
+{
+	/** the local updates change the weights of the following ants */
+	static const bool CanMoveInLanes = false;
+
+	/** pseudo-random-proportional rule, exploit the best neighbour with probability q0 */
+	static int32 ChooseNeighbour(const float* weights, int32 amount, float weightSum, const ACOParameters& parameters, FRandomStream& randomStream)
+	{
+		if (randomStream.FRand() >= parameters.ExploitationProbabilityQ0)
+			return ACOPolicies::ChooseProportional(weights, amount, weightSum, randomStream);
+
+		int32 best = 0;
+		for (int32 i = 1; i < amount; ++i)
+		{
+			if (weights[i] > weights[best])
+				best = i;
+		}
+		return best;
+	}
+
+	/** local update, makes the visited cell less attractive for the following ants */
+	static void OnMove(ACOPheromoneField& pheromoneField, int32 cell, int32 channel, const ACOParameters& parameters)
+	{
+		pheromoneField.ApplyLocalUpdate(cell, channel, parameters.LocalEvaporationCoefficentXi, parameters.InitialPheromoneLevel);
+	}
+};
+
+struct AntSystemDeposit
+{
+	static float GetDepositFactor(float tripCost, const ACOTripRanking& ranking, const ACOParameters& parameters)
+	{
+		return 1.f;
+	}
+};
+
+/** global update of the Ant Colony System, only trips as good as the best-so-far deposit */
+struct AntColonySystemDeposit
+{
+	static float GetDepositFactor(float tripCost, const ACOTripRanking& ranking, const ACOParameters& parameters)
+	{
+		return tripCost <= ranking.BestTripCost ? 1.f : 0.f;
+	}
+};
+
+/** only trips as good as the best of the previous iteration deposit */
+struct MaxMinDeposit
+{
+	static float GetDepositFactor(float tripCost, const ACOTripRanking& ranking, const ACOParameters& parameters)
+	{
+		float iterationBest = ranking.PreviousIterationTripCosts.Num() > 0 ? ranking.PreviousIterationTripCosts[0] : MAX_FLT;
+		return tripCost <= iterationBest ? 1.f : 0.f;
+	}
+};
+
+/** the trip of rank r among the RankedTrips best trips of the previous iteration deposits (w - r) / w */
+struct RankBasedDeposit
+{
+	static float GetDepositFactor(float tripCost, const ACOTripRanking& ranking, const ACOParameters& parameters)
+	{
+		int32 rank = tripCost <= ranking.BestTripCost ? 0 : 1;
+		for (float cost : ranking.PreviousIterationTripCosts)
+		{
+			if (cost < tripCost)
+				++rank;
+		}
+		return rank < parameters.RankedTrips ? static_cast<float>(parameters.RankedTrips - rank) / parameters.RankedTrips : 0.f;
+	}
+};
+
+struct AntSystemEvaporation
+{
+	static float Evaporate(float level, float addedPheromones, float remainingPheromones, const ACOParameters& parameters)
+	{
+		float pheromoneLevel = remainingPheromones * level + addedPheromones;
+		return pheromoneLevel < std::numeric_limits<float>::epsilon() ? 0.0f : pheromoneLevel;
+	}
+};
+
+/** cells without pheromones are weighted like a level of 1 in the transition, so the lower bound defaults to 1 */
+struct MaxMinEvaporation
+{
+	static float Evaporate(float level, float addedPheromones, float remainingPheromones, const ACOParameters& parameters)
+	{
+		return FMath::Clamp(remainingPheromones * level + addedPheromones, parameters.MinPheromoneLevel, parameters.MaxPheromoneLevel);
+	}
+};
+
+template<EACOVariant Variant>
+struct ACOVariantPolicies
+{
+	typedef AntSystemTransition Transition;
+	typedef AntSystemDeposit Deposit;
+	typedef AntSystemEvaporation Evaporation;
+};
+
+template<>
+struct ACOVariantPolicies<EACOVariant::AntColonySystem>
+{
+	typedef AntColonySystemTransition Transition;
+	typedef AntColonySystemDeposit Deposit;
+	typedef AntSystemEvaporation Evaporation;
+};
+
+template<>
+struct ACOVariantPolicies<EACOVariant::MaxMin>
+{
+	typedef AntSystemTransition Transition;
+	typedef MaxMinDeposit Deposit;
+	typedef MaxMinEvaporation Evaporation;
+};
+
+template<>
+struct ACOVariantPolicies<EACOVariant::RankBased>
+{
+	typedef AntSystemTransition Transition;
+	typedef RankBasedDeposit Deposit;
+	typedef AntSystemEvaporation Evaporation;
+};
+
+/** calls function(ACOVariantPolicies<variant>()), use decltype on the argument to get the policies */
+template<typename TFunction>
+void DispatchACOVariant(EACOVariant variant, TFunction&& function)
+{
+	switch (variant)
+	{
+	case EACOVariant::AntColonySystem: function(ACOVariantPolicies<EACOVariant::AntColonySystem>()); break;
+	case EACOVariant::MaxMin: function(ACOVariantPolicies<EACOVariant::MaxMin>()); break;
+	case EACOVariant::RankBased: function(ACOVariantPolicies<EACOVariant::RankBased>()); break;
+	default: function(ACOVariantPolicies<EACOVariant::AntSystem>()); break;
+	}
+}
@@ -0,0 +1,37 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ACO.h"
+#include "ACORingBuffer.h"
+
+ACORingBuffer::ACORingBuffer(int32 capacity) : m_head(0), m_tail(0)
+{
+	m_buffer.SetNumUninitialized(FMath::RoundUpToPowerOfTwo(FMath::Max(capacity, 1024)));
+	m_mask = m_buffer.Num() - 1;
+}
+
+bool ACORingBuffer::Push(const void* header, int32 headerSize, const void* payload, int32 payloadSize)
+{
+	const int64 head = m_head;
+	const int64 tail = m_tail;
+	//the consumer has released the bytes up to tail, they may be overwritten now
+	FPlatformMisc::MemoryBarrier();
+	if (head + headerSize + payloadSize - tail > m_buffer.Num())
+		return false;
+
+	copyIn(head, header, headerSize);
+	copyIn(head + headerSize, payload, payloadSize);
+
+	//the data has to be visible before the new head
+	FPlatformMisc::MemoryBarrier();
+	m_head = head + headerSize + payloadSize;
+	return true;
+}
+
+void ACORingBuffer::copyIn(int64 position, const void* data, int32 size)
+{
+	const int64 start = position & m_mask;
+	const int64 firstPart = FMath::Min<int64>(size, m_buffer.Num() - start);
+	FMemory::Memcpy(m_buffer.GetData() + start, data, firstPart);
+	if (firstPart < size)
+		FMemory::Memcpy(m_buffer.GetData(), static_cast<const uint8*>(data) + firstPart, size - firstPart);
+}
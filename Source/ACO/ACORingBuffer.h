@@ -0,0 +1,56 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+/**
+ * Lock free byte ring buffer for one producer and one consumer thread.
+ * The producer never waits, data which doesn't fit is rejected and has to be dropped by the caller.
+ */
+class ACO_API ACORingBuffer
+{
+public:
+	/** the capacity is rounded up to a power of two */
+	explicit ACORingBuffer(int32 capacity);
+
+	/** producer: writes both parts in one piece or nothing */
+	bool Push(const void* header, int32 headerSize, const void* payload, int32 payloadSize);
+	/** consumer: passes the readable bytes (at most two contiguous parts) to the function and releases them afterwards, returns the amount of bytes */
+	template<typename TFunction>
+	int64 Consume(TFunction function);
+
+	int32 GetCapacity() const { return m_buffer.Num(); }
+
+private:
+	void copyIn(int64 position, const void* data, int32 size);
+
+	TArray<uint8> m_buffer;
+	int64 m_mask;
+	/** written by the producer only */
+	volatile int64 m_head;
+	/** keeps head and tail on different cache lines, so producer and consumer don't invalidate each other */
+	uint8 m_padding[PLATFORM_CACHE_LINE_SIZE];
+	/** written by the consumer only */
+	volatile int64 m_tail;
+};
+
+template<typename TFunction>
+int64 ACORingBuffer::Consume(TFunction function)
+{
+	const int64 head = m_head;
+	//the bytes up to head are complete once head is visible
+	FPlatformMisc::MemoryBarrier();
+	const int64 tail = m_tail;
+	if (head == tail)
+		return 0;
+
+	const int64 start = tail & m_mask;
+	const int64 firstPart = FMath::Min(head - tail, m_buffer.Num() - start);
+	function(m_buffer.GetData() + start, firstPart);
+	if (firstPart < head - tail)
+		function(m_buffer.GetData(), head - tail - firstPart);
+
+	//the bytes have to be read before the producer may overwrite them
+	FPlatformMisc::MemoryBarrier();
+	m_tail = head;
+	return head - tail;
+}
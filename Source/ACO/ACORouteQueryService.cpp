@@ -0,0 +1,307 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ACO.h"
+#include "ACORouteQueryService.h"
+#include "Async/Async.h"
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+namespace
+{
+	/** per thread search state, sized to the grid once, the stamps mark the cells visited by the current search */
+	struct RouteSearchScratch
+	{
+		RouteSearchScratch() : Stamp(0) {}
+
+		void Begin(int32 cellAmount)
+		{
+			if (Stamps.Num() != cellAmount || Stamp == MAX_uint32)
+			{
+				Stamps.Init(0, cellAmount);
+				Costs.SetNumUninitialized(cellAmount);
+				CameFrom.SetNumUninitialized(cellAmount);
+				Stamp = 0;
+			}
+			++Stamp;
+			Open.clear();
+		}
+
+		bool IsVisited(int32 cell) const { return Stamps[cell] == Stamp; }
+
+		TArray<uint32> Stamps;
+		TArray<float> Costs;
+		TArray<int32> CameFrom;
+		uint32 Stamp;
+		/** binary heap of (cost, cell), kept as a vector so its memory is reused */
+		std::vector<std::pair<float, int32>> Open;
+	};
+
+	thread_local RouteSearchScratch t_routeSearchScratch;
+}
+
+ACORouteQueryService::ACORouteQueryService(const ACOGrid& grid, float referenceLevel) : m_grid(grid), m_epochInterval(0), m_epochThreshold(0.05f), m_maxCachedRoutes(65536),
+	m_nextHopTable(grid, referenceLevel), m_isUpdatingNextHops(true), m_isBatchRunning(false)
+{
+}
+
+ACORouteQueryService::~ACORouteQueryService()
+{
+	WaitForPendingQueries();
+}
+
+void ACORouteQueryService::ParseCommandLine(const TCHAR* stream)
+{
+	FParse::Value(stream, TEXT("ACORouteEpochInterval="), m_epochInterval);
+	FParse::Value(stream, TEXT("ACORouteEpochThreshold="), m_epochThreshold);
+	m_isUpdatingNextHops = !FParse::Param(stream, TEXT("ACONoNextHops"));
+	float tolerance = 0.05f;
+	if (FParse::Value(stream, TEXT("ACONextHopTolerance="), tolerance))
+		m_nextHopTable.SetTolerance(tolerance);
+}
+
+void ACORouteQueryService::OnIterationFinished(const ACOPheromoneField& pheromoneField, int32 iteration)
+{
+	if (m_epochInterval <= 0 || iteration % m_epochInterval != 0)
+		return;
+
+	const TArray<float>& pheromoneLevels = pheromoneField.GetPheromoneLevels(m_decodedLevels);
+	const ACORouteSnapshotPtr current = GetSnapshot();
+	if (current.IsValid() && current->PheromoneLevels.Num() == pheromoneLevels.Num())
+	{
+		//relative L1 change since the current epoch, small changes keep the cached routes
+		double change = 0.0;
+		double total = 0.0;
+		for (int32 i = 0; i < pheromoneLevels.Num(); ++i)
+		{
+			change += FMath::Abs(pheromoneLevels[i] - current->PheromoneLevels[i]);
+			total += current->PheromoneLevels[i];
+		}
+		if (total > 0.0 && change < m_epochThreshold * total)
+			return;
+	}
+
+	ACORouteSnapshot* snapshot = new ACORouteSnapshot();
+	snapshot->Epoch = current.IsValid() ? current->Epoch + 1 : 1;
+	snapshot->Iteration = iteration;
+	snapshot->Cells = pheromoneField.Num();
+	snapshot->Channels = pheromoneField.GetChannelAmount();
+	snapshot->PheromoneLevels = pheromoneLevels;
+	for (int32 channel = 0; channel < snapshot->Channels; ++channel)
+		snapshot->MaxPheromoneLevels.Add(pheromoneField.GetMaxPheromoneLevel(channel));
+
+	//the trees are repaired where the levels changed since the last epoch, the snapshot gets a copy
+	if (m_isUpdatingNextHops)
+	{
+		m_nextHopTable.Update(pheromoneLevels, snapshot->Channels);
+		const int32 trees = snapshot->Channels * static_cast<int32>(EACORouteTarget::Num);
+		snapshot->NextHops.SetNumUninitialized(trees * snapshot->Cells);
+		for (int32 tree = 0; tree < trees; ++tree)
+			FMemory::Memcpy(snapshot->NextHops.GetData() + tree * snapshot->Cells, m_nextHopTable.GetNextHops(tree).GetData(), snapshot->Cells * sizeof(int32));
+	}
+
+	FScopeLock lock(&m_snapshotSection);
+	m_snapshot = MakeShareable(snapshot);
+	m_cache.Reset();
+}
+
+uint32 ACORouteQueryService::GetEpoch() const
+{
+	const ACORouteSnapshotPtr snapshot = GetSnapshot();
+	return snapshot.IsValid() ? snapshot->Epoch : 0;
+}
+
+int32 ACORouteQueryService::GetNextHop(int32 cell, int32 channel, EACORouteTarget target) const
+{
+	const ACORouteSnapshotPtr snapshot = GetSnapshot();
+	return snapshot.IsValid() ? snapshot->GetNextHop(cell, channel, target) : INDEX_NONE;
+}
+
+ACORouteResult ACORouteQueryService::FindRoute(const ACORouteQuery& query)
+{
+	const ACORouteSnapshotPtr snapshot = GetSnapshot();
+	return snapshot.IsValid() ? findRoute(*snapshot, query) : ACORouteResult();
+}
+
+void ACORouteQueryService::QueryRoutes(const TArray<ACORouteQuery>& queries, TArray<ACORouteResult>& results)
+{
+	results.Reset();
+	results.SetNum(queries.Num());
+	const ACORouteSnapshotPtr snapshot = GetSnapshot();
+	if (!snapshot.IsValid())
+		return;
+
+	//agents often ask for the same routes, every distinct query is searched once
+	TMap<ACORouteQuery, int32> distinctIndices;
+	TArray<int32> distinctQueries;
+	TArray<int32> resultIndices;
+	resultIndices.SetNumUninitialized(queries.Num());
+	for (int32 i = 0; i < queries.Num(); ++i)
+	{
+		int32& distinctIndex = distinctIndices.FindOrAdd(queries[i]);
+		if (distinctIndex == 0)
+		{
+			distinctQueries.Add(i);
+			distinctIndex = distinctQueries.Num();
+		}
+		resultIndices[i] = distinctIndex - 1;
+	}
+
+	ParallelFor(distinctQueries.Num(), [&](int32 i)
+	{
+		results[distinctQueries[i]] = findRoute(*snapshot, queries[distinctQueries[i]]);
+	});
+	for (int32 i = 0; i < queries.Num(); ++i)
+	{
+		if (distinctQueries[resultIndices[i]] != i)
+			results[i] = results[distinctQueries[resultIndices[i]]];
+	}
+}
+
+TFuture<ACORouteResult> ACORouteQueryService::QueryRoute(const ACORouteQuery& query)
+{
+	PendingQuery pendingQuery;
+	pendingQuery.Query = query;
+	pendingQuery.Promise.Reset(new TPromise<ACORouteResult>());
+	TFuture<ACORouteResult> future = pendingQuery.Promise->GetFuture();
+
+	bool isStartingBatch = false;
+	{
+		FScopeLock lock(&m_pendingSection);
+		m_pendingQueries.Add(MoveTemp(pendingQuery));
+		isStartingBatch = !m_isBatchRunning;
+		m_isBatchRunning = true;
+	}
+
+	//queries which arrive while a batch runs are answered by the next batch of the same task
+	if (isStartingBatch)
+	{
+		m_runningBatches.Increment();
+		Async<void>(EAsyncExecution::ThreadPool, [this]()
+		{
+			processPendingQueries();
+			m_runningBatches.Decrement();
+		});
+	}
+	return future;
+}
+
+void ACORouteQueryService::WaitForPendingQueries()
+{
+	while (m_runningBatches.GetValue() > 0)
+		FPlatformProcess::Sleep(0.001f);
+}
+
+void ACORouteQueryService::processPendingQueries()
+{
+	while (true)
+	{
+		TArray<PendingQuery> batch;
+		{
+			FScopeLock lock(&m_pendingSection);
+			if (m_pendingQueries.Num() == 0)
+			{
+				m_isBatchRunning = false;
+				return;
+			}
+			batch = MoveTemp(m_pendingQueries);
+			m_pendingQueries.Reset();
+		}
+
+		TArray<ACORouteQuery> queries;
+		queries.Reserve(batch.Num());
+		for (const PendingQuery& pendingQuery : batch)
+			queries.Add(pendingQuery.Query);
+		TArray<ACORouteResult> results;
+		QueryRoutes(queries, results);
+		for (int32 i = 0; i < batch.Num(); ++i)
+			batch[i].Promise->SetValue(MoveTemp(results[i]));
+	}
+}
+
+ACORouteSnapshotPtr ACORouteQueryService::GetSnapshot() const
+{
+	FScopeLock lock(&m_snapshotSection);
+	return m_snapshot;
+}
+
+ACORouteResult ACORouteQueryService::findRoute(const ACORouteSnapshot& snapshot, const ACORouteQuery& query)
+{
+	{
+		FScopeLock lock(&m_snapshotSection);
+		const ACORouteResult* cachedResult = m_cache.Find(query);
+		if (cachedResult && cachedResult->Epoch == snapshot.Epoch)
+		{
+			m_cacheHits.Increment();
+			return *cachedResult;
+		}
+	}
+	m_cacheMisses.Increment();
+
+	ACORouteResult result;
+	result.Epoch = snapshot.Epoch;
+	search(snapshot, query, result);
+
+	//a search of an older epoch must not replace the results of the new one
+	FScopeLock lock(&m_snapshotSection);
+	if (m_snapshot.IsValid() && m_snapshot->Epoch == snapshot.Epoch)
+	{
+		if (m_cache.Num() >= m_maxCachedRoutes)
+			m_cache.Reset();
+		m_cache.Add(query, result);
+	}
+	return result;
+}
+
+void ACORouteQueryService::search(const ACORouteSnapshot& snapshot, const ACORouteQuery& query, ACORouteResult& result) const
+{
+	const int32 start = query.Start;
+	const int32 goal = query.Goal;
+	const int32 channel = query.Channel;
+	if (start < 0 || start >= m_grid.Num() || goal < 0 || goal >= m_grid.Num() || channel < 0 || channel >= snapshot.Channels)
+		return;
+
+	RouteSearchScratch& scratch = t_routeSearchScratch;
+	scratch.Begin(m_grid.Num());
+	const float maxPheromoneLevel = snapshot.MaxPheromoneLevels[channel];
+	const auto compare = std::greater<std::pair<float, int32>>();
+
+	//Dijkstra with the costs of Pathfinding::AStarSearch, stops at the goal
+	scratch.Stamps[start] = scratch.Stamp;
+	scratch.Costs[start] = 0.f;
+	scratch.CameFrom[start] = start;
+	scratch.Open.emplace_back(0.f, start);
+	while (scratch.Open.size() > 0)
+	{
+		std::pop_heap(scratch.Open.begin(), scratch.Open.end(), compare);
+		const float cost = scratch.Open.back().first;
+		const int32 cell = scratch.Open.back().second;
+		scratch.Open.pop_back();
+		//outdated entry, the cell was lowered again after it was queued
+		if (cost > scratch.Costs[cell])
+			continue;
+		if (cell == goal)
+			break;
+
+		for (const int32* neighbour = m_grid.GetNeighboursBegin(cell); neighbour != m_grid.GetNeighboursEnd(cell); ++neighbour)
+		{
+			const float newCost = cost + FMath::Max(maxPheromoneLevel - snapshot.GetPheromoneLevel(*neighbour, channel), 0.f);
+			if (!scratch.IsVisited(*neighbour) || newCost < scratch.Costs[*neighbour])
+			{
+				scratch.Stamps[*neighbour] = scratch.Stamp;
+				scratch.Costs[*neighbour] = newCost;
+				scratch.CameFrom[*neighbour] = cell;
+				scratch.Open.emplace_back(newCost, *neighbour);
+				std::push_heap(scratch.Open.begin(), scratch.Open.end(), compare);
+			}
+		}
+	}
+
+	if (!scratch.IsVisited(goal))
+		return;
+	result.Cost = scratch.Costs[goal];
+	for (int32 cell = goal; cell != start; cell = scratch.CameFrom[cell])
+		result.Route.Add(cell);
+	result.Route.Add(start);
+	std::reverse(result.Route.GetData(), result.Route.GetData() + result.Route.Num());
+}
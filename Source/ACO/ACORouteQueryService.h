@@ -0,0 +1,137 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "ACOGrid.h"
+#include "ACOPheromoneField.h"
+#include "ACONextHopTable.h"
+
+/** best route from Start to Goal on the pheromones of one channel */
+struct ACO_API ACORouteQuery
+{
+	ACORouteQuery() : Start(INDEX_NONE), Goal(INDEX_NONE), Channel(0) {}
+	ACORouteQuery(int32 start, int32 goal, int32 channel) : Start(start), Goal(goal), Channel(channel) {}
+
+	bool operator==(const ACORouteQuery& other) const { return Start == other.Start && Goal == other.Goal && Channel == other.Channel; }
+
+	int32 Start;
+	int32 Goal;
+	int32 Channel;
+};
+
+FORCEINLINE uint32 GetTypeHash(const ACORouteQuery& query)
+{
+	return HashCombine(HashCombine(GetTypeHash(query.Start), GetTypeHash(query.Goal)), GetTypeHash(query.Channel));
+}
+
+struct ACO_API ACORouteResult
+{
+	ACORouteResult() : Cost(MAX_FLT), Epoch(0) {}
+
+	bool IsValid() const { return Route.Num() > 0; }
+
+	/** cells from start to goal, empty if the goal can't be reached or there is no epoch yet */
+	TArray<int32> Route;
+	/** same costs as Pathfinding::AStarSearch, max level of the channel - level of the entered cell */
+	float Cost;
+	/** pheromone epoch the route was found on */
+	uint32 Epoch;
+};
+
+/** copy of the pheromone field the queries of one epoch run on */
+struct ACO_API ACORouteSnapshot
+{
+	float GetPheromoneLevel(int32 cell, int32 channel) const { return PheromoneLevels[cell * Channels + channel]; }
+	/** O(1) next neighbour towards the target, INDEX_NONE at the target, where it can't be reached or without next hops */
+	int32 GetNextHop(int32 cell, int32 channel, EACORouteTarget target) const
+	{
+		return NextHops.Num() > 0 ? NextHops[ACONextHopTable::GetTreeIndex(channel, target) * Cells + cell] : INDEX_NONE;
+	}
+
+	uint32 Epoch;
+	int32 Iteration;
+	int32 Cells;
+	int32 Channels;
+	TArray<float> PheromoneLevels;
+	TArray<float> MaxPheromoneLevels;
+	/** ACONextHopTable of the epoch, one block of cells per tree */
+	TArray<int32> NextHops;
+};
+
+typedef TSharedPtr<const ACORouteSnapshot, ESPMode::ThreadSafe> ACORouteSnapshotPtr;
+
+/**
+ * Thread safe best route queries for other systems of the game.
+ * The workers publish a copy of the pheromone field every EpochInterval iterations, but it only becomes a new epoch if the levels
+ * changed by at least EpochThreshold (sum of absolute changes / sum of levels) since the current one. All queries run on the snapshot
+ * of the current epoch, so their results are consistent and can be cached until the next epoch.
+ * QueryRoute collects the queries of all callers and answers them in batches on the thread pool.
+ * Agents which only follow the trails to the nearest food source or home use the next hops of the epoch instead, see ACONextHopTable.
+ *
+ * The service is disabled by default, -ACORouteEpochInterval=10 enables it.
+ * -ACORouteEpochInterval=0 -ACORouteEpochThreshold=0.05 -ACONextHopTolerance=0.05 -ACONoNextHops
+ */
+class ACO_API ACORouteQueryService
+{
+public:
+	/** the grid has to outlive the service, a cell with the reference level costs half a step for the next hops */
+	ACORouteQueryService(const ACOGrid& grid, float referenceLevel);
+	~ACORouteQueryService();
+
+	void ParseCommandLine(const TCHAR* stream);
+	bool IsEnabled() const { return m_epochInterval > 0; }
+
+	/** has to be called by one thread at an iteration boundary, may start a new epoch */
+	void OnIterationFinished(const ACOPheromoneField& pheromoneField, int32 iteration);
+	uint32 GetEpoch() const;
+	/** the current epoch, nullptr before the first one, agents should keep it for a frame instead of asking for every lookup */
+	ACORouteSnapshotPtr GetSnapshot() const;
+	int32 GetNextHop(int32 cell, int32 channel, EACORouteTarget target) const;
+
+	/** answers the query on the calling thread */
+	ACORouteResult FindRoute(const ACORouteQuery& query);
+	/** answers all queries in parallel on the same epoch, results gets one entry per query */
+	void QueryRoutes(const TArray<ACORouteQuery>& queries, TArray<ACORouteResult>& results);
+	/** answers the query with the next batch on the thread pool */
+	TFuture<ACORouteResult> QueryRoute(const ACORouteQuery& query);
+	void WaitForPendingQueries();
+
+	int32 GetCacheHits() const { return m_cacheHits.GetValue(); }
+	int32 GetCacheMisses() const { return m_cacheMisses.GetValue(); }
+
+private:
+	struct PendingQuery
+	{
+		ACORouteQuery Query;
+		TUniquePtr<TPromise<ACORouteResult>> Promise;
+	};
+
+	/** cached result of the snapshot's epoch or a new search */
+	ACORouteResult findRoute(const ACORouteSnapshot& snapshot, const ACORouteQuery& query);
+	void search(const ACORouteSnapshot& snapshot, const ACORouteQuery& query, ACORouteResult& result) const;
+	/** runs until no queries are pending */
+	void processPendingQueries();
+
+	const ACOGrid& m_grid;
+	int32 m_epochInterval;
+	float m_epochThreshold;
+	/** the cache is reset when it gets larger */
+	int32 m_maxCachedRoutes;
+	/** only touched by the thread which finishes the iterations */
+	ACONextHopTable m_nextHopTable;
+	bool m_isUpdatingNextHops;
+	/** levels of a compact pheromone storage */
+	TArray<float> m_decodedLevels;
+
+	mutable FCriticalSection m_snapshotSection;
+	ACORouteSnapshotPtr m_snapshot;
+	/** results of the current epoch */
+	TMap<ACORouteQuery, ACORouteResult> m_cache;
+	FThreadSafeCounter m_cacheHits;
+	FThreadSafeCounter m_cacheMisses;
+
+	FCriticalSection m_pendingSection;
+	TArray<PendingQuery> m_pendingQueries;
+	bool m_isBatchRunning;
+	FThreadSafeCounter m_runningBatches;
+};
@@ -0,0 +1,121 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ACO.h"
+#include "ACOSharedMemoryExport.h"
+
+ACOSharedMemoryExport::ACOSharedMemoryExport() : m_region(nullptr), m_interval(1)
+{
+}
+
+ACOSharedMemoryExport::~ACOSharedMemoryExport()
+{
+	Close();
+}
+
+bool ACOSharedMemoryExport::OpenFromCommandLine(const TCHAR* stream, const ACOGrid& grid, int32 channels, int32 colonies)
+{
+	FString name;
+	if (!FParse::Value(stream, TEXT("ACOSharedMemory="), name))
+		return false;
+
+	int32 interval = 1;
+	FParse::Value(stream, TEXT("ACOSharedMemoryInterval="), interval);
+	return Open(name, grid, channels, colonies, interval);
+}
+
+bool ACOSharedMemoryExport::Open(const FString& name, const ACOGrid& grid, int32 channels, int32 colonies, int32 interval)
+{
+	Close();
+	const int32 cells = grid.Num();
+	const uint64 coordinatesOffset = Align(sizeof(ACOSharedMemoryHeader), 64);
+	const uint64 colonySize = sizeof(ACOSharedMemoryColony) + static_cast<uint64>(cells) * sizeof(int32);
+	const uint64 slotSize = Align(sizeof(ACOSharedMemorySlot) + static_cast<uint64>(cells) * channels * sizeof(float) + colonies * colonySize, 64);
+	const uint64 slotOffset = Align(coordinatesOffset + static_cast<uint64>(cells) * sizeof(ACOSharedMemoryCoordinate), 64);
+	const uint64 regionSize = slotOffset + 2 * slotSize;
+
+	m_region = FPlatformMemory::MapNamedSharedMemoryRegion(name, true, FPlatformMemory::ESharedMemoryAccess::Read | FPlatformMemory::ESharedMemoryAccess::Write, regionSize);
+	if (!m_region)
+	{
+		UE_LOG(LogACO, Error, TEXT("Couldn't create the shared memory region %s with %llu bytes!"), *name, regionSize);
+		return false;
+	}
+	m_interval = FMath::Max(interval, 1);
+
+	//readers check the magic last, so it is written after everything else
+	FMemory::Memzero(getBase(), regionSize);
+	ACOSharedMemoryHeader* header = getHeader();
+	header->Version = ACOSharedMemoryHeader::VersionValue;
+	header->Cells = cells;
+	header->Channels = channels;
+	header->Colonies = colonies;
+	header->MaxRouteLength = cells;
+	header->SizeX = grid.Size.X;
+	header->SizeY = grid.Size.Y;
+	header->CoordinatesOffset = coordinatesOffset;
+	header->SlotOffsets[0] = slotOffset;
+	header->SlotOffsets[1] = slotOffset + slotSize;
+	header->SlotSize = slotSize;
+	header->PublishedSlot = -1;
+	header->IsClosed = 0;
+
+	ACOSharedMemoryCoordinate* coordinates = reinterpret_cast<ACOSharedMemoryCoordinate*>(getBase() + coordinatesOffset);
+	for (int32 cell = 0; cell < cells; ++cell)
+	{
+		coordinates[cell].X = grid.Coordinates[cell].X;
+		coordinates[cell].Y = grid.Coordinates[cell].Y;
+	}
+
+	FPlatformMisc::MemoryBarrier();
+	header->Magic = ACOSharedMemoryHeader::MagicValue;
+	UE_LOG(LogACO, Log, TEXT("Publishing the pheromone field every %d iterations to shared memory %s (%llu MB)"), m_interval, *name, regionSize / (1024 * 1024));
+	return true;
+}
+
+void ACOSharedMemoryExport::Close()
+{
+	if (!m_region)
+		return;
+
+	getHeader()->IsClosed = 1;
+	FPlatformMisc::MemoryBarrier();
+	FPlatformMemory::UnmapNamedSharedMemoryRegion(m_region);
+	m_region = nullptr;
+}
+
+void ACOSharedMemoryExport::Publish(int32 iteration, const TArray<ACOColony*>& colonies, const ACOPheromoneField& pheromoneField, const TArray<ACOConvergenceTracker>& trackers)
+{
+	ACOSharedMemoryHeader* header = getHeader();
+	if (iteration % m_interval != 0 || pheromoneField.Num() != header->Cells || pheromoneField.GetChannelAmount() != header->Channels || colonies.Num() != header->Colonies)
+		return;
+
+	//the slot which isn't published, readers of the published slot stay undisturbed
+	const int32 slotIndex = header->PublishedSlot == 0 ? 1 : 0;
+	uint8* slotData = getBase() + header->SlotOffsets[slotIndex];
+	ACOSharedMemorySlot* slot = reinterpret_cast<ACOSharedMemorySlot*>(slotData);
+	const uint32 sequence = slot->Sequence;
+	slot->Sequence = sequence + 1;
+	FPlatformMisc::MemoryBarrier();
+
+	slot->Iteration = iteration;
+	uint8* data = slotData + sizeof(ACOSharedMemorySlot);
+	pheromoneField.CopyPheromoneLevels(reinterpret_cast<float*>(data));
+	data += pheromoneField.Num() * pheromoneField.GetChannelAmount() * sizeof(float);
+
+	for (int32 i = 0; i < colonies.Num(); ++i)
+	{
+		ACOSharedMemoryColony colony;
+		colony.Anthill = colonies[i]->GetAnthill();
+		colony.RouteLength = trackers.IsValidIndex(i) ? FMath::Min(trackers[i].GetBestRoute().Num(), header->MaxRouteLength) : 0;
+		colony.BestTripCost = colonies[i]->GetBestTripCost();
+		colony.IterationBestTripCost = colonies[i]->GetIterationBestTripCost();
+		FMemory::Memcpy(data, &colony, sizeof(colony));
+		if (colony.RouteLength > 0)
+			FMemory::Memcpy(data + sizeof(colony), trackers[i].GetBestRoute().GetData(), colony.RouteLength * sizeof(int32));
+		data += sizeof(colony) + header->MaxRouteLength * sizeof(int32);
+	}
+
+	FPlatformMisc::MemoryBarrier();
+	slot->Sequence = sequence + 2;
+	FPlatformMisc::MemoryBarrier();
+	header->PublishedSlot = slotIndex;
+}
@@ -0,0 +1,36 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "ACOConvergence.h"
+#include "ACOSharedMemoryLayout.h"
+
+/**
+ * Publishes the pheromone field and the best routes of all colonies into a named shared memory region (see ACOSharedMemoryLayout.h),
+ * so external viewers can read them without slowing down the workers. Tools/ACOSharedMemoryReader is a minimal reader.
+ *
+ * -ACOSharedMemory=<name> -ACOSharedMemoryInterval=1
+ */
+class ACO_API ACOSharedMemoryExport
+{
+public:
+	ACOSharedMemoryExport();
+	~ACOSharedMemoryExport();
+
+	/** creates the region of -ACOSharedMemory, returns false if there is no -ACOSharedMemory or it couldn't be created */
+	bool OpenFromCommandLine(const TCHAR* stream, const ACOGrid& grid, int32 channels, int32 colonies);
+	bool Open(const FString& name, const ACOGrid& grid, int32 channels, int32 colonies, int32 interval);
+	/** marks the region as closed and unmaps it */
+	void Close();
+	bool IsOpen() const { return m_region != nullptr; }
+
+	/** has to be called by one thread at an iteration boundary, publishes every interval iterations, trackers has one entry per colony */
+	void Publish(int32 iteration, const TArray<ACOColony*>& colonies, const ACOPheromoneField& pheromoneField, const TArray<ACOConvergenceTracker>& trackers);
+
+private:
+	uint8* getBase() const { return static_cast<uint8*>(m_region->GetAddress()); }
+	ACOSharedMemoryHeader* getHeader() const { return reinterpret_cast<ACOSharedMemoryHeader*>(getBase()); }
+
+	FPlatformMemory::FSharedMemoryRegion* m_region;
+	int32 m_interval;
+};
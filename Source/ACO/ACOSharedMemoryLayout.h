@@ -0,0 +1,65 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+//no engine types, this header is also included by Tools/ACOSharedMemoryReader
+#include <stdint.h>
+
+/**
+ * Named shared memory region of ACOSharedMemoryExport, native byte order:
+ *
+ * ACOSharedMemoryHeader
+ * Cells * ACOSharedMemoryCoordinate                        at CoordinatesOffset, written once
+ * 2 slots                                                  at SlotOffsets[0] and SlotOffsets[1], SlotSize bytes each
+ *   ACOSharedMemorySlot
+ *   Cells * Channels pheromone levels (float, channels of a cell next to each other)
+ *   Colonies * (ACOSharedMemoryColony, then MaxRouteLength route cells (int32))
+ *
+ * The writer fills the slot which isn't published and publishes it afterwards, so a reader copying the published slot
+ * is only disturbed if the writer wraps around twice. Every slot is a seqlock: a reader reads Sequence, copies the slot and
+ * reads Sequence again, the copy is consistent if both are equal and even. Readers never block the writer.
+ */
+struct ACOSharedMemoryHeader
+{
+	static const uint32_t MagicValue = 0x56434F41; //"ACOV"
+	static const uint32_t VersionValue = 1;
+
+	uint32_t Magic;
+	uint32_t Version;
+	int32_t Cells;
+	int32_t Channels;
+	int32_t Colonies;
+	int32_t MaxRouteLength;
+	/** columns and rows spanned by the coordinates */
+	int32_t SizeX;
+	int32_t SizeY;
+	uint64_t CoordinatesOffset;
+	uint64_t SlotOffsets[2];
+	uint64_t SlotSize;
+	/** index of the newest complete slot, -1 until the first iteration is published */
+	volatile int32_t PublishedSlot;
+	/** set when the simulation stops, the region may be removed afterwards */
+	volatile int32_t IsClosed;
+};
+
+struct ACOSharedMemoryCoordinate
+{
+	int32_t X;
+	int32_t Y;
+};
+
+struct ACOSharedMemorySlot
+{
+	/** odd while the writer fills the slot */
+	volatile uint32_t Sequence;
+	int32_t Iteration;
+};
+
+struct ACOSharedMemoryColony
+{
+	int32_t Anthill;
+	/** greedy route from the anthill along the highest pheromone levels, see ACOConvergenceTracker */
+	int32_t RouteLength;
+	float BestTripCost;
+	float IterationBestTripCost;
+};
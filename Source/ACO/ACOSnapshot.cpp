@@ -0,0 +1,318 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ACO.h"
+#include "ACOSnapshot.h"
+#include "ACOMappedFile.h"
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
+
+static_assert(sizeof(ACOSnapshotHeader) % 4 == 0 && sizeof(ACOSnapshotColony) % 4 == 0 && sizeof(ACOSnapshotAnt) == 16, "snapshot records have to stay 4 byte aligned");
+
+FThreadSafeCounter ACOSnapshot::s_pendingWrites;
+
+namespace
+{
+	/** bounds checked cursor over the mapped file, the values are read in place */
+	struct SnapshotReader
+	{
+		const uint8* Data;
+		int64 Size;
+		int64 Offset;
+
+		template<typename T>
+		const T* Read(int64 amount)
+		{
+			const int64 bytes = amount * static_cast<int64>(sizeof(T));
+			if (amount < 0 || Offset + bytes > Size)
+				return nullptr;
+			const T* values = reinterpret_cast<const T*>(Data + Offset);
+			Offset += bytes;
+			return values;
+		}
+	};
+}
+
+void ACOSnapshot::copy(int64 offset, const void* values, int64 bytes)
+{
+	const uint8* source = static_cast<const uint8*>(values);
+	while (bytes > 0)
+	{
+		const int64 blockOffset = offset % BlockSize;
+		const int64 amount = FMath::Min(bytes, BlockSize - blockOffset);
+		FMemory::Memcpy(m_blocks[offset / BlockSize].GetData() + blockOffset, source, amount);
+		source += amount;
+		offset += amount;
+		bytes -= amount;
+	}
+}
+
+void ACOSnapshot::Capture(const ACOPheromoneField& pheromoneField, const TArray<ACOColony*>& colonies, int32 iteration)
+{
+	struct FieldPiece
+	{
+		const float* Values;
+		int64 Amount;
+		int64 Offset;
+	};
+	struct AntRange
+	{
+		const ACOColony* Colony;
+		int32 FirstAnt;
+		int32 LastAnt;
+		int64 AntOffset;
+		int64 PathOffset;
+	};
+	static const int32 FloatsPerPiece = static_cast<int32>(BlockSize / sizeof(float));
+	static const int32 AntsPerRange = 4096;
+
+	//a compact storage is written as floats, so a snapshot can be restored into any storage
+	TArray<float> decodedLevels;
+	const TArray<float>& levels = pheromoneField.GetPheromoneLevels(decodedLevels);
+	TArray<float> addedPheromones;
+	addedPheromones.SetNumUninitialized(levels.Num());
+	pheromoneField.CopyAddedPheromones(addedPheromones.GetData());
+
+	//the offsets of all records first, then every task copies to its own part of the blocks
+	TArray<FieldPiece> fieldPieces;
+	int64 offset = sizeof(ACOSnapshotHeader);
+	const TArray<float>* fieldValues[] = { &levels, &addedPheromones, &pheromoneField.m_maxPheromoneLevels };
+	for (const TArray<float>* values : fieldValues)
+	{
+		for (int32 first = 0; first < values->Num(); first += FloatsPerPiece)
+		{
+			const FieldPiece piece = { values->GetData() + first, FMath::Min(FloatsPerPiece, values->Num() - first), offset };
+			fieldPieces.Add(piece);
+			offset += piece.Amount * sizeof(float);
+		}
+	}
+
+	TArray<int64> colonyOffsets;
+	TArray<AntRange> antRanges;
+	for (const ACOColony* colony : colonies)
+	{
+		colonyOffsets.Add(offset);
+		offset += sizeof(ACOSnapshotColony) + colony->m_tripRanking.PreviousIterationTripCosts.Num() * sizeof(float);
+		const int64 antOffset = offset;
+		int64 pathOffset = antOffset + colony->m_ants.Num() * static_cast<int64>(sizeof(ACOSnapshotAnt));
+		for (int32 first = 0; first < colony->m_ants.Num(); first += AntsPerRange)
+		{
+			const AntRange range = { colony, first, FMath::Min(first + AntsPerRange, colony->m_ants.Num()), antOffset + first * static_cast<int64>(sizeof(ACOSnapshotAnt)), pathOffset };
+			antRanges.Add(range);
+			for (int32 i = range.FirstAnt; i < range.LastAnt; ++i)
+				pathOffset += colony->m_ants[i].visitedPath.Num() * static_cast<int64>(sizeof(int32));
+		}
+		offset = pathOffset;
+	}
+
+	m_size = offset;
+	m_blocks.Reset();
+	m_blocks.SetNum(static_cast<int32>((m_size + BlockSize - 1) / BlockSize));
+	for (int32 i = 0; i < m_blocks.Num(); ++i)
+		m_blocks[i].SetNumUninitialized(static_cast<int32>(FMath::Min(static_cast<int64>(BlockSize), m_size - i * BlockSize)));
+
+	ACOSnapshotHeader header;
+	header.Magic = Magic;
+	header.Version = Version;
+	header.Size = m_size;
+	header.Iteration = iteration;
+	header.Cells = pheromoneField.Num();
+	header.Channels = pheromoneField.m_channels;
+	header.Colonies = colonies.Num();
+	copy(0, &header, sizeof(header));
+
+	for (int32 i = 0; i < colonies.Num(); ++i)
+	{
+		const ACOColony* colony = colonies[i];
+		ACOSnapshotColony colonyRecord;
+		colonyRecord.Anthill = colony->m_anthill;
+		colonyRecord.Channel = colony->m_channel;
+		colonyRecord.IterationCounter = colony->m_iterationCounter;
+		colonyRecord.RandomSeed = colony->m_randomStream.GetCurrentSeed();
+		colonyRecord.Ants = colony->m_ants.Num();
+		colonyRecord.BestTripCost = colony->m_tripRanking.BestTripCost;
+		colonyRecord.RankedTrips = colony->m_tripRanking.PreviousIterationTripCosts.Num();
+		copy(colonyOffsets[i], &colonyRecord, sizeof(colonyRecord));
+		copy(colonyOffsets[i] + sizeof(colonyRecord), colony->m_tripRanking.PreviousIterationTripCosts.GetData(), colonyRecord.RankedTrips * sizeof(float));
+	}
+
+	ParallelFor(fieldPieces.Num(), [this, &fieldPieces](int32 i)
+	{
+		copy(fieldPieces[i].Offset, fieldPieces[i].Values, fieldPieces[i].Amount * sizeof(float));
+	});
+	ParallelFor(antRanges.Num(), [this, &antRanges](int32 rangeIndex)
+	{
+		const AntRange& range = antRanges[rangeIndex];
+		TArray<ACOSnapshotAnt> antRecords;
+		antRecords.SetNumUninitialized(range.LastAnt - range.FirstAnt);
+		int64 pathOffset = range.PathOffset;
+		for (int32 i = range.FirstAnt; i < range.LastAnt; ++i)
+		{
+			const ACOAnt& ant = range.Colony->m_ants[i];
+			ACOSnapshotAnt& antRecord = antRecords[i - range.FirstAnt];
+			antRecord.Position = ant.Position;
+			antRecord.PathLength = ant.visitedPath.Num();
+			antRecord.PheromonesPerNode = ant.pheromonesPerNode;
+			antRecord.isCarryingFood = ant.isCarryingFood;
+			antRecord.isSearchingFood = ant.isSearchingFood;
+			antRecord.Padding = 0;
+			copy(pathOffset, ant.visitedPath.GetData(), ant.visitedPath.Num() * static_cast<int64>(sizeof(int32)));
+			pathOffset += ant.visitedPath.Num() * static_cast<int64>(sizeof(int32));
+		}
+		copy(range.AntOffset, antRecords.GetData(), antRecords.Num() * static_cast<int64>(sizeof(ACOSnapshotAnt)));
+	});
+}
+
+void ACOSnapshot::WriteAsync(const FString& filename)
+{
+	TArray<TArray<uint8>>* blocks = new TArray<TArray<uint8>>(MoveTemp(m_blocks));
+	m_size = 0;
+	s_pendingWrites.Increment();
+	Async<void>(EAsyncExecution::ThreadPool, [blocks, filename]()
+	{
+		writeFile(*blocks, filename);
+		delete blocks;
+		s_pendingWrites.Decrement();
+	});
+}
+
+bool ACOSnapshot::Write(const FString& filename) const
+{
+	return writeFile(m_blocks, filename);
+}
+
+void ACOSnapshot::WaitForPendingWrites()
+{
+	while (IsWriting())
+		FPlatformProcess::Sleep(0.01f);
+}
+
+bool ACOSnapshot::writeFile(const TArray<TArray<uint8>>& blocks, const FString& filename)
+{
+	const FString temporaryFilename = filename + TEXT(".tmp");
+	const double startTime = FPlatformTime::Seconds();
+	FArchive* file = IFileManager::Get().CreateFileWriter(*temporaryFilename);
+	int64 size = 0;
+	bool isWritten = file != nullptr;
+	for (int32 i = 0; isWritten && i < blocks.Num(); ++i)
+	{
+		file->Serialize(const_cast<uint8*>(blocks[i].GetData()), blocks[i].Num());
+		size += blocks[i].Num();
+		isWritten = !file->IsError();
+	}
+	if (file)
+		isWritten &= file->Close();
+	delete file;
+	if (!isWritten || !IFileManager::Get().Move(*filename, *temporaryFilename))
+	{
+		UE_LOG(LogACO, Error, TEXT("Couldn't write ACO snapshot %s!"), *filename);
+		return false;
+	}
+	UE_LOG(LogACO, Log, TEXT("ACO snapshot with %.1f MB written to %s after %.2fs"), size / (1024.0 * 1024.0), *filename, FPlatformTime::Seconds() - startTime);
+	return true;
+}
+
+bool ACOSnapshot::Restore(const FString& filename, ACOPheromoneField& pheromoneField, const TArray<ACOColony*>& colonies, int32& iteration)
+{
+	ACOMappedFile file;
+	if (!file.Open(filename))
+		return false;
+
+	SnapshotReader reader = { file.GetData(), file.GetSize(), 0 };
+	const ACOSnapshotHeader* header = reader.Read<ACOSnapshotHeader>(1);
+	if (!header || header->Magic != Magic || header->Version != Version)
+	{
+		UE_LOG(LogACO, Error, TEXT("%s is no ACO snapshot of version %u!"), *filename, Version);
+		return false;
+	}
+	if (header->Size != reader.Size)
+	{
+		UE_LOG(LogACO, Error, TEXT("ACO snapshot %s has %lld bytes instead of %lld, it is truncated!"), *filename, reader.Size, header->Size);
+		return false;
+	}
+	if (header->Cells != pheromoneField.Num() || header->Channels != pheromoneField.m_channels || header->Colonies != colonies.Num())
+	{
+		UE_LOG(LogACO, Error, TEXT("ACO snapshot %s with %d cells, %d channels and %d colonies doesn't match the current map!"), *filename, header->Cells, header->Channels, header->Colonies);
+		return false;
+	}
+
+	//validate everything before the first value is changed, a broken snapshot leaves the current state intact
+	const int64 fieldSize = static_cast<int64>(header->Cells) * header->Channels;
+	const float* levels = reader.Read<float>(fieldSize);
+	const float* addedPheromones = reader.Read<float>(fieldSize);
+	const float* maxLevels = reader.Read<float>(header->Channels);
+
+	struct ColonyRecords
+	{
+		const ACOSnapshotColony* Colony;
+		const float* RankedTripCosts;
+		const ACOSnapshotAnt* Ants;
+		const int32* Paths;
+	};
+	TArray<ColonyRecords> colonyRecords;
+	for (const ACOColony* colony : colonies)
+	{
+		ColonyRecords records;
+		records.Colony = reader.Read<ACOSnapshotColony>(1);
+		if (!records.Colony || records.Colony->Ants != colony->m_ants.Num() || records.Colony->Anthill != colony->m_anthill || records.Colony->Channel != colony->m_channel)
+		{
+			UE_LOG(LogACO, Error, TEXT("The colonies of ACO snapshot %s don't match the current colonies!"), *filename);
+			return false;
+		}
+		records.RankedTripCosts = reader.Read<float>(records.Colony->RankedTrips);
+		records.Ants = reader.Read<ACOSnapshotAnt>(records.Colony->Ants);
+		int64 pathCells = 0;
+		bool isValid = records.RankedTripCosts && records.Ants;
+		for (int32 i = 0; isValid && i < records.Colony->Ants; ++i)
+		{
+			isValid = records.Ants[i].PathLength >= 0 && records.Ants[i].Position >= 0 && records.Ants[i].Position < header->Cells;
+			pathCells += records.Ants[i].PathLength;
+		}
+		records.Paths = isValid ? reader.Read<int32>(pathCells) : nullptr;
+		for (int64 i = 0; records.Paths && i < pathCells; ++i)
+			isValid &= records.Paths[i] >= 0 && records.Paths[i] < header->Cells;
+		if (!isValid || !records.Paths)
+			break;
+		colonyRecords.Add(records);
+	}
+	if (!levels || !addedPheromones || !maxLevels || colonyRecords.Num() != colonies.Num())
+	{
+		UE_LOG(LogACO, Error, TEXT("ACO snapshot %s is truncated or broken!"), *filename);
+		return false;
+	}
+
+	pheromoneField.restore(levels, addedPheromones, maxLevels);
+
+	for (int32 colonyIndex = 0; colonyIndex < colonies.Num(); ++colonyIndex)
+	{
+		ACOColony* colony = colonies[colonyIndex];
+		const ColonyRecords& records = colonyRecords[colonyIndex];
+		colony->m_iterationCounter = records.Colony->IterationCounter;
+		colony->m_randomStream.Initialize(records.Colony->RandomSeed);
+		colony->m_tripRanking.BestTripCost = records.Colony->BestTripCost;
+		colony->m_tripRanking.PreviousIterationTripCosts.Reset();
+		colony->m_tripRanking.PreviousIterationTripCosts.Append(records.RankedTripCosts, records.Colony->RankedTrips);
+
+		const int32* path = records.Paths;
+		for (int32 i = 0; i < colony->m_ants.Num(); ++i)
+		{
+			const ACOSnapshotAnt& antRecord = records.Ants[i];
+			ACOAnt& ant = colony->m_ants[i];
+			ant.Position = antRecord.Position;
+			ant.pheromonesPerNode = antRecord.PheromonesPerNode;
+			ant.isCarryingFood = antRecord.isCarryingFood != 0;
+			ant.isSearchingFood = antRecord.isSearchingFood != 0;
+			ant.visitedPath.Reset();
+			ant.visitedPath.Append(path, antRecord.PathLength);
+			ant.visitedCells.Reset();
+			ant.NextMoveTime = 0;
+			path += antRecord.PathLength;
+		}
+		//the move times aren't part of the snapshot, all ants of an event driven colony continue at once
+		if (colony->m_parameters.EventDriven)
+			colony->rebuildSchedule();
+	}
+
+	iteration = header->Iteration;
+	UE_LOG(LogACO, Log, TEXT("ACO snapshot %s of iteration %d restored!"), *filename, iteration);
+	return true;
+}
@@ -0,0 +1,83 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "ACOColony.h"
+
+/**
+ * Versioned binary snapshot of the pheromone field and all colonies, taken at an iteration boundary.
+ * Everything is stored 4 byte aligned in native byte order, so a mapped file can be read in place:
+ *
+ * Header      ACOSnapshotHeader, Size is the size of the whole file
+ * Field       levels [cells * channels], added pheromones [cells * channels], max levels [channels]
+ * per colony  ACOSnapshotColony, ranked trip costs [RankedTrips], ACOSnapshotAnt [Ants], visited path cells [sum of all PathLength]
+ */
+struct ACOSnapshotHeader
+{
+	uint32 Magic;
+	uint32 Version;
+	int64 Size;
+	int32 Iteration;
+	int32 Cells;
+	int32 Channels;
+	int32 Colonies;
+};
+
+struct ACOSnapshotColony
+{
+	int32 Anthill;
+	int32 Channel;
+	int32 IterationCounter;
+	int32 RandomSeed;
+	int32 Ants;
+	float BestTripCost;
+	int32 RankedTrips;
+};
+
+struct ACOSnapshotAnt
+{
+	int32 Position;
+	int32 PathLength;
+	float PheromonesPerNode;
+	uint8 isCarryingFood;
+	uint8 isSearchingFood;
+	uint16 Padding;
+};
+
+class ACO_API ACOSnapshot
+{
+public:
+	static const uint32 Magic = 0x534F4341; //"ACOS"
+	static const uint32 Version = 2;
+	/** the snapshot is kept in blocks, so it isn't limited to the 2 GB of a TArray */
+	static const int64 BlockSize = 64 * 1024 * 1024;
+
+	ACOSnapshot() : m_size(0) {}
+
+	/**
+	 * copies the state into the snapshot, the workers must not run a phase meanwhile.
+	 * The offsets of all records are computed first, then the pieces of the field and ranges of ants are copied by ParallelFor.
+	 * The iteration stalls for the copy, the other workers wait at the barrier: about 150 ms per GB on one core plus the page faults of
+	 * the new blocks. Only the write is asynchronous. Copying the state in the phases instead would copy every path in every iteration.
+	 */
+	void Capture(const ACOPheromoneField& pheromoneField, const TArray<ACOColony*>& colonies, int32 iteration);
+	/** moves the captured state to a thread pool thread which writes it, the snapshot is empty afterwards */
+	void WriteAsync(const FString& filename);
+	bool Write(const FString& filename) const;
+
+	static bool IsWriting() { return s_pendingWrites.GetValue() > 0; }
+	static void WaitForPendingWrites();
+
+	/** maps the file and restores the state, the field and the colonies have to be created for the same grid and ant amounts */
+	static bool Restore(const FString& filename, ACOPheromoneField& pheromoneField, const TArray<ACOColony*>& colonies, int32& iteration);
+
+private:
+	/** copies to the offset of the snapshot, tasks may copy to different offsets at once */
+	void copy(int64 offset, const void* values, int64 bytes);
+	/** writes to a temporary file first, so a crash while writing doesn't destroy the previous snapshot */
+	static bool writeFile(const TArray<TArray<uint8>>& blocks, const FString& filename);
+
+	TArray<TArray<uint8>> m_blocks;
+	int64 m_size;
+	static FThreadSafeCounter s_pendingWrites;
+};
@@ -0,0 +1,142 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ACO.h"
+#include "ACOSpatialPartition.h"
+
+ACOSpatialPartition::ACOSpatialPartition()
+{
+}
+
+void ACOSpatialPartition::Build(const ACOGrid& grid, int32 tileAmount, EACOSpaceFillingCurve curve)
+{
+	const TArray<int32> curveOrder = GetCurveOrder(grid, curve);
+	tileAmount = FMath::Clamp(tileAmount, 1, FMath::Max(grid.Num(), 1));
+
+	m_cellRanks.SetNumUninitialized(grid.Num());
+	m_cellTiles.SetNumUninitialized(grid.Num());
+	m_tileCellRanges.Reset();
+	m_tileCellRanges.SetNum(tileAmount);
+
+	TArray<int32> tileCells;
+	for (int32 tile = 0; tile < tileAmount; ++tile)
+	{
+		//equally sized parts of the curve, the remainder is spread over the first tiles
+		const int32 first = static_cast<int64>(grid.Num()) * tile / tileAmount;
+		const int32 last = static_cast<int64>(grid.Num()) * (tile + 1) / tileAmount;
+		tileCells.Reset();
+		for (int32 rank = first; rank < last; ++rank)
+		{
+			const int32 cell = curveOrder[rank];
+			m_cellRanks[cell] = rank;
+			m_cellTiles[cell] = tile;
+			tileCells.Add(cell);
+		}
+
+		//merge the cells into runs of consecutive indices, the pheromone field is evaporated run by run
+		tileCells.Sort();
+		TArray<FIntPoint>& ranges = m_tileCellRanges[tile];
+		for (int32 cell : tileCells)
+		{
+			if (ranges.Num() > 0 && ranges.Last().Y == cell)
+				++ranges.Last().Y;
+			else
+				ranges.Add(FIntPoint(cell, cell + 1));
+		}
+	}
+}
+
+TArray<int32> ACOSpatialPartition::GetCurveOrder(const ACOGrid& grid, EACOSpaceFillingCurve curve)
+{
+	TArray<int32> order;
+	order.SetNumUninitialized(grid.Num());
+	for (int32 cell = 0; cell < grid.Num(); ++cell)
+		order[cell] = cell;
+	if (curve == EACOSpaceFillingCurve::None || grid.Num() == 0)
+		return order;
+
+	FIntPoint minCoordinate = grid.Coordinates[0];
+	FIntPoint maxCoordinate = grid.Coordinates[0];
+	for (const FIntPoint& coordinate : grid.Coordinates)
+	{
+		minCoordinate = minCoordinate.ComponentMin(coordinate);
+		maxCoordinate = maxCoordinate.ComponentMax(coordinate);
+	}
+	const FIntPoint extent = maxCoordinate - minCoordinate + FIntPoint(1, 1);
+	const int32 hilbertOrder = FMath::Max(static_cast<int32>(FMath::CeilLogTwo(static_cast<uint32>(FMath::Max(extent.X, extent.Y)))), 1);
+
+	TArray<uint64> keys;
+	keys.SetNumUninitialized(grid.Num());
+	for (int32 cell = 0; cell < grid.Num(); ++cell)
+	{
+		const FIntPoint coordinate = grid.Coordinates[cell] - minCoordinate;
+		keys[cell] = curve == EACOSpaceFillingCurve::Hilbert ? GetHilbertKey(coordinate, hilbertOrder) : GetMortonKey(coordinate);
+	}
+	//keys are unique per coordinate, the index only breaks ties of invalid grids
+	order.Sort([&keys](int32 a, int32 b) { return keys[a] < keys[b] || (keys[a] == keys[b] && a < b); });
+	return order;
+}
+
+uint64 ACOSpatialPartition::GetHilbertKey(const FIntPoint& coordinate, int32 order)
+{
+	const uint32 n = 1u << order;
+	uint32 x = coordinate.X;
+	uint32 y = coordinate.Y;
+	uint64 key = 0;
+	for (uint32 s = n / 2; s > 0; s /= 2)
+	{
+		const uint32 rx = (x & s) > 0 ? 1 : 0;
+		const uint32 ry = (y & s) > 0 ? 1 : 0;
+		key += static_cast<uint64>(s) * s * ((3 * rx) ^ ry);
+		//rotate the quadrant, so the curve of the next level starts and ends next to its neighbours
+		if (ry == 0)
+		{
+			if (rx == 1)
+			{
+				x = n - 1 - x;
+				y = n - 1 - y;
+			}
+			Swap(x, y);
+		}
+	}
+	return key;
+}
+
+uint64 ACOSpatialPartition::GetMortonKey(const FIntPoint& coordinate)
+{
+	auto spreadBits = [](uint64 value)
+	{
+		value &= 0xFFFFFFFF;
+		value = (value | (value << 16)) & 0x0000FFFF0000FFFFull;
+		value = (value | (value << 8)) & 0x00FF00FF00FF00FFull;
+		value = (value | (value << 4)) & 0x0F0F0F0F0F0F0F0Full;
+		value = (value | (value << 2)) & 0x3333333333333333ull;
+		value = (value | (value << 1)) & 0x5555555555555555ull;
+		return value;
+	};
+	return spreadBits(static_cast<uint32>(coordinate.X)) | (spreadBits(static_cast<uint32>(coordinate.Y)) << 1);
+}
+
+const TCHAR* ACOSpatialPartition::GetCurveName(EACOSpaceFillingCurve curve)
+{
+	switch (curve)
+	{
+	case EACOSpaceFillingCurve::None: return TEXT("None");
+	case EACOSpaceFillingCurve::Hilbert: return TEXT("Hilbert");
+	case EACOSpaceFillingCurve::Morton: return TEXT("Morton");
+	default:
+		return TEXT("Unknown");
+	}
+}
+
+bool ACOSpatialPartition::ParseCurve(const FString& name, EACOSpaceFillingCurve& curve)
+{
+	for (EACOSpaceFillingCurve a : { EACOSpaceFillingCurve::None, EACOSpaceFillingCurve::Hilbert, EACOSpaceFillingCurve::Morton })
+	{
+		if (name == GetCurveName(a))
+		{
+			curve = a;
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,51 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "ACOGrid.h"
+
+enum class EACOSpaceFillingCurve : uint8
+{
+	/** keeps the index order of the grid */
+	None,
+	Hilbert,
+	Morton
+};
+
+/**
+ * Splits the cells of a grid into spatially compact tiles, one per worker.
+ * The cells are ordered along a space-filling curve over their column/row coordinates and every tile gets a contiguous,
+ * equally sized part of the curve. The cells of a tile are stored as runs of consecutive cell indices,
+ * so a grid which is already numbered along the curve gives one run per tile.
+ *
+ * -ACOPartition=Hilbert|Morton|None -ACOAntMigrationInterval=<iterations, 0 = off>
+ */
+class ACO_API ACOSpatialPartition
+{
+public:
+	ACOSpatialPartition();
+
+	void Build(const ACOGrid& grid, int32 tileAmount, EACOSpaceFillingCurve curve);
+
+	int32 GetTileAmount() const { return m_tileCellRanges.Num(); }
+	/** cells [X, Y) of the tile */
+	const TArray<FIntPoint>& GetCellRanges(int32 tile) const { return m_tileCellRanges[tile]; }
+	int32 GetTile(int32 cell) const { return m_cellTiles[cell]; }
+	/** position of every cell along the curve */
+	const TArray<int32>& GetCellRanks() const { return m_cellRanks; }
+
+	/** cells of the grid along the curve */
+	static TArray<int32> GetCurveOrder(const ACOGrid& grid, EACOSpaceFillingCurve curve);
+	/** order is the amount of bits per coordinate */
+	static uint64 GetHilbertKey(const FIntPoint& coordinate, int32 order);
+	static uint64 GetMortonKey(const FIntPoint& coordinate);
+
+	static const TCHAR* GetCurveName(EACOSpaceFillingCurve curve);
+	/** returns false for unknown names */
+	static bool ParseCurve(const FString& name, EACOSpaceFillingCurve& curve);
+
+private:
+	TArray<TArray<FIntPoint>> m_tileCellRanges;
+	TArray<int32> m_cellTiles;
+	TArray<int32> m_cellRanks;
+};
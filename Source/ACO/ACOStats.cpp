@@ -0,0 +1,170 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ACO.h"
+#include "ACOStats.h"
+
+DEFINE_STAT(STAT_ACOTraversePhase);
+DEFINE_STAT(STAT_ACOTraverseBarrier);
+DEFINE_STAT(STAT_ACOMarkPhase);
+DEFINE_STAT(STAT_ACOMarkBarrier);
+DEFINE_STAT(STAT_ACOEvaporatePhase);
+DEFINE_STAT(STAT_ACOEvaporateBarrier);
+DEFINE_STAT(STAT_ACOUpdateByOneWorker);
+DEFINE_STAT(STAT_ACOUpdateBarrier);
+DEFINE_STAT(STAT_ACOBestPaths);
+DEFINE_STAT(STAT_ACOBestPathSearches);
+DEFINE_STAT(STAT_ACOPheromoneLockContention);
+DEFINE_STAT(STAT_ACOWaitLockContention);
+
+namespace
+{
+	/** contentions of the current thread since the last CollectLockContentions */
+	thread_local int32 t_lockContentions[static_cast<int32>(EACOLock::Num)] = {};
+}
+
+bool ACOTrace::s_isEnabled = false;
+FString ACOTrace::s_filename;
+TArray<ACOIterationTrace> ACOTrace::s_rows;
+FCriticalSection ACOTrace::s_criticalRowSection;
+FArchive* ACOTrace::s_file = nullptr;
+FCriticalSection ACOTrace::s_criticalFileSection;
+
+ACOIterationTrace::ACOIterationTrace() : Iteration(0), Worker(0)
+{
+	for (auto& a : PhaseSeconds)
+		a = 0.0;
+	for (auto& a : LockContentions)
+		a = 0;
+}
+
+ACOScopeLock::ACOScopeLock(FCriticalSection* criticalSection, EACOLock lock) : m_criticalSection(criticalSection)
+{
+	if (!m_criticalSection->TryLock())
+	{
+		ACOTrace::CountLockContention(lock);
+		m_criticalSection->Lock();
+	}
+}
+
+ACOScopeLock::~ACOScopeLock()
+{
+	m_criticalSection->Unlock();
+}
+
+void ACOTrace::Enable(const FString& filename)
+{
+	Flush();
+	FScopeLock fileLock(&s_criticalFileSection);
+	s_file = IFileManager::Get().CreateFileWriter(*filename);
+	if (!s_file)
+	{
+		UE_LOG(LogACO, Error, TEXT("Couldn't create ACO trace %s!"), *filename);
+		return;
+	}
+	FTCHARToUTF8 header(TEXT("Iteration,Worker,TraverseMs,TraverseBarrierMs,MarkMs,MarkBarrierMs,EvaporateMs,EvaporateBarrierMs,UpdateByOneWorkerMs,UpdateBarrierMs,PheromoneLockContention,WaitLockContention\n"));
+	s_file->Serialize(const_cast<ANSICHAR*>(header.Get()), header.Length());
+
+	FScopeLock lock(&s_criticalRowSection);
+	s_filename = filename;
+	s_rows.Reset();
+	s_rows.Reserve(BlockRows);
+	s_isEnabled = true;
+}
+
+bool ACOTrace::EnableFromCommandLine(const TCHAR* stream)
+{
+	FString filename;
+	if (!FParse::Value(stream, TEXT("-ACOTrace="), filename))
+		return false;
+	Enable(filename);
+	return IsEnabled();
+}
+
+void ACOTrace::Add(const ACOIterationTrace& row)
+{
+	TArray<ACOIterationTrace> block;
+	{
+		FScopeLock lock(&s_criticalRowSection);
+		if (!s_isEnabled)
+			return;
+		s_rows.Add(row);
+		if (s_rows.Num() < BlockRows)
+			return;
+		block = MoveTemp(s_rows);
+		s_rows.Reserve(BlockRows);
+	}
+	writeRows(block);
+}
+
+void ACOTrace::CollectLockContentions(ACOIterationTrace& row)
+{
+	for (int32 i = 0; i < static_cast<int32>(EACOLock::Num); ++i)
+	{
+		row.LockContentions[i] += t_lockContentions[i];
+		t_lockContentions[i] = 0;
+	}
+}
+
+bool ACOTrace::Flush()
+{
+	TArray<ACOIterationTrace> rows;
+	{
+		FScopeLock lock(&s_criticalRowSection);
+		if (!s_isEnabled)
+			return false;
+		rows = MoveTemp(s_rows);
+		s_isEnabled = false;
+	}
+
+	const bool isWritten = writeRows(rows);
+	FScopeLock fileLock(&s_criticalFileSection);
+	if (s_file)
+	{
+		s_file->Close();
+		delete s_file;
+		s_file = nullptr;
+	}
+	if (isWritten)
+		UE_LOG(LogACO, Log, TEXT("ACO trace written to %s"), *s_filename);
+	return isWritten;
+}
+
+bool ACOTrace::writeRows(const TArray<ACOIterationTrace>& rows)
+{
+	FString table;
+	for (const auto& row : rows)
+	{
+		table += FString::Printf(TEXT("%d,%d"), row.Iteration, row.Worker);
+		for (double seconds : row.PhaseSeconds)
+			table += FString::Printf(TEXT(",%.4f"), seconds * 1000.0);
+		for (int32 contentions : row.LockContentions)
+			table += FString::Printf(TEXT(",%d"), contentions);
+		table += TEXT("\n");
+	}
+
+	FScopeLock fileLock(&s_criticalFileSection);
+	if (!s_file)
+		return false;
+	FTCHARToUTF8 text(*table);
+	s_file->Serialize(const_cast<ANSICHAR*>(text.Get()), text.Length());
+	s_file->Flush();
+	if (s_file->IsError())
+	{
+		UE_LOG(LogACO, Error, TEXT("Couldn't write ACO trace to %s!"), *s_filename);
+		return false;
+	}
+	return true;
+}
+
+void ACOTrace::CountLockContention(EACOLock lock)
+{
+	++t_lockContentions[static_cast<int32>(lock)];
+	if (lock == EACOLock::Pheromone)
+	{
+		INC_DWORD_STAT(STAT_ACOPheromoneLockContention);
+	}
+	else
+	{
+		INC_DWORD_STAT(STAT_ACOWaitLockContention);
+	}
+}
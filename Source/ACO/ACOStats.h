@@ -0,0 +1,120 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+DECLARE_STATS_GROUP(TEXT("ACO"), STATGROUP_ACO, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Traverse Phase"), STAT_ACOTraversePhase, STATGROUP_ACO, ACO_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Traverse Barrier"), STAT_ACOTraverseBarrier, STATGROUP_ACO, ACO_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Mark Phase"), STAT_ACOMarkPhase, STATGROUP_ACO, ACO_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Mark Barrier"), STAT_ACOMarkBarrier, STATGROUP_ACO, ACO_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Evaporate Phase"), STAT_ACOEvaporatePhase, STATGROUP_ACO, ACO_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Evaporate Barrier"), STAT_ACOEvaporateBarrier, STATGROUP_ACO, ACO_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Update By One Worker"), STAT_ACOUpdateByOneWorker, STATGROUP_ACO, ACO_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Update Barrier"), STAT_ACOUpdateBarrier, STATGROUP_ACO, ACO_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Best Paths"), STAT_ACOBestPaths, STATGROUP_ACO, ACO_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Best Path Searches"), STAT_ACOBestPathSearches, STATGROUP_ACO, ACO_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Pheromone Lock Contention"), STAT_ACOPheromoneLockContention, STATGROUP_ACO, ACO_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Wait Lock Contention"), STAT_ACOWaitLockContention, STATGROUP_ACO, ACO_API);
+
+/** phases of an iteration in the order of the worker loop, every phase is followed by its barrier */
+enum class EACOPhase : uint8
+{
+	Traverse,
+	TraverseBarrier,
+	Mark,
+	MarkBarrier,
+	Evaporate,
+	EvaporateBarrier,
+	UpdateByOneWorker,
+	UpdateBarrier,
+	Num
+};
+
+/** locks with counted contention */
+enum class EACOLock : uint8
+{
+	/** AHexagon::m_criticalPheromoneSection */
+	Pheromone,
+	/** ACOWorker::s_criticalWaitSection */
+	Wait,
+	Num
+};
+
+/** one row of the trace, the timings of one worker (or batch job) in one iteration */
+struct ACOIterationTrace
+{
+	ACOIterationTrace();
+
+	int32 Iteration;
+	int32 Worker;
+	double PhaseSeconds[static_cast<int32>(EACOPhase::Num)];
+	int32 LockContentions[static_cast<int32>(EACOLock::Num)];
+};
+
+/** FScopeLock, which counts how often the lock was already taken by another thread */
+class ACO_API ACOScopeLock
+{
+public:
+	ACOScopeLock(FCriticalSection* criticalSection, EACOLock lock);
+	~ACOScopeLock();
+
+private:
+	FCriticalSection* m_criticalSection;
+};
+
+/** cycle counter for the stat system, additionally adds the elapsed time to the phase of a trace row if there is one */
+class ACOScopedPhaseTimer
+{
+public:
+	ACOScopedPhaseTimer(TStatId statId, ACOIterationTrace* trace, EACOPhase phase)
+		: m_cycleCounter(statId), m_trace(trace), m_phase(phase), m_startTime(trace ? FPlatformTime::Seconds() : 0.0) {}
+	~ACOScopedPhaseTimer()
+	{
+		if (m_trace)
+			m_trace->PhaseSeconds[static_cast<int32>(m_phase)] += FPlatformTime::Seconds() - m_startTime;
+	}
+
+private:
+	FScopeCycleCounter m_cycleCounter;
+	ACOIterationTrace* m_trace;
+	EACOPhase m_phase;
+	double m_startTime;
+};
+
+/**
+ * Per iteration trace for headless runs, enabled with -ACOTrace=<file>.csv.
+ * The rows are collected in memory and appended to the file in blocks of BlockRows, so long runs keep a bounded buffer and
+ * a crash only loses the last block. The thread which fills a block writes it after it released the row lock.
+ */
+class ACO_API ACOTrace
+{
+public:
+	static const int32 BlockRows = 4096;
+
+	/** creates the file and writes the header, the trace stays disabled if the file can't be created */
+	static void Enable(const FString& filename);
+	static bool IsEnabled() { return s_isEnabled; }
+	/** -ACOTrace=<file> of the command line, returns true if the trace was enabled */
+	static bool EnableFromCommandLine(const TCHAR* stream);
+
+	/** thread safe */
+	static void Add(const ACOIterationTrace& row);
+	/** moves the contentions the calling thread counted since the last call into the row */
+	static void CollectLockContentions(ACOIterationTrace& row);
+	/** writes the remaining rows, closes the file and disables the trace */
+	static bool Flush();
+
+	static void CountLockContention(EACOLock lock);
+
+private:
+	/** appends the rows to the file, the blocks of two threads can end up in either order, the rows carry their iteration and worker */
+	static bool writeRows(const TArray<ACOIterationTrace>& rows);
+
+	static bool s_isEnabled;
+	static FString s_filename;
+	static TArray<ACOIterationTrace> s_rows;
+	static FCriticalSection s_criticalRowSection;
+	static FArchive* s_file;
+	static FCriticalSection s_criticalFileSection;
+};
@@ -0,0 +1,75 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ACO.h"
+#include "ACOTimingWheel.h"
+
+ACOTimingWheel::ACOTimingWheel() : m_now(0), m_amount(0)
+{
+}
+
+void ACOTimingWheel::Reset(int32 now)
+{
+	for (auto& level : m_slots)
+	{
+		for (auto& slot : level)
+			slot.Reset();
+	}
+	m_overflow.Reset();
+	m_now = now;
+	m_amount = 0;
+}
+
+void ACOTimingWheel::Schedule(int32 item, int32 time)
+{
+	Entry entry;
+	entry.Item = item;
+	entry.Time = FMath::Max(time, m_now + 1);
+	insert(entry);
+	++m_amount;
+}
+
+void ACOTimingWheel::Advance(TArray<int32>& dueItems)
+{
+	++m_now;
+
+	//a wrapped level hands the items of its current slot to the levels below, the highest level first
+	const uint32 now = static_cast<uint32>(m_now);
+	if ((now & ((1u << (SlotBits * Levels)) - 1)) == 0)
+		cascade(m_overflow);
+	for (int32 level = Levels - 1; level > 0; --level)
+	{
+		if ((now & ((1u << (SlotBits * level)) - 1)) == 0)
+			cascade(m_slots[level][(now >> (SlotBits * level)) & (SlotAmount - 1)]);
+	}
+
+	TArray<Entry>& slot = m_slots[0][now & (SlotAmount - 1)];
+	for (const Entry& entry : slot)
+		dueItems.Add(entry.Item);
+	m_amount -= slot.Num();
+	slot.Reset();
+}
+
+void ACOTimingWheel::insert(const Entry& entry)
+{
+	//the lowest level whose slot range contains both times
+	const uint32 time = static_cast<uint32>(entry.Time);
+	const uint32 now = static_cast<uint32>(m_now);
+	for (int32 level = 0; level < Levels; ++level)
+	{
+		const int32 shift = SlotBits * (level + 1);
+		if ((time >> shift) == (now >> shift))
+		{
+			m_slots[level][(time >> (SlotBits * level)) & (SlotAmount - 1)].Add(entry);
+			return;
+		}
+	}
+	m_overflow.Add(entry);
+}
+
+void ACOTimingWheel::cascade(TArray<Entry>& slot)
+{
+	TArray<Entry> entries = MoveTemp(slot);
+	slot.Reset();
+	for (const Entry& entry : entries)
+		insert(entry);
+}
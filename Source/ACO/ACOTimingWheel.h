@@ -0,0 +1,45 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+/**
+ * Hierarchical timing wheel of integer items (e.g. ant indices) scheduled at integer ticks.
+ * Level 0 has one slot per tick, every further level covers SlotAmount slots of the level below; items are moved down
+ * a level when the time reaches their slot, so scheduling and advancing cost O(1) per item and level.
+ * Items beyond the highest level wait in an overflow list.
+ */
+class ACO_API ACOTimingWheel
+{
+public:
+	static const int32 SlotBits = 6;
+	static const int32 SlotAmount = 1 << SlotBits;
+	static const int32 Levels = 4;
+
+	ACOTimingWheel();
+
+	/** removes all items */
+	void Reset(int32 now);
+	/** items scheduled at or before the current time are due with the next Advance */
+	void Schedule(int32 item, int32 time);
+	/** goes to the next tick and appends the items which are due at it */
+	void Advance(TArray<int32>& dueItems);
+
+	int32 GetTime() const { return m_now; }
+	int32 Num() const { return m_amount; }
+
+private:
+	struct Entry
+	{
+		int32 Item;
+		int32 Time;
+	};
+
+	void insert(const Entry& entry);
+	/** reinserts the entries of the slot the current time points to on the level */
+	void cascade(TArray<Entry>& slot);
+
+	TArray<Entry> m_slots[Levels][SlotAmount];
+	TArray<Entry> m_overflow;
+	int32 m_now;
+	int32 m_amount;
+};
@@ -3,29 +3,83 @@
 #include "ACO.h"
 #include "ACOWorker.h"
 #include "Hexagon.h"
-#include "Pathfinding.h"
-#include "ACOPlayerController.h"
+#include "ACOSnapshot.h"
 
 int ACOWorker::s_workerCount = 0;
 TArray<FScopedEvent*> ACOWorker::s_waitEvents;
 FCriticalSection ACOWorker::s_criticalWaitSection;
-float ACOWorker::s_traversePhaseConstantA = 5.f;
-float ACOWorker::s_traversePhaseConstantB = 9.f;
-float ACOWorker::s_evaporationCoefficentP = 0.05f;
+ACOGrid* ACOWorker::s_grid = nullptr;
+ACOPheromoneField* ACOWorker::s_pheromoneField = nullptr;
+TArray<ACOColony*> ACOWorker::s_colonies;
+TArray<ACOParameters> ACOWorker::s_channelParameters;
+TArray<ACOConvergenceTracker> ACOWorker::s_convergenceTrackers;
+ACOConvergenceCriteria ACOWorker::s_convergenceCriteria;
+bool ACOWorker::s_hasConverged = false;
+FString ACOWorker::s_checkpointFilename;
+int32 ACOWorker::s_checkpointInterval = 0;
+bool ACOWorker::s_isCheckpointRequested = false;
+FThreadSafeCounter ACOWorker::s_checkpointCounter;
+ACOIterationLog* ACOWorker::s_iterationLog = nullptr;
+ACOSharedMemoryExport* ACOWorker::s_sharedMemoryExport = nullptr;
+ACORouteQueryService* ACOWorker::s_routeQueryService = nullptr;
+ACOMultiLevel* ACOWorker::s_multiLevel = nullptr;
+TArray<int32> ACOWorker::s_antMigrationCellRanks;
+int32 ACOWorker::s_antMigrationInterval = 0;
+FThreadSafeBool ACOWorker::s_isPaused(false);
+FThreadSafeBool ACOWorker::s_isStopping(false);
+FThreadSafeCounter ACOWorker::s_parkedWorkers;
+FEvent* ACOWorker::s_controlEvent = nullptr;
+FEvent* ACOWorker::s_resumeEvent = nullptr;
 int ACOWorker::s_iterationCounter = 0;
-bool ACOWorker::s_updateByOneWorker = true;
-AHexagon* ACOWorker::s_anthill = nullptr;
-std::vector<class AHexagon*> ACOWorker::s_pathHexagons;
+FThreadSafeBool ACOWorker::s_updateByOneWorker(true);
+TArray<TPair<int32, bool>> ACOWorker::s_pendingFoodSources;
+TUniquePtr<ACOBestPaths> ACOWorker::s_bestPaths;
 bool ACOWorker::s_renderBestPath = false;
 
-ACOWorker::ACOWorker(const TArray<AHexagon*>& hexagons, AHexagon* anthillHex, const int& antAmount) : m_hexagons(hexagons)
+ACOWorker::ACOWorker(ACOGrid& grid, ACOPheromoneField& pheromoneField, const TArray<ACOColony*>& colonies, const TArray<FIntPoint>& cellRanges, const TArray<FIntPoint>& antRanges)
+	: m_cellRanges(cellRanges), m_antRanges(antRanges)
 {
-	for (int i = 0; i < antAmount; ++i)
-		m_ants.push_back(new Ant(anthillHex));
+	s_grid = &grid;
+	s_pheromoneField = &pheromoneField;
+	s_colonies = colonies;
+	s_channelParameters.Reset();
+	for (auto colony : colonies)
+		s_channelParameters.Add(colony->GetParameters());
+
+	//the first worker of a run resets the convergence, the others are created while it already waits for them
+	if (s_workerCount == 0)
+	{
+		s_convergenceTrackers.Init(ACOConvergenceTracker(s_convergenceCriteria), colonies.Num());
+		s_hasConverged = false;
+
+		//-ACOBestPathTolerance=0.05 -ACOBestPathBand=2 -ACOBestPathRefresh=100, the previous run released its paths with its grid
+		s_bestPaths.Reset(new ACOBestPaths(grid));
+		s_bestPaths->ParseCommandLine(FCommandLine::Get());
+
+		//manual reset events, they stay in their state until the next request
+		if (!s_controlEvent)
+		{
+			s_controlEvent = FPlatformProcess::GetSynchEventFromPool(true);
+			s_resumeEvent = FPlatformProcess::GetSynchEventFromPool(true);
+		}
+		s_isPaused = false;
+		s_isStopping = false;
+		s_parkedWorkers.Reset();
+		s_pendingFoodSources.Reset();
+		s_controlEvent->Reset();
+		s_resumeEvent->Trigger();
+	}
+
+	int32 antAmount = 0;
+	for (const auto& range : antRanges)
+		antAmount += range.Y - range.X;
+	int32 cellAmount = 0;
+	for (const auto& range : cellRanges)
+		cellAmount += range.Y - range.X;
 
-	s_anthill = anthillHex;
 	m_randomStream.Initialize(1610585006 * FDateTime::Now().GetMillisecond());
 
+	m_workerIndex = s_workerCount;
 	m_name = "ACO_Thread_";
 	m_name.AppendInt(++s_workerCount);
 	Thread = FRunnableThread::Create(this, *m_name, 0, TPri_Normal); //windows default = 8mb for thread, could specify more
@@ -36,37 +90,56 @@ ACOWorker::ACOWorker(const TArray<AHexagon*>& hexagons, AHexagon* anthillHex, co
 	}
 	else
 	{
-		UE_LOG(LogACO, Log, TEXT("%s created with %d different Hexagons and %d Ants!"), *m_name, hexagons.Num(), antAmount);
+		UE_LOG(LogACO, Log, TEXT("%s created with %d different Hexagons in %d ranges and %d Ants of %d Colonies!"), *m_name, cellAmount, cellRanges.Num(), antAmount, colonies.Num());
 	}
 }
 
 ACOWorker::~ACOWorker()
 {
-	//free waiting waitEvents
-	for (auto a : s_waitEvents)
-	{
-		if (a)
-			a->Trigger();
-	}
-	s_waitEvents.Empty();
-
-	//kill thread
-	if (Thread)
-	{
-		Thread->Kill();
-		delete Thread;
-		Thread = nullptr;
-	}
+	//the thread leaves Run at its next control point, it is never killed
+	RequestStop();
+	WaitForExit();
+	delete Thread;
+	Thread = nullptr;
 
 	//decrement overall counter
 	--s_workerCount;
 
-	for (auto a : m_ants)
-		delete a;
-
 	UE_LOG(LogACO, Log, TEXT("%s destroyed!"), *m_name);
 }
 
+void ACOWorker::SetConvergenceCriteria(const ACOConvergenceCriteria& criteria)
+{
+	s_convergenceCriteria = criteria;
+}
+
+void ACOWorker::SetCheckpoint(const FString& filename, int32 interval)
+{
+	s_checkpointFilename = filename;
+	s_checkpointInterval = interval;
+}
+
+void ACOWorker::SetAntMigration(const TArray<int32>& cellRanks, int32 interval)
+{
+	s_antMigrationCellRanks = cellRanks;
+	s_antMigrationInterval = interval;
+}
+
+int32 ACOWorker::RequestCheckpoint()
+{
+	ACOScopeLock lock(&s_criticalWaitSection, EACOLock::Wait);
+	s_isCheckpointRequested = true;
+	return s_checkpointCounter.GetValue();
+}
+
+void ACOWorker::writeCheckpoint()
+{
+	ACOSnapshot snapshot;
+	snapshot.Capture(*s_pheromoneField, s_colonies, s_iterationCounter);
+	snapshot.WriteAsync(s_checkpointFilename);
+	s_checkpointCounter.Increment();
+}
+
 bool ACOWorker::Init()
 {
 	return true;
@@ -75,39 +148,110 @@ bool ACOWorker::Init()
 uint32 ACOWorker::Run()
 {
 	//Initial wait before starting
-	FPlatformProcess::Sleep(0.03f);
+	sleep(0.03f);
 
-	while (StopTaskCounter.GetValue() == 0)
+	//s_hasConverged only changes in updateThingsByOneWorker before the last barrier of an iteration, so all workers leave at the same iteration
+	while (!s_isStopping && !HasStoppedOnConvergence())
 	{
-		//prevent thread from using too many resources
-		FPlatformProcess::Sleep(0.01);
+		//prevent thread from using too many resources, a lot more once the colonies have converged and should be throttled
+		sleep(s_hasConverged && s_convergenceCriteria.Action == EACOConvergenceAction::Throttle ? s_convergenceCriteria.ThrottleSleep : 0.01f);
 		s_updateByOneWorker = true;
 
 		//do ACO work
-		traversePhase();
-		markPhase();
-		evaporatePhase();
-
-		//other
-		updateThingsByOneWorker();
+		const bool isIterationDone = runPhase(&ACOWorker::traversePhase, EACOPhase::Traverse, GET_STATID(STAT_ACOTraversePhase), GET_STATID(STAT_ACOTraverseBarrier))
+			&& runPhase(&ACOWorker::markPhase, EACOPhase::Mark, GET_STATID(STAT_ACOMarkPhase), GET_STATID(STAT_ACOMarkBarrier))
+			&& runPhase(&ACOWorker::evaporatePhase, EACOPhase::Evaporate, GET_STATID(STAT_ACOEvaporatePhase), GET_STATID(STAT_ACOEvaporateBarrier))
+			&& runPhase(&ACOWorker::updateThingsByOneWorker, EACOPhase::UpdateByOneWorker, GET_STATID(STAT_ACOUpdateByOneWorker), GET_STATID(STAT_ACOUpdateBarrier));
+		if (!isIterationDone)
+			break;
+
+		if (ACOTrace::IsEnabled())
+		{
+			m_trace.Iteration = s_iterationCounter;
+			m_trace.Worker = m_workerIndex;
+			ACOTrace::CollectLockContentions(m_trace);
+			ACOTrace::Add(m_trace);
+		}
+		m_trace = ACOIterationTrace();
 	}
 
+	//a finished worker never blocks a pause
+	s_parkedWorkers.Increment();
 	return 0;
 }
 
 void ACOWorker::Stop()
 {
-	StopTaskCounter.Increment();
+	RequestStop();
 }
 
-void ACOWorker::Pause() const
+double ACOWorker::PauseAll()
 {
-	Thread->Suspend(true);
+	const double startTime = FPlatformTime::Seconds();
+	if (!s_controlEvent)
+		return 0.0;
+	s_isPaused = true;
+	s_resumeEvent->Reset();
+	s_controlEvent->Trigger();
+	while (s_parkedWorkers.GetValue() < s_workerCount && !s_isStopping)
+		FPlatformProcess::YieldThread();
+	return FPlatformTime::Seconds() - startTime;
 }
 
-void ACOWorker::Unpause() const
+void ACOWorker::ResumeAll()
 {
-	Thread->Suspend(false);
+	if (!s_controlEvent)
+		return;
+	s_isPaused = false;
+	if (!s_isStopping)
+		s_controlEvent->Reset();
+	s_resumeEvent->Trigger();
+}
+
+void ACOWorker::RequestStop()
+{
+	if (!s_controlEvent)
+		return;
+	s_isStopping = true;
+	s_controlEvent->Trigger();
+	s_resumeEvent->Trigger();
+
+	//workers at a barrier are released, the ones which arrive later don't wait anymore
+	ACOScopeLock lock(&s_criticalWaitSection, EACOLock::Wait);
+	for (auto a : s_waitEvents)
+		a->Trigger();
+	s_waitEvents.Empty();
+}
+
+void ACOWorker::WaitForExit()
+{
+	if (Thread)
+		Thread->WaitForCompletion();
+}
+
+bool ACOWorker::passControlPoint()
+{
+	if (s_isPaused && !s_isStopping)
+	{
+		s_parkedWorkers.Increment();
+		while (s_isPaused && !s_isStopping)
+			s_resumeEvent->Wait();
+		s_parkedWorkers.Decrement();
+	}
+	return !s_isStopping;
+}
+
+void ACOWorker::sleep(float seconds)
+{
+	s_controlEvent->Wait(static_cast<uint32>(seconds * 1000.f));
+}
+
+void ACOWorker::ReleaseBestPaths()
+{
+	ACOScopeLock lock(&s_criticalWaitSection, EACOLock::Wait);
+	if (s_bestPaths)
+		s_bestPaths->Clear();
+	s_bestPaths.Reset();
 }
 
 void ACOWorker::ToggleShowBestPath()
@@ -115,183 +259,194 @@ void ACOWorker::ToggleShowBestPath()
 	s_renderBestPath = !s_renderBestPath;
 }
 
-void ACOWorker::traversePhase()
+void ACOWorker::SetFoodSource(AHexagon* hex, bool yesOrNo)
 {
-	for (auto ant : m_ants)
-	{
-		AHexagon* newPosition = nullptr;
-		if (!ant->isCarryingFood && ant->isSearchingFood)
-		{
-			//add current position for finding the path back to anthill
-			ant->visitedPath.Push(ant->Position);
-
-			/* calculate probability p for a turn from Hex I (current position) to Hex J (neighbor)
-			* pij for ant k = (Tij^a * nij^b) / (sum of: Tih^a * nih^b, where h is element of H which are all unvisited neighbours)
-			* Tij ... Pheromones from I to J
-			* nij = 1 / lij
-			* lij ... length from I to J
-			*/
-
-			//probability divisor
-			float sumOfUnvisitedNodes = 0.f;
-			//probability dividend
-			TMap<AHexagon*, float> dividends;
-			int visitableNeighbours = ant->Position->GetNeighbourHexagons().Num();
-
-			//iterate through every neighbour
-			for (auto neighbour : ant->Position->GetNeighbourHexagons())
-			{
-				//neighbour visitable?
-				if (ant->visitedPath.Contains(neighbour) || !neighbour->IsWalkable())
-				{
-					--visitableNeighbours;
-					continue;
-				}
-
-				//Tih or Tij
-				float pheromoneLevel = neighbour->GetPheromoneLevel() <= 0.0f ? 1.f : neighbour->GetPheromoneLevel();
-				//nih or nij
-				float terrainCost = 1 / neighbour->GetTerrainCost();
-
-				//Tih^a or Tij^a
-				pheromoneLevel = FMath::Pow(pheromoneLevel, s_traversePhaseConstantA);
-				//nih^b or nij^b
-				terrainCost = FMath::Pow(terrainCost, s_traversePhaseConstantB);
-
-				float multiplication = pheromoneLevel * terrainCost;
-
-				sumOfUnvisitedNodes += multiplication;
-				//add multiplication with costs from I to J
-				dividends.Add(neighbour, multiplication);
-			}
+	//the best paths read the food sources while the other workers wait, so the grid only changes in the update
+	ACOScopeLock lock(&s_criticalWaitSection, EACOLock::Wait);
+	int32 cell = s_grid ? s_grid->GetCellIndex(hex) : INDEX_NONE;
+	if (cell != INDEX_NONE)
+		s_pendingFoodSources.Add(TPair<int32, bool>(cell, yesOrNo));
+}
 
-			//if there are neighbours to visit
-			if (visitableNeighbours > 0)
-			{
-				//calculate move probabilities
-				TMap<AHexagon*, float> probabilities;
-				for (auto& dividend : dividends)
-					probabilities.Add(dividend.Key, dividend.Value / sumOfUnvisitedNodes);
-
-				//choose new position randomly
-				while (!newPosition)
-				{
-					float random = m_randomStream.FRandRange(0.0f, 1.0f);
-					for (auto& prob : probabilities)
-					{
-						if (random < prob.Value)
-						{
-							newPosition = prob.Key;
-							break;
-						}
-						random -= prob.Value;
-
-					}
-				}
-			}
-			else
-			{
-				//no visitable node
-				//return to anthill
-				ant->isSearchingFood = false;
-			}
-		}
-		if (!ant->isSearchingFood || ant->isCarryingFood)
-		{
-			//go back to anthill
-			newPosition = ant->visitedPath.Pop();
-			if (newPosition == ant->Position)
-				newPosition = ant->visitedPath.Pop();
-		}
-		ant->Position = newPosition;
+bool ACOWorker::SetTerrainType(AHexagon* hex, ETerrainType type)
+{
+	//the colonies read the terrain in every phase, so it only changes while all workers are parked
+	const bool wasPaused = IsPaused();
+	PauseAll();
+	const int32 cell = s_grid ? s_grid->GetCellIndex(hex) : INDEX_NONE;
+	const bool isChanged = cell != INDEX_NONE && s_grid->SetTerrainType(cell, type);
+	if (!wasPaused)
+		ResumeAll();
+	return isChanged;
+}
 
-		//is new pos foodsource?
-		if (newPosition->IsFoodSource() && ant->isSearchingFood)
-		{
-			ant->isCarryingFood = true;
-			ant->isSearchingFood = false;
-			ant->pheromonesPerNode = Pathfinding::AStarSearchHeuristic(ant->visitedPath[0], newPosition) / ant->visitedPath.Num() + 1;
-		}
-		else if (!ant->isSearchingFood && newPosition->GetTerrainCost() == static_cast<int>(ETerrainType::TT_Anthill))
+bool ACOWorker::runPhase(void (ACOWorker::*phase)(), EACOPhase phaseId, TStatId phaseStatId, TStatId barrierStatId)
+{
+	if (!passControlPoint())
+		return false;
+	ACOIterationTrace* trace = ACOTrace::IsEnabled() || s_iterationLog ? &m_trace : nullptr;
+	{
+		ACOScopedPhaseTimer timer(phaseStatId, trace, phaseId);
+		(this->*phase)();
+	}
+	{
+		ACOScopedPhaseTimer timer(barrierStatId, trace, static_cast<EACOPhase>(static_cast<int32>(phaseId) + 1));
+		return waitForAllWorkers();
+	}
+}
+
+void ACOWorker::traversePhase()
+{
+	for (int32 i = 0; i < s_colonies.Num(); ++i)
+	{
+		for (int32 first = m_antRanges[i].X; first < m_antRanges[i].Y; first += AntSlice)
 		{
-			//is back in anthill
-			ant->isCarryingFood = false;
-			ant->isSearchingFood = true;
+			if (!passControlPoint())
+				return;
+			s_colonies[i]->TraverseAnts(first, FMath::Min(first + AntSlice, m_antRanges[i].Y), m_randomStream, m_tripStatistics);
 		}
 	}
-
-	waitForAllWorkers();
 }
 
 void ACOWorker::markPhase()
 {
-	for (auto ant : m_ants)
-	{
-		if (ant->isCarryingFood)
-			ant->Position->AddPheromones(ant->pheromonesPerNode);
-	}
-	waitForAllWorkers();
+	for (int32 i = 0; i < s_colonies.Num(); ++i)
+		s_colonies[i]->MarkAnts(m_antRanges[i].X, m_antRanges[i].Y);
 }
 
 void ACOWorker::evaporatePhase()
 {
-	for (auto a : m_hexagons)
+	DispatchACOVariant(s_channelParameters[0].Variant, [this](auto policies)
 	{
-		a->SetPheromoneLevel((1.0f - s_evaporationCoefficentP) * a->GetCapturedPheromoneLevel() + a->GetPreviouslyAddedPheromonesAndResetVar());
-		a->CapturePheromoneLevel();
-		a->UpdateMaxPheromonesOnTheMap();
-		a->UpdatePheromoneVisualization();
+		for (const FIntPoint& range : m_cellRanges)
+		{
+			for (int32 first = range.X; first < range.Y; first += CellSlice)
+			{
+				if (!passControlPoint())
+					return;
+				s_pheromoneField->Evaporate<typename decltype(policies)::Evaporation>(first, FMath::Min(first + CellSlice, range.Y), s_channelParameters.GetData());
+			}
+		}
+	});
+
+	//mirror the levels of all colonies into the hexagons for the visualization
+	if (s_grid->Hexagons.Num() > 0)
+	{
+		for (const FIntPoint& range : m_cellRanges)
+		{
+			for (int32 cell = range.X; cell < range.Y; ++cell)
+			{
+				if ((cell - range.X) % CellSlice == 0 && !passControlPoint())
+					return;
+				AHexagon* hex = s_grid->Hexagons[cell];
+				hex->SetPheromoneLevel(s_pheromoneField->GetTotalPheromoneLevel(cell));
+				hex->UpdateMaxPheromonesOnTheMap();
+				hex->UpdatePheromoneVisualization();
+			}
+		}
 	}
-	waitForAllWorkers();
 }
 
-void ACOWorker::waitForAllWorkers()
+bool ACOWorker::waitForAllWorkers()
 {
-	FScopedEvent myEvent;
-	FScopeLock lock(&s_criticalWaitSection);
-	s_waitEvents.Push(&myEvent);
-	if (s_waitEvents.Num() == s_workerCount)
+	bool isWaiting = false;
 	{
-		for (auto a : s_waitEvents)
-			a->Trigger();
-		s_waitEvents.Empty();
+		//the event waits when it goes out of scope
+		FScopedEvent myEvent;
+		{
+			ACOScopeLock lock(&s_criticalWaitSection, EACOLock::Wait);
+			if (s_isStopping)
+			{
+				myEvent.Trigger();
+				return false;
+			}
+			s_waitEvents.Push(&myEvent);
+			if (s_waitEvents.Num() == s_workerCount)
+			{
+				for (auto a : s_waitEvents)
+					a->Trigger();
+				s_waitEvents.Empty();
+			}
+			else
+			{
+				isWaiting = true;
+			}
+		}
+		//a paused worker elsewhere keeps this one here, it counts as parked
+		if (isWaiting)
+			s_parkedWorkers.Increment();
 	}
+	if (isWaiting)
+		s_parkedWorkers.Decrement();
+	return !s_isStopping;
 }
 
 void ACOWorker::updateThingsByOneWorker()
 {
+	//the first worker updates, the others go straight to the barrier and count as parked there, so the update needs no lock.
+	//it passes a control point between the steps and inside the long ones, a pause or stop waits for one step at most
+	if (!s_updateByOneWorker.AtomicSet(false))
+		return;
+
 	{
-		FScopeLock lock(&s_criticalWaitSection);
-		if (s_updateByOneWorker)
-		{
-			//reset current best path hexs
-			for (auto hex : s_pathHexagons)
-				hex->SetIsAPath(false);
-			s_pathHexagons.clear();
+		ACOScopeLock lock(&s_criticalWaitSection, EACOLock::Wait);
+		for (const TPair<int32, bool>& foodSource : s_pendingFoodSources)
+			s_grid->SetFoodSource(foodSource.Key, foodSource.Value);
+		s_pendingFoodSources.Reset();
+	}
 
-			if (s_renderBestPath)
-			{
-				// do pathfinding for each foodsource
-				auto foodSources = AACOPlayerController::GetFoodSources();
-				for (const auto& foodSource : foodSources)
-				{
-					std::unordered_map<AHexagon*, AHexagon*> came_from;
-					Pathfinding::AStarSearch(s_anthill, foodSource, came_from);
-					for (auto pathHex : Pathfinding::ReconstructPath(s_anthill, foodSource, came_from))
-					{
-						if (pathHex != s_anthill && pathHex != foodSource)
-						{
-							s_pathHexagons.push_back(pathHex);
-							pathHex->SetIsAPath(true);
-						}
-					}
-				}
-			}
+	//only the routes a pheromone change could have altered are searched again, see ACOBestPaths
+	if (!s_bestPaths->Update(*s_pheromoneField, s_colonies, s_renderBestPath, &passControlPoint))
+		return;
+
+	++s_iterationCounter;
+	bool hasConverged = s_colonies.Num() > 0;
+	for (int32 i = 0; i < s_colonies.Num(); ++i)
+	{
+		s_colonies[i]->FinishIteration();
+		const ACOConvergenceSample& sample = s_convergenceTrackers[i].Update(*s_colonies[i]);
+		hasConverged &= s_convergenceTrackers[i].HasConverged();
 
-			GLog->Log("Iteration: " + FString::FromInt(++s_iterationCounter));
-			AHexagon::ResetMaxPheromonesOnTheMap();
-			s_updateByOneWorker = false;
+		if (s_convergenceCriteria.LogInterval > 0 && s_iterationCounter % s_convergenceCriteria.LogInterval == 0)
+		{
+			UE_LOG(LogACO, Log, TEXT("Iteration %d colony %d: best trip %g (iteration %g, mean %g), route entropy %.3f, route stable for %d iterations"),
+				s_iterationCounter, i, sample.BestTripCost, sample.IterationBestTripCost, sample.IterationMeanTripCost, sample.RouteEntropy, sample.RouteStability);
 		}
 	}
-	waitForAllWorkers();
+	if (hasConverged && !s_hasConverged)
+		UE_LOG(LogACO, Log, TEXT("All colonies converged after %d iterations!"), s_iterationCounter);
+	const bool isStoppingOnConvergence = hasConverged && !s_hasConverged && s_convergenceCriteria.Action == EACOConvergenceAction::Stop;
+	s_hasConverged = hasConverged;
+
+	if (!passControlPoint() || (s_multiLevel && !s_multiLevel->OnIterationFinished(*s_pheromoneField, s_iterationCounter, &passControlPoint)))
+		return;
+
+	if (s_iterationLog && passControlPoint())
+		s_iterationLog->LogIteration(s_iterationCounter, s_colonies, *s_pheromoneField, m_trace);
+	if (s_sharedMemoryExport && passControlPoint())
+		s_sharedMemoryExport->Publish(s_iterationCounter, s_colonies, *s_pheromoneField, s_convergenceTrackers);
+	if (s_routeQueryService && passControlPoint())
+		s_routeQueryService->OnIterationFinished(*s_pheromoneField, s_iterationCounter);
+	if (!passControlPoint())
+		return;
+
+	//a periodic snapshot is skipped while the previous one is written
+	bool isCheckpointRequested = false;
+	{
+		ACOScopeLock lock(&s_criticalWaitSection, EACOLock::Wait);
+		isCheckpointRequested = s_isCheckpointRequested;
+		s_isCheckpointRequested = false;
+	}
+	const bool isCheckpointDue = isCheckpointRequested || isStoppingOnConvergence || (s_checkpointInterval > 0 && s_iterationCounter % s_checkpointInterval == 0 && !ACOSnapshot::IsWriting());
+	if (!s_checkpointFilename.IsEmpty() && isCheckpointDue)
+		writeCheckpoint();
+
+	if (s_antMigrationInterval > 0 && s_iterationCounter % s_antMigrationInterval == 0 && s_antMigrationCellRanks.Num() == s_grid->Num())
+	{
+		for (auto colony : s_colonies)
+			colony->SortAnts(s_antMigrationCellRanks);
+	}
+
+	AHexagon::ResetMaxPheromonesOnTheMap();
+	s_pheromoneField->ResetMaxPheromoneLevels();
 }
@@ -1,48 +1,88 @@
-// Fill out your copyright notice in the Description page of Project Settings.
+ // Fill out your copyright notice in the Description page of Project Settings.
 
 #pragma once
 
-#include <vector>
+#include "ACOConvergence.h"
+#include "ACOStats.h"
+#include "ACOIterationLog.h"
+#include "ACOSharedMemoryExport.h"
+#include "ACORouteQueryService.h"
+#include "ACOMultiLevel.h"
+#include "ACOBestPaths.h"
+
 /**
- * 
+ * The workers iterate all colonies together, every phase ends at a barrier.
+ * Pause and stop are cooperative: the workers check the requests at every phase boundary and after every slice of ants or cells,
+ * so they never hold a lock while they wait and the latency is the time of one slice.
+ * The update at the end of an iteration is done by the first worker which reaches it, the others wait at the barrier meanwhile. The updating
+ * worker checks the requests between the update steps, before every best path search and every coarse iteration of ACOMultiLevel, so its
+ * latency is the longest step in between: one A* search, one coarse iteration or one scan of the field by the log, the export or the route service.
  */
-struct Ant
-{
-	explicit Ant(class AHexagon* pos): Position(pos), isCarryingFood(false), isSearchingFood(true), pheromonesPerNode(0.0f) {}
-
-	class AHexagon* Position;
-	TArray<class AHexagon*> visitedPath;
-	bool isCarryingFood;
-	bool isSearchingFood;
-	float pheromonesPerNode;
-};
-
 class ACO_API ACOWorker : public FRunnable
 {
 public:
-	ACOWorker(const TArray<class AHexagon*>& hexagons, class AHexagon* anthillHex, const int& antAmount);
+	/** the worker evaporates the cells [X, Y) of every range in cellRanges and moves the ants [X, Y) of every colony in antRanges */
+	ACOWorker(ACOGrid& grid, ACOPheromoneField& pheromoneField, const TArray<ACOColony*>& colonies, const TArray<FIntPoint>& cellRanges, const TArray<FIntPoint>& antRanges);
+	/** stops all workers and waits for the thread */
 	~ACOWorker();
 
 	//Begin FRunnable Methods
 	bool Init() override;
 	uint32 Run() override;
+	/** the workers share the barriers, so one worker can't stop alone, same as RequestStop */
 	void Stop() override;
 	//End
 
-	/** Pause this thread */
-	void Pause() const;
-	/** Unpause this thread */
-	void Unpause() const;
+	/** waits until all workers wait at a control point or a barrier, returns the seconds it took */
+	static double PauseAll();
+	static void ResumeAll();
+	static bool IsPaused() { return s_isPaused; }
+	/** all workers leave their loop at the next control point, waiting ones are woken up */
+	static void RequestStop();
+	/** waits until the thread has left Run */
+	void WaitForExit();
 
 	static void ToggleShowBestPath();
+	static void SetShowBestPath(bool isShown) { s_renderBestPath = isShown; }
+	static bool IsShowingBestPath() { return s_renderBestPath; }
+	/** removes the highlights and forgets the grid, has to be called after the workers stopped and while the grid and its hexagons still exist */
+	static void ReleaseBestPaths();
+	/** adds or removes a food source while the workers are running, it changes in the grid with the next update of an iteration */
+	static void SetFoodSource(class AHexagon* hex, bool yesOrNo);
+	/** changes the walkable terrain of a cell while the workers are paused, the anthill distances are repaired, see ACOGrid::SetTerrainType */
+	static bool SetTerrainType(class AHexagon* hex, ETerrainType type);
+	/** has to be set before the first worker is created */
+	static void SetConvergenceCriteria(const ACOConvergenceCriteria& criteria);
+	/** true if all colonies have converged */
+	static bool HasConverged() { return s_hasConverged; }
+	/** true if the workers left their loop because all colonies have converged */
+	static bool HasStoppedOnConvergence() { return s_hasConverged && s_convergenceCriteria.Action == EACOConvergenceAction::Stop; }
+	/** writes a snapshot to the file every interval iterations (0 = only when requested), has to be set before the first worker is created */
+	static void SetCheckpoint(const FString& filename, int32 interval);
+	/** the next iteration boundary writes a snapshot, returns the checkpoint counter before it */
+	static int32 RequestCheckpoint();
+	static int32 GetCheckpointCounter() { return s_checkpointCounter.GetValue(); }
+	static bool IsCheckpointEnabled() { return !s_checkpointFilename.IsEmpty(); }
+	/** the iteration log is written by the worker which finishes an iteration, nullptr disables it */
+	static void SetIterationLog(ACOIterationLog* iterationLog) { s_iterationLog = iterationLog; }
+	/** the pheromone field is published by the worker which finishes an iteration, nullptr disables it */
+	static void SetSharedMemoryExport(ACOSharedMemoryExport* sharedMemoryExport) { s_sharedMemoryExport = sharedMemoryExport; }
+	/** the route query service gets the pheromone field from the worker which finishes an iteration, nullptr disables it */
+	static void SetRouteQueryService(ACORouteQueryService* routeQueryService) { s_routeQueryService = routeQueryService; }
+	/** the worker which finishes an iteration re-coarsens the pheromone field, nullptr disables it */
+	static void SetMultiLevel(ACOMultiLevel* multiLevel) { s_multiLevel = multiLevel; }
+	/** every interval iterations the ants are sorted along the curve of the partition, so the ants of a worker stay close together, 0 disables it */
+	static void SetAntMigration(const TArray<int32>& cellRanks, int32 interval);
+	/** continue the iteration count of a restored snapshot */
+	static void SetIterationCounter(int32 iteration) { s_iterationCounter = iteration; }
+	/** finished iterations, only changes at the last barrier of an iteration */
+	static int32 GetIterationCounter() { return s_iterationCounter; }
 protected:
 	FRandomStream m_randomStream;
 
 	/** Thread to run the worker FRunnable on */
 	FRunnableThread* Thread;
-	/** Stop this thread? Uses Thread Safe Counter */
-	FThreadSafeCounter StopTaskCounter;	
-	
+
 	// thread safe variables
 	FString m_name;
 	static int s_workerCount;
@@ -50,30 +90,79 @@ protected:
 	static TArray<FScopedEvent*> s_waitEvents;
 	static FCriticalSection s_criticalWaitSection;
 
+	int32 m_workerIndex;
+	/** timings of the current iteration, only collected if the ACOTrace is enabled */
+	ACOIterationTrace m_trace;
+
 	//ACO variables
-	std::vector<Ant*> m_ants;
-	TArray<AHexagon*> m_hexagons;
-
-	//ACO constants
-	static float s_traversePhaseConstantA;
-	static float s_traversePhaseConstantB;
-	static float s_evaporationCoefficentP;
-	
+	/** tile of the ACOSpatialPartition */
+	TArray<FIntPoint> m_cellRanges;
+	/** ants of s_colonies[i] handled by this worker */
+	TArray<FIntPoint> m_antRanges;
+	ACOTripStatistics m_tripStatistics;
+
 	//ACO functions
+	/** runs the phase and waits for the other workers, both are timed, false if the workers are stopping */
+	bool runPhase(void (ACOWorker::*phase)(), EACOPhase phaseId, TStatId phaseStatId, TStatId barrierStatId);
 	void traversePhase();
 	void markPhase();
 	void evaporatePhase();
 
-	/** wait for completion of other threads */
-	static void waitForAllWorkers();
+	/** wait for completion of other threads, false if the workers are stopping */
+	static bool waitForAllWorkers();
+	/** waits while the workers are paused, false if they are stopping */
+	static bool passControlPoint();
+	/** waits up to the seconds, returns early on a pause or stop request */
+	static void sleep(float seconds);
 
-	/** function execution by just one worker */
+	/** the first worker which calls it updates the shared state, the other ones return at once */
 	void updateThingsByOneWorker();
 
+	//shared by all workers
+	static ACOGrid* s_grid;
+	static ACOPheromoneField* s_pheromoneField;
+	static TArray<ACOColony*> s_colonies;
+	/** parameters of s_colonies[i], all colonies use the same variant */
+	static TArray<ACOParameters> s_channelParameters;
+	/** one tracker per colony, updated by one worker */
+	static TArray<ACOConvergenceTracker> s_convergenceTrackers;
+	static ACOConvergenceCriteria s_convergenceCriteria;
+	static bool s_hasConverged;
+	static FString s_checkpointFilename;
+	static int32 s_checkpointInterval;
+	static bool s_isCheckpointRequested;
+	static FThreadSafeCounter s_checkpointCounter;
+	static ACOIterationLog* s_iterationLog;
+	static ACOSharedMemoryExport* s_sharedMemoryExport;
+	static ACORouteQueryService* s_routeQueryService;
+	static ACOMultiLevel* s_multiLevel;
+	/** ACOSpatialPartition::GetCellRanks */
+	static TArray<int32> s_antMigrationCellRanks;
+	static int32 s_antMigrationInterval;
+
+	/** captures the state at the iteration boundary, the iteration stalls for the copy, see ACOSnapshot::Capture, the file is written on another thread */
+	static void writeCheckpoint();
+
+	//cooperative pause and stop
+	static FThreadSafeBool s_isPaused;
+	static FThreadSafeBool s_isStopping;
+	/** workers which wait at a control point, at a barrier or have left Run */
+	static FThreadSafeCounter s_parkedWorkers;
+	/** triggered while the workers shouldn't sleep */
+	static FEvent* s_controlEvent;
+	/** triggered while the workers aren't paused */
+	static FEvent* s_resumeEvent;
+	/** ants and cells a worker moves or evaporates between two control points */
+	static const int32 AntSlice = 256;
+	static const int32 CellSlice = 4096;
+
 	//other statics
 	static int s_iterationCounter;
-	static bool s_updateByOneWorker;
-	static class AHexagon* s_anthill;
-	static std::vector<class AHexagon*> s_pathHexagons;
+	/** set at the start of an iteration, the worker which resets it does the update */
+	static FThreadSafeBool s_updateByOneWorker;
+	/** cells and their food source state of SetFoodSource, applied by the update */
+	static TArray<TPair<int32, bool>> s_pendingFoodSources;
+	/** highlighted best paths, recreated with the first worker of a run */
+	static TUniquePtr<ACOBestPaths> s_bestPaths;
 	static bool s_renderBestPath;
 };
\ No newline at end of file
@@ -3,6 +3,8 @@
 #include "ACO.h"
 #include "GridGenerator.h"
 #include "Hexagon.h"
+#include "ACOGrid.h"
+#include "EngineUtils.h"
 
 #if WITH_EDITOR
 void AGridGenerator::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
@@ -20,6 +22,8 @@ void AGridGenerator::PostEditChangeProperty(FPropertyChangedEvent& PropertyChang
 		}
 		alingHexagons(hexagonActors);
 	}
+	if (PropertyName == GET_MEMBER_NAME_CHECKED(AGridGenerator, BakeGrid) && BakeGrid)
+		bakeGrid();
 
 	Super::PostEditChangeProperty(PropertyChangedEvent);
 }
@@ -50,3 +54,17 @@ void AGridGenerator::alingHexagons(TArray<AActor*> hexagonActors) const
 		}
 	}
 }
+
+void AGridGenerator::bakeGrid() const
+{
+	TArray<AHexagon*> hexagons;
+	for (TActorIterator<AHexagon> it(GetWorld()); it; ++it)
+		hexagons.Add(*it);
+	if (hexagons.Num() == 0)
+	{
+		UE_LOG(LogACO, Warning, TEXT("There are no hexagons to bake!"));
+		return;
+	}
+	//the editor world has no overlaps, the neighbours are derived from the coordinates
+	ACOGrid::CreateFromHexagons(hexagons, false).SaveBaked(ACOGrid::GetBakedFilename(GetWorld()));
+}
@@ -20,10 +20,14 @@ class ACO_API AGridGenerator : public AActor
 		TSubclassOf<AActor> HexagonBP;
 	UPROPERTY(EditAnywhere)
 		bool CreateGrid;
+	/** writes the ACOGrid of the hexagons in the level to ACOGrid::GetBakedFilename, ACO loads it instead of querying the overlaps */
+	UPROPERTY(EditAnywhere)
+		bool BakeGrid;
 public:
 	// Sets default values for this actor's properties
 	AGridGenerator();
 
 private:
 	void alingHexagons(TArray<AActor*> hexagonActors) const;
+	void bakeGrid() const;
 };
@@ -2,6 +2,7 @@
 
 #include "ACO.h"
 #include "Hexagon.h"
+#include "ACOStats.h"
 #include <limits>
 #include <string>
 #include "Components/TextRenderComponent.h"
@@ -60,8 +61,6 @@ void AHexagon::BeginPlay()
 {
 	Super::BeginPlay();
 
-	findNeighbourHexagons();
-
 	//create own materialinstance for hexagons
 	m_dynamicMaterial = HexagonMeshComponent->CreateDynamicMaterialInstance(0, BaseMaterial);
 	m_pheromoneDynamicMaterial = PheromoneMeshComponent->CreateDynamicMaterialInstance(0, BaseMaterial);
@@ -101,7 +100,7 @@ float AHexagon::GetPheromoneLevel() const
 
 void AHexagon::SetPheromoneLevel(float pheromones)
 {
-	FScopeLock lock(&m_criticalPheromoneSection);
+	ACOScopeLock lock(&m_criticalPheromoneSection, EACOLock::Pheromone);
 	m_pheromoneLevel = pheromones;
 	m_hasPheromones = m_pheromoneLevel > std::numeric_limits<float>::epsilon();
 	if (m_pheromoneLevel < std::numeric_limits<float>::epsilon())
@@ -110,17 +109,6 @@ void AHexagon::SetPheromoneLevel(float pheromones)
 	}
 }
 
-float AHexagon::GetCapturedPheromoneLevel() const
-{
-	return m_capturedPheromoneLevel;
-}
-
-void AHexagon::CapturePheromoneLevel()
-{
-	FScopeLock lock(&m_criticalPheromoneSection);
-	m_capturedPheromoneLevel = m_pheromoneLevel;
-}
-
 void AHexagon::SetIsAPath(bool val)
 {
 	if (val)
@@ -155,21 +143,11 @@ bool AHexagon::IsWalkable() const
 	return static_cast<int>(TerrainType) != 0;
 }
 
-//per ant in worker
-void AHexagon::AddPheromones(float cost)
-{
-	{
-		FScopeLock lock(&m_criticalPheromoneSection);
-		m_previouslyAddedPheromones += cost;
-	}
-	SetPheromoneLevel(m_pheromoneLevel + cost);
-}
-
 //per hexagon in worker
 void AHexagon::UpdatePheromoneVisualization()
 {
 	static float maxPhero = 0;
-	FScopeLock lock(&m_criticalPheromoneSection);
+	ACOScopeLock lock(&m_criticalPheromoneSection, EACOLock::Pheromone);
 	if (m_hasPheromones)
 	{
 		maxPhero = maxPhero < s_maxGlobalPheromoneLevel ? s_maxGlobalPheromoneLevel : maxPhero;
@@ -185,7 +163,7 @@ void AHexagon::UpdateMaxPheromonesOnTheMap()
 	//track max pheromone level
 	if (m_pheromoneLevel > s_maxGlobalPheromoneLevel)
 	{
-		FScopeLock lock(&m_criticalPheromoneSection);
+		ACOScopeLock lock(&m_criticalPheromoneSection, EACOLock::Pheromone);
 		s_maxGlobalPheromoneLevel = m_pheromoneLevel;
 	}
 }
@@ -233,20 +211,25 @@ bool AHexagon::IsFoodSource() const
 	return m_isFoodSource;
 }
 
-float AHexagon::GetPreviouslyAddedPheromonesAndResetVar()
+ETerrainType AHexagon::GetTerrainType() const
 {
-	float val = m_previouslyAddedPheromones;
-	m_previouslyAddedPheromones = 0.0f;
-	return val;
+	return TerrainType;
 }
 
-ETerrainType AHexagon::GetTerrainType() const
+void AHexagon::SetTerrainType(ETerrainType type)
 {
-	return TerrainType;
+	TerrainType = type;
+	setTerrainSpecifics(TerrainType);
 }
 
 TArray<AHexagon*>& AHexagon::GetNeighbourHexagons()
 {
+	//the overlap queries are slow on large levels, a baked grid doesn't need them at all
+	if (!m_hasFoundNeighbours)
+	{
+		findNeighbourHexagons();
+		m_hasFoundNeighbours = true;
+	}
 	return m_neighbourHexagons;
 }
 
@@ -68,14 +68,11 @@ public:
 	float GetTerrainCost() const;
 	float GetPheromoneLevel() const;
 	void SetPheromoneLevel(float pheromones);
-	float GetCapturedPheromoneLevel() const;
-	void CapturePheromoneLevel();
 	void SetIsAPath(bool val);
 	void SetColor(FColor color, float emission = 0);
 	void SetTerrainColor();
 	void SetFoodSource(bool yesOrNo);
 	bool IsWalkable() const;
-	void AddPheromones(float cost);
 	void UpdatePheromoneVisualization();
 	void UpdateMaxPheromonesOnTheMap();
 	static void ResetMaxPheromonesOnTheMap();
@@ -86,8 +83,10 @@ public:
 	void ShowPheromoneLevel(bool val);
 	void ToggleShowPheromonoLevel();
 	bool IsFoodSource() const;
-	float GetPreviouslyAddedPheromonesAndResetVar();
 	ETerrainType GetTerrainType() const;
+	/** changes the terrain at runtime, the ACOGrid of running workers is changed by ACOWorker::SetTerrainType */
+	void SetTerrainType(ETerrainType type);
+	/** the neighbours are searched on the first call, only from the game thread */
 	TArray<AHexagon*>& GetNeighbourHexagons();
 
 private:
@@ -97,6 +96,7 @@ private:
 
 	//other
 	TArray<AHexagon*> m_neighbourHexagons;
+	bool m_hasFoundNeighbours = false;
 	bool m_isFoodSource = false;
 
 	//materials
@@ -110,8 +110,6 @@ private:
 	float m_pheromoneLevel = 0;
 	bool m_hasPheromones = true;
 	bool m_showPheromoneLevel = false;
-	float m_previouslyAddedPheromones = 0.f;
-	float m_capturedPheromoneLevel = 0.f;
 	float m_elapsedWaitTimeForPheromoneVisualization = 0;
 	static float s_maxGlobalPheromoneLevel;
 
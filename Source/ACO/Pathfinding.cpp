@@ -57,3 +57,51 @@ float Pathfinding::AStarSearchHeuristic(AHexagon* start, AHexagon* goal)
 	float manhattan = FVector::Dist(start->GetActorLocation(), goal->GetActorLocation()) / 10;
 	return manhattan;
 }
+
+void Pathfinding::AStarSearch(const ACOGrid& grid, const ACOPheromoneField& pheromoneField, int32 channel, int32 start, int32 goal, std::unordered_map<int32, int32>& came_from)
+{
+	const float maxPheromoneLevel = pheromoneField.GetMaxPheromoneLevel(channel);
+	std::unordered_map<int32, float> cost_so_far;
+	std::priority_queue<std::pair<float, int32>, std::vector<std::pair<float, int32>>, std::greater<std::pair<float, int32>>> open;
+	open.emplace(0, start);
+
+	came_from[start] = start; // = closed list!
+	cost_so_far[start] = 0;
+
+	while (!open.empty())
+	{
+		int32 currentItemWithBestCost = open.top().second;
+		open.pop();
+
+		if (currentItemWithBestCost == goal)
+			break;
+
+		for (const int32* next = grid.GetNeighboursBegin(currentItemWithBestCost); next != grid.GetNeighboursEnd(currentItemWithBestCost); ++next)
+		{
+			//same as AHexagon::GetPheromoneAStarCost
+			float new_cost = cost_so_far[currentItemWithBestCost] + maxPheromoneLevel - pheromoneField.GetPheromoneLevel(*next, channel);
+			if (!cost_so_far.count(*next) || new_cost < cost_so_far[*next])
+			{
+				cost_so_far[*next] = new_cost;
+				double overallCost = new_cost + grid.GetDistanceHeuristic(start, goal);
+				open.emplace(overallCost, *next);
+				came_from[*next] = currentItemWithBestCost;
+			}
+		}
+	}
+}
+
+std::vector<int32> Pathfinding::ReconstructPath(int32 start, int32 goal, const std::unordered_map<int32, int32>& came_from, bool shouldBeSortedStartToEnd)
+{
+	std::vector<int32> path;
+	int32 current = goal;
+	path.push_back(current);
+	while (current != start)
+	{
+		current = came_from.at(current);
+		path.push_back(current);
+	}
+	if (shouldBeSortedStartToEnd)
+		std::reverse(path.begin(), path.end());
+	return path;
+}
@@ -3,6 +3,8 @@
 #pragma once
 #include <unordered_map>
 #include "Hexagon.h"
+#include "ACOGrid.h"
+#include "ACOPheromoneField.h"
 
 /**
  * 
@@ -13,4 +15,8 @@ public:
 	static void AStarSearch(AHexagon* start, AHexagon* goal, std::unordered_map<AHexagon*, AHexagon*>& came_from);
 	static std::vector<AHexagon*> ReconstructPath(AHexagon* start, AHexagon* goal, std::unordered_map<AHexagon*, AHexagon*> came_from, bool shouldBeSortedStartToEnd = false);
 	static float AStarSearchHeuristic(AHexagon* start, AHexagon* goal);
+
+	/** same search on grid cells, the costs are taken from one channel of the pheromone field */
+	static void AStarSearch(const ACOGrid& grid, const ACOPheromoneField& pheromoneField, int32 channel, int32 start, int32 goal, std::unordered_map<int32, int32>& came_from);
+	static std::vector<int32> ReconstructPath(int32 start, int32 goal, const std::unordered_map<int32, int32>& came_from, bool shouldBeSortedStartToEnd = false);
 };
\ No newline at end of file
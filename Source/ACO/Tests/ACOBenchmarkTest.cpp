@@ -0,0 +1,127 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ACO.h"
+#include "ACOBenchmark.h"
+#include "ACOWorker.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	/**
+	 * small maps, so the tests finish in seconds. The baseline of a machine is written by the commandlet with the same options:
+	 * -run=ACOBenchmark <options> -Baseline=Saved/ACO/BenchmarkTestBaseline.csv -UpdateBaseline
+	 */
+	const TCHAR* BenchmarkOptions = TEXT("-Maps=200x200 -Threads=1,4 -Ants=2000 -Scaling=Strong,Weak -WeakCells=20000 -WeakAnts=500 -Repetitions=3 -Warmup=5 -PoolIterations=5");
+
+	/** -ACOBenchmarkBaseline=<file> of the command line or the default baseline of the tests */
+	FString getBaselineFilename()
+	{
+		FString filename = FPaths::GameSavedDir() / TEXT("ACO/BenchmarkTestBaseline.csv");
+		FParse::Value(FCommandLine::Get(), TEXT("-ACOBenchmarkBaseline="), filename);
+		return filename;
+	}
+}
+
+/** one test per benchmark, a benchmark fails if it measures nothing or regressed compared to the baseline of the machine */
+IMPLEMENT_COMPLEX_AUTOMATION_TEST(FACOBenchmarkTest, "ACO.Benchmark", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+void FACOBenchmarkTest::GetTests(TArray<FString>& OutBeautifiedNames, TArray<FString>& OutTestCommands) const
+{
+	for (int32 i = 0; i < static_cast<int32>(EACOBenchmark::Num); ++i)
+	{
+		OutBeautifiedNames.Add(ACOBenchmark::GetBenchmarkName(static_cast<EACOBenchmark>(i)));
+		OutTestCommands.Add(ACOBenchmark::GetBenchmarkName(static_cast<EACOBenchmark>(i)));
+	}
+}
+
+bool FACOBenchmarkTest::RunTest(const FString& Parameters)
+{
+	ACOBenchmark benchmark;
+	if (!TestTrue(TEXT("Valid benchmark options"), benchmark.Parse(*FString::Printf(TEXT("%s -Benchmarks=%s"), BenchmarkOptions, *Parameters))))
+		return false;
+	benchmark.Run();
+
+	TestTrue(TEXT("Benchmark has results"), benchmark.GetResults().Num() > 0);
+	for (const ACOBenchmarkResult& result : benchmark.GetResults())
+	{
+		TestTrue(FString::Printf(TEXT("%s with %d cells and %d threads measured a throughput"), *Parameters, result.Cells, result.Threads), result.Throughput > 0.0);
+	}
+
+	//without a baseline the benchmark is only measured
+	const FString baseline = getBaselineFilename();
+	if (!FPaths::FileExists(baseline))
+	{
+		AddWarning(FString::Printf(TEXT("No benchmark baseline %s, the throughput isn't gated"), *baseline));
+		return true;
+	}
+	TestTrue(FString::Printf(TEXT("%s within its tolerance of %s"), *Parameters, *baseline), benchmark.CompareWithBaseline(baseline));
+	return true;
+}
+
+/** runs the ACOWorker pool like the game does, all colonies have to finish every iteration together and the pool has to stop on request */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FACOWorkerPoolTest, "ACO.WorkerPool.Iterations", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FACOWorkerPoolTest::RunTest(const FString& Parameters)
+{
+	const int32 iterations = 50;
+	const int32 workerAmount = 4;
+	ACOGrid grid = ACOGrid::CreateGenerated(FIntPoint(64, 64), 1, 3, 2);
+	if (!TestTrue(TEXT("Map has anthills and food sources"), grid.Anthills.Num() == 2 && grid.FoodSources.Num() > 0))
+		return false;
+
+	ACOParameters parameters;
+	parameters.AntAmount = 500;
+	ACOPheromoneField pheromoneField(grid.Num(), grid.Anthills.Num(), parameters.PheromoneStorage, parameters.Deterministic);
+	TArray<TUniquePtr<ACOColony>> colonies;
+	TArray<ACOColony*> colonyPointers;
+	for (int32 channel = 0; channel < grid.Anthills.Num(); ++channel)
+	{
+		colonies.Emplace(new ACOColony(grid, pheromoneField, channel, grid.Anthills[channel], parameters));
+		colonyPointers.Add(colonies.Last().Get());
+	}
+
+	const bool isShowingBestPath = ACOWorker::IsShowingBestPath();
+	ACOWorker::SetShowBestPath(true);
+	ACOWorker::SetIterationCounter(0);
+	TArray<TUniquePtr<ACOWorker>> workers;
+	for (int32 worker = 0; worker < workerAmount; ++worker)
+	{
+		TArray<FIntPoint> cellRanges;
+		TArray<FIntPoint> antRanges;
+		cellRanges.Add(FIntPoint(grid.Num() * worker / workerAmount, grid.Num() * (worker + 1) / workerAmount));
+		for (int32 i = 0; i < colonies.Num(); ++i)
+			antRanges.Add(FIntPoint(parameters.AntAmount * worker / workerAmount, parameters.AntAmount * (worker + 1) / workerAmount));
+		workers.Emplace(new ACOWorker(grid, pheromoneField, colonyPointers, cellRanges, antRanges));
+	}
+
+	const double startTime = FPlatformTime::Seconds();
+	while (ACOWorker::GetIterationCounter() < iterations && FPlatformTime::Seconds() - startTime < 60.0)
+		FPlatformProcess::Sleep(0.001f);
+	const double seconds = FPlatformTime::Seconds() - startTime;
+
+	//the colonies only change at the barriers, so a paused pool has finished the same iteration everywhere
+	ACOWorker::PauseAll();
+	const int32 finishedIterations = ACOWorker::GetIterationCounter();
+	for (const ACOColony* colony : colonyPointers)
+	{
+		TestEqual(TEXT("Colony finished every iteration of the pool"), colony->GetIterationCounter(), finishedIterations);
+		TestTrue(TEXT("Colony found food"), colony->GetBestTripCost() < MAX_FLT);
+	}
+	ACOWorker::ResumeAll();
+
+	const double stopTime = FPlatformTime::Seconds();
+	ACOWorker::RequestStop();
+	workers.Reset();
+	const double stopSeconds = FPlatformTime::Seconds() - stopTime;
+	ACOWorker::ReleaseBestPaths();
+	ACOWorker::SetShowBestPath(isShowingBestPath);
+
+	TestTrue(FString::Printf(TEXT("%d of %d iterations within 60s"), finishedIterations, iterations), finishedIterations >= iterations);
+	TestTrue(FString::Printf(TEXT("Workers stopped after %.3fs"), stopSeconds), stopSeconds < 1.0);
+	AddInfo(FString::Printf(TEXT("%d iterations of %d workers in %.3fs"), finishedIterations, workerAmount, seconds));
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,65 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ACO.h"
+#include "ACOGrid.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+ * ACOGrid::SetTerrainType repairs the anthill distances with ACODistanceField::UpdateTerrainCost, the repaired fields have to be the
+ * ones a fresh Build finds on the edited grid. The terrain costs are integers, so the costs of equally cheap routes are exactly equal.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FACODistanceFieldTest, "ACO.DistanceField.TerrainEdits", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FACODistanceFieldTest::RunTest(const FString& Parameters)
+{
+	static const ETerrainType walkableTypes[] = { ETerrainType::TT_Street, ETerrainType::TT_Grass, ETerrainType::TT_Sand, ETerrainType::TT_Mud, ETerrainType::TT_Water };
+
+	ACOGrid grid = ACOGrid::CreateGenerated(FIntPoint(64, 64), 1, 3, 2);
+	if (!TestTrue(TEXT("Map has two anthills with distances"), grid.Anthills.Num() == 2 && grid.AnthillDistances.Num() == 2))
+		return false;
+
+	FRandomStream randomStream(1);
+	const int32 edits = 2000;
+	int32 changedCells = 0;
+	for (int32 edit = 1; edit <= edits; ++edit)
+	{
+		//mountains and anthills are refused, they would change the neighbours
+		const int32 cell = randomStream.RandHelper(grid.Num());
+		const ETerrainType type = walkableTypes[randomStream.RandHelper(ARRAY_COUNT(walkableTypes))];
+		const bool isEditable = grid.IsWalkable(cell) && !grid.IsAnthill(cell);
+		const bool isChanged = grid.GetTerrainCost(cell) != static_cast<float>(type);
+		if (!TestEqual(TEXT("Only walkable terrain can be edited"), grid.SetTerrainType(cell, type), isEditable))
+			return false;
+		changedCells += isEditable && isChanged ? 1 : 0;
+		if (edit % 50 != 0)
+			continue;
+
+		for (const ACODistanceField& distances : grid.AnthillDistances)
+		{
+			ACODistanceField builtDistances;
+			builtDistances.Build(grid, distances.Source);
+			int32 mismatches = 0;
+			for (int32 i = 0; i < grid.Num(); ++i)
+			{
+				if ((distances.Costs[i] != builtDistances.Costs[i] || distances.Steps[i] != builtDistances.Steps[i]) && mismatches++ == 0)
+				{
+					AddError(FString::Printf(TEXT("Edit %d anthill %d cell %d: repaired cost %f steps %d, built cost %f steps %d"), edit, distances.Source, i,
+						distances.Costs[i], distances.Steps[i], builtDistances.Costs[i], builtDistances.Steps[i]));
+				}
+			}
+			if (mismatches > 0)
+			{
+				AddError(FString::Printf(TEXT("%d cells of anthill %d differ from the built distances after %d edits"), mismatches, distances.Source, edit));
+				return false;
+			}
+		}
+	}
+
+	TestTrue(TEXT("Terrain costs were changed"), changedCells > 0);
+	AddInfo(FString::Printf(TEXT("%d cells changed by %d edits"), changedCells, edits));
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
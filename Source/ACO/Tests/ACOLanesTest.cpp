@@ -0,0 +1,82 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ACO.h"
+#include "ACOPolicies.h"
+#include "ACOLanes.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/** ACOScalarLanes and ACOVectorLanes have to choose the same slot as ACOPolicies::SelectProportional on the visitable neighbours of every lane */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FACOLanesTest, "ACO.Lanes.SelectProportional", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FACOLanesTest::RunTest(const FString& Parameters)
+{
+	//8M lanes
+	const int32 selections = 2 * 1024 * 1024;
+	const int32 values = ACOLanes::Slots * ACOLanes::Width;
+	FRandomStream randomStream(1);
+	int32 comparedLanes = 0;
+	int32 scalarMismatches = 0;
+	int32 vectorMismatches = 0;
+
+	for (int32 selection = 0; selection < selections; ++selection)
+	{
+		//a third of the neighbours can't be visited, the weights span a few orders of magnitude like the levels of a trail
+		float pheromoneWeights[values];
+		float terrainWeights[values];
+		float uniforms[ACOLanes::Width];
+		for (int32 i = 0; i < values; ++i)
+		{
+			pheromoneWeights[i] = randomStream.FRand() < 0.33f ? 0.f : FMath::Pow(10.f, randomStream.FRandRange(-3.f, 3.f));
+			terrainWeights[i] = FMath::Pow(10.f, randomStream.FRandRange(-2.f, 1.f));
+		}
+		//draws at the ends of [0, 1) hit the first and the last visitable slot
+		for (int32 lane = 0; lane < ACOLanes::Width; ++lane)
+		{
+			const float draw = randomStream.FRand();
+			uniforms[lane] = draw < 0.05f ? 0.99999994f : draw < 0.1f ? 0.f : randomStream.FRand();
+		}
+
+		int32 scalarSlots[ACOLanes::Width];
+		int32 vectorSlots[ACOLanes::Width];
+		ACOScalarLanes::SelectProportional(pheromoneWeights, terrainWeights, uniforms, scalarSlots);
+		ACOVectorLanes::SelectProportional(pheromoneWeights, terrainWeights, uniforms, vectorSlots);
+
+		for (int32 lane = 0; lane < ACOLanes::Width; ++lane)
+		{
+			//the per ant path only sees the visitable neighbours, in slot order
+			float weights[ACOLanes::Slots];
+			int32 candidates[ACOLanes::Slots];
+			int32 amount = 0;
+			float weightSum = 0.f;
+			for (int32 slot = 0; slot < ACOLanes::Slots; ++slot)
+			{
+				const int32 index = slot * ACOLanes::Width + lane;
+				if (pheromoneWeights[index] <= 0.f)
+					continue;
+				weights[amount] = pheromoneWeights[index] * terrainWeights[index];
+				candidates[amount] = slot;
+				weightSum += weights[amount];
+				++amount;
+			}
+			//an ant without a visitable neighbour doesn't choose
+			if (amount == 0)
+				continue;
+
+			const int32 expectedSlot = candidates[ACOPolicies::SelectProportional(weights, amount, weightSum, uniforms[lane])];
+			++comparedLanes;
+			if (scalarSlots[lane] != expectedSlot && scalarMismatches++ == 0)
+				AddError(FString::Printf(TEXT("ACOScalarLanes chose slot %d instead of %d in selection %d lane %d"), scalarSlots[lane], expectedSlot, selection, lane));
+			if (vectorSlots[lane] != expectedSlot && vectorMismatches++ == 0)
+				AddError(FString::Printf(TEXT("ACOVectorLanes chose slot %d instead of %d in selection %d lane %d"), vectorSlots[lane], expectedSlot, selection, lane));
+		}
+	}
+
+	TestEqual(TEXT("ACOScalarLanes mismatches"), scalarMismatches, 0);
+	TestEqual(TEXT("ACOVectorLanes mismatches"), vectorMismatches, 0);
+	AddInfo(FString::Printf(TEXT("%d lanes compared"), comparedLanes));
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
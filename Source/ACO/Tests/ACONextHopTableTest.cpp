@@ -0,0 +1,161 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ACO.h"
+#include "ACONextHopTable.h"
+#include "ACOGrid.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	const FIntPoint MapSize(48, 48);
+	/** the cells right of the mountain column can't reach an anthill or a food source */
+	const int32 WallColumn = 36;
+	const int32 Channels = 2;
+	const float ReferenceLevel = 1.f;
+
+	/** random terrain with a mountain column, an anthill per channel and three food sources left of the column */
+	ACOGrid createGrid(FRandomStream& randomStream)
+	{
+		static const ETerrainType walkableTypes[] = { ETerrainType::TT_Street, ETerrainType::TT_Grass, ETerrainType::TT_Sand, ETerrainType::TT_Mud, ETerrainType::TT_Water };
+
+		TArray<ETerrainType> terrainTypes;
+		terrainTypes.SetNumUninitialized(MapSize.X * MapSize.Y);
+		for (int32 y = 0; y < MapSize.Y; ++y)
+		{
+			for (int32 x = 0; x < MapSize.X; ++x)
+			{
+				ETerrainType& type = terrainTypes[y * MapSize.X + x];
+				type = walkableTypes[randomStream.RandHelper(ARRAY_COUNT(walkableTypes))];
+				if (x == WallColumn || randomStream.FRand() < 0.1f)
+					type = ETerrainType::TT_Mountain;
+			}
+		}
+		for (int32 channel = 0; channel < Channels; ++channel)
+			terrainTypes[MapSize.Y / 2 * MapSize.X + WallColumn * (channel + 1) / (Channels + 1)] = ETerrainType::TT_Anthill;
+
+		TArray<int32> foodSources;
+		while (foodSources.Num() < 3)
+		{
+			const int32 cell = randomStream.RandRange(0, MapSize.Y - 1) * MapSize.X + randomStream.RandRange(0, WallColumn - 1);
+			if (terrainTypes[cell] != ETerrainType::TT_Mountain && terrainTypes[cell] != ETerrainType::TT_Anthill)
+				foodSources.AddUnique(cell);
+		}
+		return ACOGrid::CreateFromTerrain(MapSize, MoveTemp(terrainTypes), foodSources);
+	}
+
+	/** same cost as ACONextHopTable */
+	float getCost(float pheromoneLevel)
+	{
+		return 1.f / (1.f + pheromoneLevel / ReferenceLevel);
+	}
+
+	bool isNeighbour(const ACOGrid& grid, int32 cell, int32 neighbour)
+	{
+		for (const int32* i = grid.GetNeighboursBegin(cell); i != grid.GetNeighboursEnd(cell); ++i)
+		{
+			if (*i == neighbour)
+				return true;
+		}
+		return false;
+	}
+
+	bool isNearlyEqualDistance(float a, float b)
+	{
+		return a == b || FMath::Abs(a - b) <= 1e-5f * FMath::Max(1.f, FMath::Max(a, b));
+	}
+}
+
+/**
+ * ACONextHopTable repairs its shortest path trees after the pheromone levels changed, the repaired trees have to be the ones a fresh
+ * table builds from the same levels. Trails are laid, evaporated and moved on a random map, the cells behind a mountain column stay unreachable.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FACONextHopTableTest, "ACO.NextHopTable.Repair", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FACONextHopTableTest::RunTest(const FString& Parameters)
+{
+	FRandomStream randomStream(1);
+	const ACOGrid grid = createGrid(randomStream);
+	if (!TestTrue(TEXT("Map has an anthill per channel and food sources"), grid.Anthills.Num() == Channels && grid.FoodSources.Num() == 3))
+		return false;
+	const int32 cells = grid.Num();
+
+	//trails on a third of the cells, the channels of a cell are next to each other
+	TArray<float> pheromoneLevels;
+	pheromoneLevels.SetNumZeroed(cells * Channels);
+	for (float& level : pheromoneLevels)
+		level = randomStream.FRand() < 0.33f ? randomStream.FRandRange(0.f, 4.f * ReferenceLevel) : 0.f;
+
+	//every change is repaired
+	ACONextHopTable repairedTable(grid, ReferenceLevel);
+	repairedTable.SetTolerance(0.f);
+	repairedTable.Update(pheromoneLevels, Channels);
+
+	const int32 rounds = 30;
+	int32 repairedCells = 0;
+	for (int32 round = 0; round < rounds; ++round)
+	{
+		//cheaper cells where trails are laid, more expensive ones where they evaporate, both in the third round
+		const bool isDecreasingCosts = round % 3 != 1;
+		const bool isIncreasingCosts = round % 3 != 0;
+		for (float& level : pheromoneLevels)
+		{
+			if (randomStream.FRand() >= 0.1f)
+				continue;
+			if (isDecreasingCosts && (!isIncreasingCosts || randomStream.FRand() < 0.5f))
+				level += randomStream.FRandRange(0.f, 2.f * ReferenceLevel);
+			else
+				level = randomStream.FRand() < 0.5f ? 0.f : level * randomStream.FRand();
+		}
+
+		repairedTable.Update(pheromoneLevels, Channels);
+		repairedCells += repairedTable.GetChangedCellAmount();
+		ACONextHopTable builtTable(grid, ReferenceLevel);
+		builtTable.Update(pheromoneLevels, Channels);
+
+		int32 mismatches = 0;
+		for (int32 channel = 0; channel < Channels; ++channel)
+		{
+			for (EACORouteTarget target : { EACORouteTarget::Food, EACORouteTarget::Anthill })
+			{
+				for (int32 cell = 0; cell < cells; ++cell)
+				{
+					const float distance = repairedTable.GetDistance(cell, channel, target);
+					const float builtDistance = builtTable.GetDistance(cell, channel, target);
+					const int32 nextHop = repairedTable.GetNextHop(cell, channel, target);
+					const int32 builtNextHop = builtTable.GetNextHop(cell, channel, target);
+
+					//routes of the same cost may take another neighbour, the repaired one has to lead to the target as cheaply
+					bool isMatching = isNearlyEqualDistance(distance, builtDistance);
+					if (isMatching && nextHop != builtNextHop)
+					{
+						isMatching = nextHop != INDEX_NONE && builtNextHop != INDEX_NONE
+							&& isNeighbour(grid, cell, nextHop)
+							&& isNearlyEqualDistance(builtTable.GetDistance(nextHop, channel, target) + getCost(pheromoneLevels[nextHop * Channels + channel]), builtDistance);
+					}
+					if (!isMatching && mismatches++ == 0)
+					{
+						AddError(FString::Printf(TEXT("Round %d channel %d target %d cell %d: repaired distance %f next hop %d, built distance %f next hop %d"),
+							round, channel, static_cast<int32>(target), cell, distance, nextHop, builtDistance, builtNextHop));
+					}
+					if (grid.Coordinates[cell].X > WallColumn)
+					{
+						TestTrue(TEXT("Cell behind the mountains can't reach the target"), distance == MAX_FLT && nextHop == INDEX_NONE);
+					}
+				}
+			}
+		}
+		if (mismatches > 0)
+		{
+			AddError(FString::Printf(TEXT("%d cells of round %d differ from the built tables"), mismatches, round));
+			return false;
+		}
+	}
+
+	TestTrue(TEXT("Cells were repaired"), repairedCells > 0);
+	AddInfo(FString::Printf(TEXT("%d repaired cells in %d rounds"), repairedCells, rounds));
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
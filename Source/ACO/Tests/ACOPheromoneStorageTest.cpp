@@ -0,0 +1,91 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ACO.h"
+#include "ACOConvergence.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	const int32 Maps = 4;
+	const int32 Iterations = 400;
+	/** relative deviation of the mean best trip cost of a compact storage from the one of Float */
+	const float BestTripCostTolerance = 0.05f;
+	/** relative deviation of the mean convergence iteration, at least one convergence window */
+	const float ConvergenceTolerance = 0.3f;
+
+	struct StorageRun
+	{
+		float BestTripCost;
+		/** Iterations if the colony didn't converge */
+		int32 ConvergenceIteration;
+	};
+
+	/** one colony like ACOBatchRunner::runJob */
+	StorageRun runColony(const ACOGrid& grid, const ACOParameters& parameters, const ACOConvergenceCriteria& criteria)
+	{
+		ACOPheromoneField pheromoneField(grid.Num(), 1, parameters.PheromoneStorage, parameters.Deterministic);
+		ACOColony colony(grid, pheromoneField, 0, grid.Anthills[0], parameters);
+		ACOConvergenceTracker convergenceTracker(criteria);
+
+		StorageRun run;
+		run.BestTripCost = MAX_FLT;
+		for (int32 iteration = 1; iteration <= Iterations; ++iteration)
+		{
+			run.BestTripCost = FMath::Min(run.BestTripCost, colony.Iterate().BestTripCost);
+			convergenceTracker.Update(colony);
+		}
+		run.ConvergenceIteration = convergenceTracker.HasConverged() ? convergenceTracker.GetConvergenceIteration() : Iterations;
+		return run;
+	}
+}
+
+/**
+ * The compact pheromone storages round the levels, so the ants choose differently than with Float, but they have to find routes
+ * as cheap and converge about as fast. The same colonies run with every storage on a few generated maps, the means are compared.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FACOPheromoneStorageTest, "ACO.PheromoneField.StorageAccuracy", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FACOPheromoneStorageTest::RunTest(const FString& Parameters)
+{
+	const EACOPheromoneStorage storages[] = { EACOPheromoneStorage::Float, EACOPheromoneStorage::Half, EACOPheromoneStorage::Log16 };
+	const ACOConvergenceCriteria criteria;
+	double bestTripCosts[ARRAY_COUNT(storages)] = {};
+	double convergenceIterations[ARRAY_COUNT(storages)] = {};
+
+	for (int32 map = 0; map < Maps; ++map)
+	{
+		const ACOGrid grid = ACOGrid::CreateGenerated(FIntPoint(64, 64), map + 1);
+		if (!TestTrue(TEXT("Map has an anthill and food sources"), grid.Anthills.Num() == 1 && grid.FoodSources.Num() > 0))
+			return false;
+
+		for (int32 i = 0; i < ARRAY_COUNT(storages); ++i)
+		{
+			ACOParameters parameters;
+			parameters.AntAmount = 1000;
+			parameters.Seed = map + 1;
+			parameters.PheromoneStorage = storages[i];
+			const StorageRun run = runColony(grid, parameters, criteria);
+			if (!TestTrue(FString::Printf(TEXT("%s colony on map %d found food"), ACOParameters::GetPheromoneStorageName(storages[i]), map), run.BestTripCost < MAX_FLT))
+				return false;
+			bestTripCosts[i] += run.BestTripCost / Maps;
+			convergenceIterations[i] += static_cast<double>(run.ConvergenceIteration) / Maps;
+		}
+	}
+
+	for (int32 i = 1; i < ARRAY_COUNT(storages); ++i)
+	{
+		const TCHAR* name = ACOParameters::GetPheromoneStorageName(storages[i]);
+		const double costDeviation = FMath::Abs(bestTripCosts[i] - bestTripCosts[0]) / bestTripCosts[0];
+		TestTrue(FString::Printf(TEXT("%s mean best trip cost %.2f within %.0f%% of Float %.2f"), name, bestTripCosts[i], 100.f * BestTripCostTolerance, bestTripCosts[0]),
+			costDeviation <= BestTripCostTolerance);
+
+		const double convergenceSlack = FMath::Max(ConvergenceTolerance * convergenceIterations[0], static_cast<double>(criteria.Window));
+		TestTrue(FString::Printf(TEXT("%s mean convergence iteration %.1f within %.1f of Float %.1f"), name, convergenceIterations[i], convergenceSlack, convergenceIterations[0]),
+			FMath::Abs(convergenceIterations[i] - convergenceIterations[0]) <= convergenceSlack);
+	}
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,63 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ACO.h"
+#include "ACOPolicies.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+ * ACOPolicies::SelectProportional has to choose every slot in proportion to its weight. The counts of many draws are checked
+ * with a chi-square test, a slot without weight must never be chosen and draws just below 1 have to end at the last slot.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FACOSelectProportionalTest, "ACO.Policies.SelectProportional", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FACOSelectProportionalTest::RunTest(const FString& Parameters)
+{
+	//a hexagon has 6 neighbours, the second one can't be visited
+	const float weights[] = { 1.f, 0.f, 2.f, 3.5f, 0.5f, 3.f };
+	const int32 amount = ARRAY_COUNT(weights);
+	float weightSum = 0.f;
+	for (float weight : weights)
+		weightSum += weight;
+
+	const int32 draws = 1000000;
+	int32 counts[amount] = {};
+	FRandomStream randomStream(1);
+	for (int32 draw = 0; draw < draws; ++draw)
+	{
+		const int32 slot = ACOPolicies::SelectProportional(weights, amount, weightSum, randomStream.FRand());
+		if (!TestTrue(TEXT("Slot in range"), slot >= 0 && slot < amount))
+			return false;
+		++counts[slot];
+	}
+
+	double chiSquare = 0.0;
+	int32 weightedSlots = 0;
+	for (int32 slot = 0; slot < amount; ++slot)
+	{
+		if (weights[slot] <= 0.f)
+		{
+			TestEqual(FString::Printf(TEXT("Draws of slot %d without weight"), slot), counts[slot], 0);
+			continue;
+		}
+		const double expected = static_cast<double>(draws) * weights[slot] / weightSum;
+		chiSquare += FMath::Square(counts[slot] - expected) / expected;
+		++weightedSlots;
+	}
+	//the 99.9% quantile of the chi-square distribution with 4 degrees of freedom
+	check(weightedSlots == 5);
+	const double criticalValue = 18.467;
+	TestTrue(FString::Printf(TEXT("Chi-square %.3f of %d draws below %.3f"), chiSquare, draws, criticalValue), chiSquare < criticalValue);
+
+	//the 64 largest uniforms below 1 are 2^-24 apart, the target can round up to the sum of the weights
+	for (int32 i = 1; i <= 64; ++i)
+	{
+		const float uniform = 1.f - i * (FLT_EPSILON * 0.5f);
+		TestEqual(FString::Printf(TEXT("Slot of the uniform %.9f"), uniform), ACOPolicies::SelectProportional(weights, amount, weightSum, uniform), amount - 1);
+	}
+	TestEqual(TEXT("Slot of the uniform 0"), ACOPolicies::SelectProportional(weights, amount, weightSum, 0.f), 0);
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
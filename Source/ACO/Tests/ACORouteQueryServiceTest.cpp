@@ -0,0 +1,191 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ACO.h"
+#include "ACORouteQueryService.h"
+#include "Pathfinding.h"
+#include "Async/Async.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	const int32 Channels = 2;
+
+	/** trails on a third of the cells */
+	void fillPheromones(ACOPheromoneField& pheromoneField, FRandomStream& randomStream)
+	{
+		for (int32 cell = 0; cell < pheromoneField.Num(); ++cell)
+		{
+			for (int32 channel = 0; channel < Channels; ++channel)
+				pheromoneField.SetPheromoneLevel(cell, channel, randomStream.FRand() < 0.33f ? randomStream.FRandRange(0.f, 10.f) : 0.f);
+		}
+	}
+
+	/** cost of the route of Pathfinding::AStarSearch, MAX_FLT if it doesn't reach the goal */
+	float getAStarCost(const ACOGrid& grid, const ACOPheromoneField& pheromoneField, const ACORouteQuery& query)
+	{
+		std::unordered_map<int32, int32> cameFrom;
+		Pathfinding::AStarSearch(grid, pheromoneField, query.Channel, query.Start, query.Goal, cameFrom);
+		if (!cameFrom.count(query.Goal))
+			return MAX_FLT;
+		float cost = 0.f;
+		for (int32 cell : Pathfinding::ReconstructPath(query.Start, query.Goal, cameFrom))
+		{
+			if (cell != query.Start)
+				cost += pheromoneField.GetMaxPheromoneLevel(query.Channel) - pheromoneField.GetPheromoneLevel(cell, query.Channel);
+		}
+		return cost;
+	}
+
+	bool isNeighbour(const ACOGrid& grid, int32 cell, int32 neighbour)
+	{
+		for (const int32* i = grid.GetNeighboursBegin(cell); i != grid.GetNeighboursEnd(cell); ++i)
+		{
+			if (*i == neighbour)
+				return true;
+		}
+		return false;
+	}
+
+	/** the route has to connect start and goal over neighbours and cost as much as the one of A* on the same levels */
+	bool isMatchingAStar(const ACOGrid& grid, const ACOPheromoneField& pheromoneField, const ACORouteQuery& query, const ACORouteResult& result)
+	{
+		const float aStarCost = getAStarCost(grid, pheromoneField, query);
+		if (!result.IsValid())
+			return aStarCost == MAX_FLT;
+		if (aStarCost == MAX_FLT || result.Route[0] != query.Start || result.Route.Last() != query.Goal)
+			return false;
+		for (int32 i = 1; i < result.Route.Num(); ++i)
+		{
+			if (!isNeighbour(grid, result.Route[i - 1], result.Route[i]))
+				return false;
+		}
+		return FMath::Abs(result.Cost - aStarCost) <= 1e-3f * FMath::Max(1.f, aStarCost);
+	}
+}
+
+/**
+ * ACORouteQueryService answers queries on the snapshot of its current epoch. The routes of FindRoute and of the batches of QueryRoute
+ * have to cost as much as the ones of Pathfinding::AStarSearch on the levels of their epoch, the cache only keeps results of the current epoch.
+ * A new epoch is published while batches run on the thread pool, their results belong to either epoch.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FACORouteQueryServiceTest, "ACO.RouteQueryService.Epochs", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FACORouteQueryServiceTest::RunTest(const FString& Parameters)
+{
+	const ACOGrid grid = ACOGrid::CreateGenerated(FIntPoint(48, 48), 1, 3, Channels);
+	if (!TestTrue(TEXT("Map has an anthill per channel"), grid.Anthills.Num() == Channels))
+		return false;
+
+	FRandomStream randomStream(1);
+	ACOPheromoneField firstField(grid.Num(), Channels);
+	ACOPheromoneField secondField(grid.Num(), Channels);
+	ACOPheromoneField thirdField(grid.Num(), Channels);
+	fillPheromones(firstField, randomStream);
+	fillPheromones(secondField, randomStream);
+	fillPheromones(thirdField, randomStream);
+
+	//distinct queries between walkable cells
+	TArray<ACORouteQuery> queries;
+	while (queries.Num() < 64)
+	{
+		const ACORouteQuery query(randomStream.RandHelper(grid.Num()), randomStream.RandHelper(grid.Num()), randomStream.RandHelper(Channels));
+		if (grid.IsWalkable(query.Start) && grid.IsWalkable(query.Goal) && query.Start != query.Goal)
+			queries.AddUnique(query);
+	}
+
+	ACORouteQueryService service(grid, 1.f);
+	service.ParseCommandLine(TEXT("-ACORouteEpochInterval=1 -ACORouteEpochThreshold=0.05"));
+	TestFalse(TEXT("No route before the first epoch"), service.FindRoute(queries[0]).IsValid());
+	service.OnIterationFinished(firstField, 1);
+	TestEqual(TEXT("First epoch"), service.GetEpoch(), 1u);
+
+	//sequential queries are searched once, then cached
+	for (const ACORouteQuery& query : queries)
+	{
+		if (!TestTrue(TEXT("Sequential route of the first epoch matches A*"), isMatchingAStar(grid, firstField, query, service.FindRoute(query))))
+			return false;
+	}
+	TestEqual(TEXT("Cache misses of the first pass"), service.GetCacheMisses(), queries.Num());
+	TestEqual(TEXT("Cache hits of the first pass"), service.GetCacheHits(), 0);
+
+	//unchanged levels keep the epoch and its cache, the concurrent callers only hit the cache
+	service.OnIterationFinished(firstField, 2);
+	TestEqual(TEXT("Unchanged levels keep the epoch"), service.GetEpoch(), 1u);
+	TArray<TFuture<ACORouteResult>> futures;
+	futures.SetNum(queries.Num());
+	ParallelFor(queries.Num(), [&](int32 i)
+	{
+		futures[i] = service.QueryRoute(queries[i]);
+	});
+	for (int32 i = 0; i < queries.Num(); ++i)
+	{
+		const ACORouteResult result = futures[i].Get();
+		TestEqual(TEXT("Concurrent result of the first epoch"), result.Epoch, 1u);
+		TestTrue(TEXT("Concurrent route of the first epoch matches A*"), isMatchingAStar(grid, firstField, queries[i], result));
+	}
+	service.WaitForPendingQueries();
+	TestEqual(TEXT("Cache misses after the concurrent pass"), service.GetCacheMisses(), queries.Num());
+	TestEqual(TEXT("Cache hits of the concurrent pass"), service.GetCacheHits(), queries.Num());
+
+	//a new epoch starts with an empty cache
+	service.OnIterationFinished(secondField, 3);
+	TestEqual(TEXT("Changed levels start a new epoch"), service.GetEpoch(), 2u);
+	for (const ACORouteQuery& query : queries)
+		TestTrue(TEXT("Sequential route of the second epoch matches A*"), isMatchingAStar(grid, secondField, query, service.FindRoute(query)));
+	TestEqual(TEXT("Cache misses after the second epoch"), service.GetCacheMisses(), 2 * queries.Num());
+
+	//the third epoch is published while the batches run, every result belongs to one of the epochs
+	const int32 repetitions = 8;
+	futures.Reset();
+	futures.SetNum(queries.Num() * repetitions);
+	TFuture<void> callers = Async<void>(EAsyncExecution::ThreadPool, [&]()
+	{
+		ParallelFor(futures.Num(), [&](int32 i)
+		{
+			futures[i] = service.QueryRoute(queries[i % queries.Num()]);
+		});
+	});
+	service.OnIterationFinished(thirdField, 4);
+	callers.Wait();
+	service.WaitForPendingQueries();
+	TestEqual(TEXT("Third epoch"), service.GetEpoch(), 3u);
+
+	TArray<uint8> isCachedInThirdEpoch;
+	isCachedInThirdEpoch.SetNumZeroed(queries.Num());
+	for (int32 i = 0; i < futures.Num(); ++i)
+	{
+		const ACORouteResult result = futures[i].Get();
+		const ACORouteQuery& query = queries[i % queries.Num()];
+		if (result.Epoch == 3u)
+		{
+			isCachedInThirdEpoch[i % queries.Num()] = 1;
+			TestTrue(TEXT("Concurrent route of the third epoch matches A*"), isMatchingAStar(grid, thirdField, query, result));
+		}
+		else if (!TestEqual(TEXT("Concurrent result of the second or third epoch"), result.Epoch, 2u))
+		{
+			return false;
+		}
+		else
+		{
+			TestTrue(TEXT("Concurrent route of the second epoch matches A*"), isMatchingAStar(grid, secondField, query, result));
+		}
+	}
+
+	//results of the second epoch which finished after the third one started mustn't replace the cached ones
+	int32 expectedMisses = 0;
+	for (uint8 isCached : isCachedInThirdEpoch)
+		expectedMisses += isCached ? 0 : 1;
+	const int32 missesAfterEpochChange = service.GetCacheMisses();
+	for (const ACORouteQuery& query : queries)
+	{
+		const ACORouteResult result = service.FindRoute(query);
+		TestEqual(TEXT("Sequential result of the third epoch"), result.Epoch, 3u);
+		TestTrue(TEXT("Sequential route of the third epoch matches A*"), isMatchingAStar(grid, thirdField, query, result));
+	}
+	TestEqual(TEXT("Only queries without a result of the third epoch miss the cache"), service.GetCacheMisses() - missesAfterEpochChange, expectedMisses);
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
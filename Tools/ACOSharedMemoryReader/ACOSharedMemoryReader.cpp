@@ -0,0 +1,187 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+/**
+ * Reference reader of the shared memory region written by ACOSharedMemoryExport (-ACOSharedMemory=<name>).
+ * Prints the best routes and the strongest cells of every colony, it doesn't need the engine:
+ *
+ * Linux/Mac: g++ -std=c++11 -O2 ACOSharedMemoryReader.cpp -o ACOSharedMemoryReader (-lrt on older glibc)
+ * Windows:   cl /EHsc /O2 ACOSharedMemoryReader.cpp
+ *
+ * ACOSharedMemoryReader <name> [top cells = 5] [milliseconds between two reads = 500]
+ */
+
+#include "../../Source/ACO/ACOSharedMemoryLayout.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/** read only view of the region, the engine names it "/<name>" on posix and "<name>" on windows */
+class SharedMemoryView
+{
+public:
+	~SharedMemoryView()
+	{
+#if defined(_WIN32)
+		if (m_data)
+			UnmapViewOfFile(m_data);
+		if (m_mapping)
+			CloseHandle(m_mapping);
+#else
+		if (m_data)
+			munmap(const_cast<uint8_t*>(m_data), m_size);
+#endif
+	}
+
+	bool Open(const std::string& name)
+	{
+#if defined(_WIN32)
+		m_mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, name.c_str());
+		if (!m_mapping)
+			return false;
+		m_data = static_cast<const uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+		MEMORY_BASIC_INFORMATION info;
+		if (m_data && VirtualQuery(m_data, &info, sizeof(info)))
+			m_size = info.RegionSize;
+#else
+		const int file = shm_open(("/" + name).c_str(), O_RDONLY, 0);
+		if (file < 0)
+			return false;
+		struct stat status;
+		if (fstat(file, &status) == 0 && status.st_size > 0)
+		{
+			m_size = static_cast<size_t>(status.st_size);
+			void* data = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, file, 0);
+			m_data = data != MAP_FAILED ? static_cast<const uint8_t*>(data) : nullptr;
+		}
+		close(file);
+#endif
+		return m_data != nullptr && m_size >= sizeof(ACOSharedMemoryHeader);
+	}
+
+	const uint8_t* GetData() const { return m_data; }
+	size_t GetSize() const { return m_size; }
+
+private:
+	const uint8_t* m_data = nullptr;
+	size_t m_size = 0;
+#if defined(_WIN32)
+	HANDLE m_mapping = nullptr;
+#endif
+};
+
+/** copies the published slot, returns false if no slot is published yet or the writer was too fast for all attempts */
+static bool readPublishedSlot(const uint8_t* base, const ACOSharedMemoryHeader& header, std::vector<uint8_t>& slot)
+{
+	for (int attempt = 0; attempt < 100; ++attempt)
+	{
+		const int32_t slotIndex = header.PublishedSlot;
+		if (slotIndex < 0 || slotIndex > 1)
+			return false;
+		const uint8_t* slotData = base + header.SlotOffsets[slotIndex];
+		const volatile ACOSharedMemorySlot* published = reinterpret_cast<const volatile ACOSharedMemorySlot*>(slotData);
+
+		const uint32_t sequence = published->Sequence;
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (sequence % 2 == 0)
+		{
+			std::memcpy(slot.data(), slotData, slot.size());
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (published->Sequence == sequence)
+				return true;
+		}
+		std::this_thread::yield();
+	}
+	return false;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		std::printf("Usage: %s <name> [top cells = 5] [milliseconds between two reads = 500]\n", argv[0]);
+		return 1;
+	}
+	const int topCells = argc > 2 ? std::max(std::atoi(argv[2]), 0) : 5;
+	const int sleepMilliseconds = argc > 3 ? std::max(std::atoi(argv[3]), 1) : 500;
+
+	SharedMemoryView view;
+	if (!view.Open(argv[1]))
+	{
+		std::printf("Couldn't open the shared memory region %s, is the simulation running with -ACOSharedMemory=%s?\n", argv[1], argv[1]);
+		return 1;
+	}
+
+	const uint8_t* base = view.GetData();
+	const ACOSharedMemoryHeader& header = *reinterpret_cast<const ACOSharedMemoryHeader*>(base);
+	while (header.Magic != ACOSharedMemoryHeader::MagicValue)
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (header.Version != ACOSharedMemoryHeader::VersionValue || header.SlotOffsets[1] + header.SlotSize > view.GetSize())
+	{
+		std::printf("Unsupported region version %u or size!\n", header.Version);
+		return 1;
+	}
+	std::printf("%d cells (%d x %d), %d channels, %d colonies\n", header.Cells, header.SizeX, header.SizeY, header.Channels, header.Colonies);
+
+	const ACOSharedMemoryCoordinate* coordinates = reinterpret_cast<const ACOSharedMemoryCoordinate*>(base + header.CoordinatesOffset);
+	std::vector<uint8_t> slot(static_cast<size_t>(header.SlotSize));
+	int32_t previousIteration = -1;
+	while (!header.IsClosed)
+	{
+		if (readPublishedSlot(base, header, slot))
+		{
+			const ACOSharedMemorySlot& slotHeader = *reinterpret_cast<const ACOSharedMemorySlot*>(slot.data());
+			const float* pheromoneLevels = reinterpret_cast<const float*>(slot.data() + sizeof(ACOSharedMemorySlot));
+			const uint8_t* colonyData = reinterpret_cast<const uint8_t*>(pheromoneLevels + static_cast<size_t>(header.Cells) * header.Channels);
+
+			if (slotHeader.Iteration != previousIteration)
+			{
+				previousIteration = slotHeader.Iteration;
+				std::printf("Iteration %d\n", slotHeader.Iteration);
+				for (int32_t channel = 0; channel < header.Colonies; ++channel)
+				{
+					const ACOSharedMemoryColony& colony = *reinterpret_cast<const ACOSharedMemoryColony*>(colonyData);
+					const int32_t* route = reinterpret_cast<const int32_t*>(colonyData + sizeof(ACOSharedMemoryColony));
+					colonyData += sizeof(ACOSharedMemoryColony) + static_cast<size_t>(header.MaxRouteLength) * sizeof(int32_t);
+
+					std::printf("  colony %d: best trip %g, iteration best %g, route of %d cells", channel, colony.BestTripCost, colony.IterationBestTripCost, colony.RouteLength);
+					if (colony.RouteLength > 0)
+					{
+						const ACOSharedMemoryCoordinate& last = coordinates[route[colony.RouteLength - 1]];
+						std::printf(" from (%d, %d) to (%d, %d)", coordinates[colony.Anthill].X, coordinates[colony.Anthill].Y, last.X, last.Y);
+					}
+					std::printf("\n");
+
+					std::vector<std::pair<float, int32_t>> levels(header.Cells);
+					for (int32_t cell = 0; cell < header.Cells; ++cell)
+						levels[cell] = std::make_pair(pheromoneLevels[static_cast<size_t>(cell) * header.Channels + channel], cell);
+					const int32_t amount = std::min<int32_t>(topCells, header.Cells);
+					std::partial_sort(levels.begin(), levels.begin() + amount, levels.end(), [](const std::pair<float, int32_t>& a, const std::pair<float, int32_t>& b) { return a.first > b.first; });
+					for (int32_t i = 0; i < amount; ++i)
+						std::printf("    (%d, %d) %g\n", coordinates[levels[i].second].X, coordinates[levels[i].second].Y, levels[i].first);
+				}
+			}
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(sleepMilliseconds));
+	}
+	std::printf("The simulation closed the region.\n");
+	return 0;
+}